@@ -0,0 +1,326 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file cdp_router_bench.cc
+ * 
+ * @brief Checks CdpRouter's frame header scanner and measures routing a recording of CDP traffic with it, 
+ * against parsing every frame in full.
+ * 
+ * Usage: cdp_router_bench [recording.jsonl] [passes]
+ * The recording holds one frame per line, as written with `MILLENNIUM__RECORD_CDP_PATH` (see CdpRouter).
+ * Exits with a non-zero status if a check fails.
+ */
+#include "cdp_router.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+static int g_failedChecks = 0;
+
+#define CHECK(condition)                                                          \
+    do                                                                            \
+    {                                                                             \
+        if (!(condition))                                                         \
+        {                                                                         \
+            std::fprintf(stderr, "check failed, line %d: %s\n", __LINE__, #condition); \
+            g_failedChecks++;                                                     \
+        }                                                                         \
+    } while (false)
+
+static bool Scan(std::string_view payload, CdpRouter::FrameHeader& header)
+{
+    header = {};
+    return CdpRouter::ScanFrameHeader(payload, header);
+}
+
+/**
+ * The scanner either reads the same routing fields a full parse finds, or gives up so the frame is parsed in full.
+ */
+static void CheckScanner()
+{
+    CdpRouter::FrameHeader header;
+
+    /** Escaped quotes and backslashes inside values that are skipped over. */
+    CHECK(Scan(R"({"method":"Log.entryAdded","params":{"entry":{"text":"say \"}\" and \\"}},"sessionId":"S1"})", header));
+    CHECK(header.method == "Log.entryAdded" && header.sessionId == "S1" && !header.id);
+    CHECK(Scan(R"({"params":{"text":"\\\\\"],{"},"method":"X"})", header) && header.method == "X");
+    CHECK(Scan(R"({"id":-42,"result":{"body":"x\"}"}})", header) && header.id == -42);
+
+    /** Nested objects and arrays, with brackets inside strings, before the session id. */
+    CHECK(Scan(R"( {"method":"Fetch.requestPaused","params":{"a":[1,{"b":"}\\\"]"},[[]],{}],"c":true,"d":null,"e":-1.5e3},"sessionId":"S2"} )", header));
+    CHECK(header.method == "Fetch.requestPaused" && header.sessionId == "S2");
+    CHECK(Scan(R"({"params":null,"method":"X"})", header) && header.method == "X" && header.sessionId.empty());
+    CHECK(Scan(R"({ "method" : "X" , "sessionId" : "S3" })", header) && header.method == "X" && header.sessionId == "S3");
+    CHECK(Scan(R"({})", header) && !header.id && header.method.empty());
+
+    /** Ids are plain integers, anything else is left to the full parse. */
+    CHECK(Scan(R"({"id":0,"result":{}})", header) && header.id == 0);
+    CHECK(Scan(R"({"id":999999999999999999})", header) && header.id == 999999999999999999LL);
+    CHECK(!Scan(R"({"id":1.5})", header));
+    CHECK(!Scan(R"({"id":1e3})", header));
+    CHECK(!Scan(R"({"id":"7"})", header));
+    CHECK(!Scan(R"({"id":true})", header));
+    CHECK(!Scan(R"({"id":-})", header));
+    CHECK(!Scan(R"({"id":1234567890123456789})", header));
+
+    /** Frames the scanner doesn't read. */
+    CHECK(!Scan(R"([1,2])", header));
+    CHECK(!Scan(R"({"method":"X)", header));
+    CHECK(!Scan(R"({"method":"A\u0042"})", header));
+    CHECK(!Scan(R"({"method":7})", header));
+    CHECK(!Scan(R"({"params":{"a":[1,2})", header));
+    CHECK(!Scan(R"({"method":"X" "sessionId":"S"})", header));
+    CHECK(!Scan("", header));
+
+    /** Stopping at the method leaves the rest of the event unread, a session id after it included. */
+    header = {};
+    CHECK(CdpRouter::ScanFrameHeader(R"({"method":"X","params":{"a":[1,2},"sessionId":"S"})", header, true));
+    CHECK(header.method == "X" && header.sessionId.empty());
+    header = {};
+    CHECK(CdpRouter::ScanFrameHeader(R"({"sessionId":"S","method":"X","params":{}})", header, true));
+    CHECK(header.method == "X" && header.sessionId == "S");
+    header = {};
+    CHECK(CdpRouter::ScanFrameHeader(R"({"id":3,"result":{}})", header, true) && header.id == 3);
+}
+
+/**
+ * Subscribers narrowed to a session only get the events of that session, its id follows the event's params.
+ */
+static void CheckSessionFilter()
+{
+    CdpRouter& router = CdpRouter::get();
+    int sessionEvents = 0, allEvents = 0;
+
+    const auto sessionSubscription = router.Subscribe("Bench.session", [&](const nlohmann::json&) { sessionEvents++; }, "S1");
+    const auto allSubscription = router.Subscribe("Bench.session", [&](const nlohmann::json&) { allEvents++; });
+
+    router.RouteFrame(R"({"method":"Bench.session","params":{"sessionId":"S1"},"sessionId":"S2"})");
+    router.RouteFrame(R"({"method":"Bench.session","params":{"x":"\"sessionId\":\"S2\""},"sessionId":"S1"})");
+    router.RouteFrame(R"({"method":"Bench.session","params":{}})");
+
+    CHECK(sessionEvents == 1);
+    CHECK(allEvents == 3);
+
+    router.Unsubscribe(sessionSubscription);
+    router.Unsubscribe(allSubscription);
+}
+
+/**
+ * Frames the scanner gives up on still reach their handlers, through the full parse.
+ */
+static void CheckFallback()
+{
+    CdpRouter& router = CdpRouter::get();
+    const unsigned long long fallbacksBefore = router.GetMetrics()["scanFallbacks"].get<unsigned long long>();
+
+    int escapedMethodEvents = 0, floatIdReplies = 0;
+    const auto eventSubscription = router.Subscribe("Bench.escaped", [&](const nlohmann::json&) { escapedMethodEvents++; });
+    const auto replySubscription = router.RouteReplies(LLONG_MIN, LLONG_MAX, [&](const nlohmann::json&) { floatIdReplies++; });
+
+    router.RouteFrame(R"({"method":"Bench\u002eescaped","params":{}})");
+    router.RouteFrame(R"({"id":2.5,"result":{}})");
+
+    CHECK(escapedMethodEvents == 1);
+    /** A non-integer id matches no call, like in Route. */
+    CHECK(floatIdReplies == 0);
+    CHECK(router.GetMetrics()["scanFallbacks"].get<unsigned long long>() == fallbacksBefore + 2);
+
+    bool threw = false;
+    try
+    {
+        router.RouteFrame(R"({"method":"Bench.escaped","params":{)");
+    }
+    catch (const nlohmann::json::parse_error&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+
+    router.Unsubscribe(eventSubscription);
+    router.Unsubscribe(replySubscription);
+}
+
+/**
+ * Every frame of the recording scans to the same routing fields a full parse reads.
+ */
+static void CheckRecording(const std::vector<std::string>& frames)
+{
+    for (const auto& frame : frames)
+    {
+        CdpRouter::FrameHeader header, methodHeader;
+        const nlohmann::json message = nlohmann::json::parse(frame);
+
+        if (!Scan(frame, header))
+        {
+            continue;
+        }
+
+        CHECK(CdpRouter::ScanFrameHeader(frame, methodHeader, true));
+        CHECK(methodHeader.id == header.id && methodHeader.method == header.method);
+
+        const auto id = message.find("id");
+        CHECK(header.id.has_value() == (id != message.end() && id->is_number_integer()));
+
+        if (header.id.has_value())
+        {
+            CHECK(header.id.value() == id->get<long long>());
+            continue;
+        }
+
+        CHECK(header.method == message.value("method", std::string()));
+        CHECK(header.sessionId == message.value("sessionId", std::string()));
+    }
+}
+
+/**
+ * Runs the function once to warm up, then reports the median time of the given number of passes.
+ */
+template <typename Function>
+static double MeasureMs(int passes, Function&& function)
+{
+    std::vector<double> passTimes;
+    function();
+
+    for (int pass = 0; pass < passes; pass++)
+    {
+        const auto startedAt = std::chrono::steady_clock::now();
+        function();
+        passTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startedAt).count());
+    }
+
+    std::nth_element(passTimes.begin(), passTimes.begin() + passTimes.size() / 2, passTimes.end());
+    return passTimes[passTimes.size() / 2];
+}
+
+int main(int argc, char** argv)
+{
+    const std::string recordingPath = argc > 1 ? argv[1] : MILLENNIUM_BENCHMARK_FIXTURES "/cdp_traffic.jsonl";
+    const int passes = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+    std::ifstream recording(recordingPath, std::ios::binary);
+    std::vector<std::string> frames;
+    size_t recordingBytes = 0;
+
+    for (std::string line; std::getline(recording, line); )
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        recordingBytes += line.size();
+        frames.push_back(std::move(line));
+    }
+
+    if (frames.empty())
+    {
+        std::fprintf(stderr, "no frames in '%s'\n", recordingPath.c_str());
+        return 1;
+    }
+
+    CheckScanner();
+    CheckFallback();
+    CheckSessionFilter();
+    CheckRecording(frames);
+
+    if (g_failedChecks)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failedChecks);
+        return 1;
+    }
+
+    /** Subscribed like Millennium is: paused requests, body replies to HttpHookManager and a few pending calls. */
+    CdpRouter& router = CdpRouter::get();
+    unsigned long long deliveredBytes = 0;
+
+    router.Subscribe("Fetch.requestPaused", [&](const nlohmann::json& message) { deliveredBytes += message.size(); });
+    router.RouteReplies(LLONG_MIN, -1, [&](const nlohmann::json& message) { deliveredBytes += message.size(); });
+
+    std::vector<long long> pendingCallIds;
+    for (const auto& frame : frames)
+    {
+        CdpRouter::FrameHeader header;
+        if (Scan(frame, header) && header.id.value_or(0) > 0) pendingCallIds.push_back(header.id.value());
+    }
+
+    const auto expectPendingCalls = [&]()
+    {
+        for (const long long callId : pendingCallIds)
+        {
+            router.ExpectReply(callId, [&](const nlohmann::json& message) { deliveredBytes += message.size(); });
+        }
+    };
+
+    /** Frames no handler wants, the ones the scan lets routing skip. */
+    std::vector<std::string> unwantedFrames;
+    size_t unwantedBytes = 0;
+
+    for (const auto& frame : frames)
+    {
+        CdpRouter::FrameHeader header;
+        Scan(frame, header);
+
+        if (header.method != "Fetch.requestPaused" && header.id.value_or(0) == 0)
+        {
+            unwantedBytes += frame.size();
+            unwantedFrames.push_back(frame);
+        }
+    }
+
+    const double fullParseMs = MeasureMs(passes, [&]() { 
+        expectPendingCalls(); 
+        for (const auto& frame : frames) router.Route(nlohmann::json::parse(frame)); 
+    });
+    const double scanMs = MeasureMs(passes, [&]() { 
+        expectPendingCalls(); 
+        for (const auto& frame : frames) router.RouteFrame(frame); 
+    });
+    const double unwantedFullParseMs = MeasureMs(passes, [&]() { 
+        for (const auto& frame : unwantedFrames) router.Route(nlohmann::json::parse(frame)); 
+    });
+    const double unwantedScanMs = MeasureMs(passes, [&]() { 
+        for (const auto& frame : unwantedFrames) router.RouteFrame(frame); 
+    });
+    const double scanOnlyMs = MeasureMs(passes, [&]() { 
+        CdpRouter::FrameHeader header;
+        for (const auto& frame : frames) deliveredBytes += Scan(frame, header);
+    });
+
+    std::printf("recording: %s, %zu frames, %.2f MiB, median of %d passes\n", recordingPath.c_str(), frames.size(), recordingBytes / 1048576.0, passes);
+    std::printf("all frames:      full parse %8.2f ms, scan + lazy parse %8.2f ms\n", fullParseMs, scanMs);
+    std::printf("unwanted frames: full parse %8.2f ms, scan              %8.2f ms (%zu frames, %.2f MiB)\n", unwantedFullParseMs, unwantedScanMs, unwantedFrames.size(), unwantedBytes / 1048576.0);
+    std::printf("header scan only: %.2f ms\n", scanOnlyMs);
+    std::printf("router: %s (delivered %llu)\n", router.GetMetrics().dump().c_str(), deliveredBytes);
+    return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file html_injector_bench.cc
+ * 
+ * @brief Checks HtmlHeadInjector against the decode/replace/encode path it replaced, and measures both on a 
+ * store-page sized document.
+ * 
+ * Usage: html_injector_bench [document size in KiB] [passes]
+ * Exits with a non-zero status if a check fails.
+ */
+#include "html_injector.h"
+#include "encoding.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+static int g_failedChecks = 0;
+static size_t g_allocations = 0;
+static size_t g_allocatedBytes = 0;
+
+#define CHECK(condition)                                                          \
+    do                                                                            \
+    {                                                                             \
+        if (!(condition))                                                         \
+        {                                                                         \
+            std::fprintf(stderr, "check failed, line %d: %s\n", __LINE__, #condition); \
+            g_failedChecks++;                                                     \
+        }                                                                         \
+    } while (false)
+
+/** Counts every allocation, so the passes can report how much each path copies. */
+void* operator new(size_t size)
+{
+    g_allocations++;
+    g_allocatedBytes += size;
+
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+
+/**
+ * How documents were patched before HtmlHeadInjector: decode, copy, find and replace the plain `<head>` tag, encode.
+ */
+static std::string InjectByReplace(const std::string& base64Body, const std::string& content)
+{
+    std::string original = Base64Decode(base64Body);
+    std::string patched = original;
+
+    if (patched.find("<head>") == std::string::npos)
+    {
+        return Base64Encode(patched);
+    }
+
+    patched = patched.replace(patched.find("<head>"), 6, "<head>" + content);
+    return Base64Encode(patched);
+}
+
+/**
+ * Feeds the body in chunks of the given size, or in one write if it's zero.
+ */
+static std::string InjectSinglePass(std::string_view base64Body, const std::string& content, size_t chunkSize = 0)
+{
+    HtmlHeadInjector injector(content);
+    injector.Reserve(base64Body.size() / 4 * 3);
+
+    if (chunkSize == 0)
+    {
+        injector.WriteBase64(base64Body);
+    }
+    else for (size_t offset = 0; offset < base64Body.size(); offset += chunkSize)
+    {
+        injector.WriteBase64(base64Body.substr(offset, chunkSize));
+    }
+
+    return injector.Finish();
+}
+
+/**
+ * The head tag is found however the document is split across writes, matched case-insensitively with attributes, 
+ * and documents without one come back unchanged.
+ */
+static void CheckInjector()
+{
+    const std::string content = "<script>x</script>";
+    const std::pair<std::string, std::string> documents[] = {
+        { "<html><head>a</head>",       "<html><head><script>x</script>a</head>" },
+        { "<HTML><HEAD lang=\"x>y\">b", "<HTML><HEAD lang=\"x>y\"><script>x</script>b" },
+        { "<header></header><head>",    "<header></header><head><script>x</script>" },
+        { "<<head>",                    "<<head><script>x</script>" },
+        { "<hea<head>",                 "<hea<head><script>x</script>" },
+        { "x<head/>",                   "x<head/><script>x</script>" },
+        { "no head here",               "no head here" },
+        { "<head",                      "<head" },
+        { "",                           "" },
+    };
+
+    for (const auto& [document, expected] : documents)
+    {
+        for (const size_t chunkSize : { 0, 1, 2, 3, 5, 7 })
+        {
+            CHECK(Base64Decode(InjectSinglePass(Base64Encode(document), content, chunkSize)) == expected);
+        }
+
+        HtmlHeadInjector plainInjector(content);
+        plainInjector.Write(document);
+        CHECK(plainInjector.Finish() == Base64Encode(expected));
+    }
+
+    /** Arbitrary bytes of every padding length round trip unchanged. */
+    std::mt19937 random(1);
+    for (int length = 0; length < 64; length++)
+    {
+        std::string bytes;
+        for (int i = 0; i < length; i++) bytes.push_back(static_cast<char>(random()));
+
+        if (bytes.find("<head>") != std::string::npos) continue;
+        CHECK(InjectSinglePass(Base64Encode(bytes), "") == Base64Encode(bytes));
+    }
+}
+
+struct PassResult
+{
+    double milliseconds;
+    double allocations;
+    double allocatedMiB;
+};
+
+/**
+ * Runs the function once to warm up, then reports the median time and the allocations of one pass.
+ */
+template <typename Function>
+static PassResult Measure(int passes, Function&& function)
+{
+    std::vector<double> passTimes;
+    passTimes.reserve(passes);
+    function();
+
+    const size_t allocationsBefore = g_allocations, bytesBefore = g_allocatedBytes;
+    for (int pass = 0; pass < passes; pass++)
+    {
+        const auto startedAt = std::chrono::steady_clock::now();
+        function();
+        passTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startedAt).count());
+    }
+
+    std::nth_element(passTimes.begin(), passTimes.begin() + passTimes.size() / 2, passTimes.end());
+    return { passTimes[passTimes.size() / 2], double(g_allocations - allocationsBefore) / passes, double(g_allocatedBytes - bytesBefore) / passes / 1048576.0 };
+}
+
+int main(int argc, char** argv)
+{
+    const size_t documentSize = (argc > 1 ? std::max(1, std::atoi(argv[1])) : 1500) * size_t(1024);
+    const int passes = argc > 2 ? std::max(1, std::atoi(argv[2])) : 50;
+
+    CheckInjector();
+
+    /** A store page: the head near the top, followed by a large body, with a shim about the size Millennium injects. */
+    std::string document = "<!DOCTYPE html><html><head><meta charset=utf-8>";
+    while (document.size() < documentSize)
+    {
+        document += "<div class=\"store_row\"><a href=\"https://store.steampowered.com/app/12345\">Some game title</a></div>\n";
+    }
+
+    const std::string base64Body = Base64Encode(document);
+    const std::string shim(3000, 'x');
+
+    CHECK(InjectSinglePass(base64Body, shim) == InjectByReplace(base64Body, shim));
+
+    if (g_failedChecks)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failedChecks);
+        return 1;
+    }
+
+    size_t outputBytes = 0;
+    const PassResult replaceResult = Measure(passes, [&]() { outputBytes += InjectByReplace(base64Body, shim).size(); });
+    const PassResult singlePassResult = Measure(passes, [&]() { outputBytes += InjectSinglePass(base64Body, shim).size(); });
+
+    std::printf("document: %.2f MiB, %zu byte shim, median of %d passes\n", document.size() / 1048576.0, shim.size(), passes);
+    std::printf("decode/replace/encode: %8.2f ms, %6.1f allocations, %7.2f MiB allocated\n", replaceResult.milliseconds, replaceResult.allocations, replaceResult.allocatedMiB);
+    std::printf("single pass:           %8.2f ms, %6.1f allocations, %7.2f MiB allocated\n", singlePassResult.milliseconds, singlePassResult.allocations, singlePassResult.allocatedMiB);
+    std::printf("(output %zu bytes)\n", outputBytes);
+    return 0;
+}
@@ -0,0 +1,138 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <string>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <future>
+#include <optional>
+#include <functional>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include <nlohmann/json.hpp>
+
+/**
+ * @brief Bounded LRU cache of assets that are ready to be sent in a `Fetch.fulfillRequest`.
+ * 
+ * Entries are keyed by their path and validated against the file size and last write time. 
+ * When the containing directory is watched by the FileWatcher, entries are evicted on change 
+ * instead of being validated on every lookup. Concurrent lookups of the same uncached file 
+ * share a single read of the file.
+ */
+class AssetCache
+{
+public:
+    struct Asset {
+        std::string body;        /** The base64 encoded file contents. */
+        nlohmann::json headers;  /** The response headers, as a `Fetch.fulfillRequest` header array. */
+        std::string contentHash; /** Fingerprint of the file contents, see hash.h */
+        std::uintmax_t fileSize = 0;
+        std::filesystem::file_time_type lastWriteTime;
+    };
+
+    struct Stats {
+        unsigned long long hits;
+        unsigned long long misses;
+        unsigned long long coalesced;
+        unsigned long long evictions;
+        unsigned long long invalidations;
+        size_t entries;
+        size_t bytes;
+    };
+
+    using AssetLoader = std::function<std::shared_ptr<Asset>(const std::filesystem::path& filePath)>;
+
+    static AssetCache& get();
+
+    /**
+     * @brief Get a cached asset, or load and cache it with the given loader.
+     * @return The asset, or nullptr if the loader failed.
+     */
+    std::shared_ptr<const Asset> Get(const std::filesystem::path& filePath, const AssetLoader& loader);
+
+    /**
+     * @brief Get the content hash of an asset, loading it if needed.
+     * The hash describes the file as of this call, entries of unwatched directories are checked against the file's 
+     * size and last write time on lookup. A later change is noticed by the watcher, or by the next lookup of the file.
+     */
+    std::optional<std::string> GetContentHash(const std::filesystem::path& filePath, const AssetLoader& loader);
+
+    /**
+     * @brief Get a counter that is bumped every time a cached file changes.
+     */
+    unsigned long long GetInvalidationEpoch() const;
+
+    void Invalidate(const std::filesystem::path& filePath);
+
+    /**
+     * @brief Never watch the directory, and don't bump the invalidation epoch when its files change.
+     * For directories of derived files (i.e. compressed variants) that are rewritten while they're served, 
+     * nothing embeds their content hash. Their entries are still checked against the file's size and last write time.
+     */
+    void ExcludeDirectory(const std::filesystem::path& directory);
+
+    Stats GetStats() const;
+
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+
+private:
+    AssetCache() = default;
+
+    static constexpr size_t m_maxCacheBytes = 64 * 1024 * 1024;
+    static constexpr size_t m_maxEntryBytes = 16 * 1024 * 1024;
+    static constexpr unsigned long long m_statsLogInterval = 1024;
+
+    struct CacheEntry {
+        std::shared_ptr<const Asset> asset;
+        std::list<std::string>::iterator lruIterator;
+    };
+
+    void InsertLocked(const std::string& key, std::shared_ptr<const Asset> asset);
+    void EvictLocked(std::unordered_map<std::string, CacheEntry>::iterator entryIterator);
+    bool WatchDirectoryLocked(const std::filesystem::path& directory);
+    void OnFileChanged(const std::filesystem::path& changedPath);
+    void LogStats(unsigned long long lookupCount);
+
+    mutable std::mutex m_cacheMutex;
+    std::list<std::string> m_lruList;
+    std::unordered_map<std::string, CacheEntry> m_entries;
+    std::unordered_map<std::string, std::shared_future<std::shared_ptr<const Asset>>> m_inFlight;
+    std::unordered_map<std::string, bool> m_watchedDirectories;
+    std::unordered_set<std::string> m_excludedDirectories;
+    size_t m_cacheBytes = 0;
+    unsigned long long m_invalidationEpoch = 0;
+
+    std::atomic<unsigned long long> m_lookups{0}, m_hits{0}, m_misses{0}, m_coalesced{0}, m_evictions{0}, m_invalidations{0};
+};
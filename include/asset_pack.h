@@ -0,0 +1,147 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <string>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <filesystem>
+#include <unordered_map>
+#include <condition_variable>
+#include "asset_cache.h"
+
+class MappedFile;
+
+/**
+ * @brief A read-only, memory mapped pack of the assets below one directory.
+ * 
+ * Every file is stored as it is sent in a `Fetch.fulfillRequest` (base64 encoded) next to an index of 
+ * path -> offset, length, content hash, size, write time and precomputed response headers. Assets are copied 
+ * straight out of the mapping, there's no per file open, read, encode or file type evaluation.
+ * 
+ * Layout: the "MLNMPACK" magic, the u64 offset and length of the index, the bodies, then the JSON index.
+ */
+class AssetPack
+{
+public:
+    ~AssetPack();
+
+    /**
+     * @brief Map a pack file.
+     * @return The pack, or nullptr if it's missing or malformed.
+     */
+    static std::shared_ptr<const AssetPack> Open(const std::filesystem::path& packPath);
+
+    /**
+     * @brief Write a pack of the given files, loaded with the given loader. Files that fail to load are left out.
+     */
+    static bool Write(const std::filesystem::path& packPath, const std::vector<std::filesystem::path>& files, const AssetCache::AssetLoader& loader);
+
+    /**
+     * @brief Get a packed asset, as long as the file on disk still matches what was packed.
+     * @return The asset, or nullptr if the file isn't packed or changed since.
+     */
+    std::shared_ptr<AssetCache::Asset> Find(const std::filesystem::path& filePath) const;
+
+    size_t EntryCount() const;
+
+private:
+    AssetPack() = default;
+
+    struct Entry {
+        std::uint64_t offset;
+        std::uint64_t length;
+        std::string contentHash;
+        nlohmann::json headers;
+        std::uintmax_t fileSize;
+        std::filesystem::file_time_type lastWriteTime;
+    };
+
+    std::unique_ptr<MappedFile> m_mapping;
+    std::unordered_map<std::string, Entry> m_entries;
+};
+
+/**
+ * @brief Builds and mounts the asset packs of plugins and themes.
+ * 
+ * Packs are built in the background when a directory is mounted (i.e. a plugin is enabled) and named after the 
+ * file list, sizes and write times of the directory, so an unchanged directory maps its existing pack. A lookup 
+ * of a file that changed since falls back to the loose file and rebuilds the pack, so the loose layout always 
+ * works and stays authoritative.
+ */
+class AssetPackManager
+{
+public:
+    static AssetPackManager& get();
+
+    /**
+     * @brief Build (or reuse) and map the pack of a directory. Files are packed with the given loader.
+     */
+    void Mount(const std::filesystem::path& rootDirectory, AssetCache::AssetLoader loader);
+
+    /**
+     * @brief Get an asset from the pack of the directory it's in.
+     * @return The asset, or nullptr if it has to be read from disk.
+     */
+    std::shared_ptr<AssetCache::Asset> Find(const std::filesystem::path& filePath);
+
+    AssetPackManager(const AssetPackManager&) = delete;
+    AssetPackManager& operator=(const AssetPackManager&) = delete;
+
+private:
+    AssetPackManager();
+    ~AssetPackManager();
+
+    struct MountedRoot {
+        AssetCache::AssetLoader loader;
+        std::shared_ptr<const AssetPack> pack;
+        bool isQueued = false;
+    };
+
+    void Enqueue(const std::string& rootKey, std::chrono::steady_clock::time_point notBefore);
+    void WorkerThread();
+    void BuildPack(const std::string& rootKey, const AssetCache::AssetLoader& loader);
+
+    /** Packs are limited to assets that are served whole, large media is still streamed from disk in ranges. */
+    static constexpr std::uintmax_t m_maxPackedFileSize = 8 * 1024 * 1024;
+    /** Changed files are usually saved in bursts, rebuilds wait for the directory to settle. */
+    static constexpr std::chrono::seconds m_rebuildDelay{2};
+
+    std::mutex m_mountMutex;
+    std::condition_variable m_queueCondition;
+    std::unordered_map<std::string, MountedRoot> m_mountedRoots;
+    std::deque<std::pair<std::string, std::chrono::steady_clock::time_point>> m_queue;
+    std::filesystem::path m_packDirectory;
+    std::thread m_workerThread;
+    bool m_stop = false;
+};
@@ -0,0 +1,95 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <filesystem>
+#include <unordered_set>
+#include <condition_variable>
+
+/**
+ * @brief Prepares gzip compressed variants of text assets in `<config>/compressed`.
+ * 
+ * Variants are written in the background when a hooked asset is registered, or when an asset is served 
+ * without an up to date variant. A variant is stamped with the last write time of the file it was made 
+ * from, so it's stale as soon as the original changes and identity encoding is used until it's rebuilt. 
+ * Nothing is written to plugin or theme folders, those are watched and a write there would invalidate the asset cache. 
+ * The variant directory itself is excluded from the cache's invalidation, see AssetCache::ExcludeDirectory.
+ * 
+ * @note Off by default (`precompressed_assets`). That Chromium decodes a `Content-Encoding: gzip` body handed to 
+ * `Fetch.fulfillRequest` hasn't been verified against Steam's CEF yet.
+ */
+class AssetPrecompressor
+{
+public:
+    static AssetPrecompressor& get();
+
+    /** Files smaller than this aren't worth the extra round of decompression. */
+    static constexpr std::uintmax_t m_minimumFileSize = 1024;
+
+    /**
+     * @brief Queue a file to have its compressed variant (re)built if it's missing or stale.
+     */
+    void Enqueue(const std::filesystem::path& filePath);
+
+    /**
+     * @brief Check if the file is a text asset that is worth compressing.
+     */
+    static bool IsCompressible(const std::filesystem::path& filePath);
+
+    /**
+     * @brief Get the path of a file's variant, named after a hash of the file's path (i.e. `<hash>-index.js.gz`).
+     */
+    std::filesystem::path VariantPath(const std::filesystem::path& filePath) const;
+
+    AssetPrecompressor(const AssetPrecompressor&) = delete;
+    AssetPrecompressor& operator=(const AssetPrecompressor&) = delete;
+
+private:
+    AssetPrecompressor();
+    ~AssetPrecompressor();
+
+    void WorkerThread();
+    bool CompressFile(const std::filesystem::path& filePath);
+
+    const std::filesystem::path m_variantDirectory;
+
+    std::mutex m_queueMutex;
+    std::condition_variable m_queueCondition;
+    std::deque<std::filesystem::path> m_queue;
+    std::unordered_set<std::string> m_queued;
+    /** Files that won't get a variant (too small, incompressible or read-only), keyed with their last write time. */
+    std::unordered_set<std::string> m_failed;
+    bool m_stop = false;
+    std::thread m_workerThread;
+};
@@ -48,6 +48,7 @@
 #include <cstdio>
 #endif
 #include "cmd.h"
+#include "debugger_discovery.h"
 
 
 static bool bHasCheckedConnection = false;
@@ -69,11 +70,6 @@ private:
         return 8080;
     }
 
-    const std::string GetDebuggerUrl()
-    {
-        return fmt::format("http://localhost:{}", debuggerPort);
-    }
-
     struct SteamConnectionProps
     {
         bool hasConnection;
@@ -195,14 +191,20 @@ public:
      * @brief Get the Steam browser context.
      * It can locally be accessed at localhost:%PORT%/json/version
      * 
-     * @return std::string The Steam browser context.
+     * @return std::string The Steam browser context, empty if the debugger didn't come up in time.
      */
     const std::string GetSteamBrowserContext()
     {
+        const std::optional<std::string> versionInfo = DebuggerDiscovery::get().WaitForDebugger(debuggerPort);
+
+        if (!versionInfo.has_value())
+        {
+            return {};
+        }
+
         try
         {
-            std::string browserUrl = fmt::format("{}/json/version", this->GetDebuggerUrl());
-            nlohmann::basic_json<> instance = nlohmann::json::parse(Http::Get(browserUrl.c_str()));
+            nlohmann::basic_json<> instance = nlohmann::json::parse(versionInfo.value());
 
             return instance["webSocketDebuggerUrl"];
         }
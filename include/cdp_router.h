@@ -0,0 +1,194 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+/**
+ * @brief Routes the messages of the browser's CDP connection to the code that's waiting for them.
+ * 
+ * Replies are matched to their call by id through a table of pending calls, each reply reaches exactly one 
+ * handler, once. Events go to the subscribers of their method, optionally narrowed to one session. Messages 
+ * nobody asked for are dropped without visiting any handler.
+ * 
+ * Frames are routed on their `id`, `method` and `sessionId` alone, read by a scan of the raw payload. The frame 
+ * is only parsed if a handler wants it, Console and Debugger traffic or replies nobody waits for are dropped unparsed.
+ * 
+ * Subscriptions are copy-on-write, routing never locks and handlers may subscribe or unsubscribe from within 
+ * a handler. An unsubscribed handler may still see a message that was already being routed.
+ * 
+ * Setting `MILLENNIUM__RECORD_CDP_PATH` appends every received frame to that file, one per line, which is the 
+ * fixture format of benchmarks/cdp_router_bench.cc. Recordings contain everything the browser sent, including 
+ * page contents.
+ */
+class CdpRouter
+{
+public:
+    using Handler = std::function<void(const nlohmann::json& message)>;
+    using SubscriptionId = unsigned long long;
+
+    static CdpRouter& get();
+
+    /**
+     * @brief Get an id for a call, unique for the lifetime of the process.
+     * Negative ids are reserved for HttpHookManager, see RouteReplies.
+     */
+    long long NextCallId();
+
+    /**
+     * @brief Route the reply to the call with the given id to handler.
+     * @note Register before the call is sent, the reply may arrive before PostGlobal returns.
+     */
+    void ExpectReply(long long callId, Handler handler);
+
+    /**
+     * @brief Forget a pending call, i.e. one that couldn't be sent.
+     */
+    void CancelReply(long long callId);
+
+    /**
+     * @brief Route the replies to every call with an id in [firstId, lastId] to handler, for callers that keep their own table.
+     */
+    SubscriptionId RouteReplies(long long firstId, long long lastId, Handler handler);
+
+    /**
+     * @brief Deliver the events of the given method to handler.
+     * @param sessionId - Only events of this session, or every session if empty.
+     */
+    SubscriptionId Subscribe(const std::string& method, Handler handler, const std::string& sessionId = {});
+
+    void Unsubscribe(SubscriptionId subscriptionId);
+
+    /**
+     * @brief Deliver a frame received from the browser, it's parsed only if a handler wants it.
+     * @throws nlohmann::json::parse_error - If the frame is wanted but isn't valid JSON.
+     */
+    void RouteFrame(std::string_view payload);
+
+    /**
+     * @brief Deliver a message that was already parsed.
+     */
+    void Route(const nlohmann::json& message);
+
+    /** The routing fields of a frame, views into its payload. */
+    struct FrameHeader {
+        std::optional<long long> id;
+        std::string_view method;
+        std::string_view sessionId;
+    };
+
+    /**
+     * @brief Read the routing fields of a frame without parsing it. Scanning stops at the `id` of a reply, 
+     * the values of other top level keys are skipped over.
+     * @param stopAtMethod - Also stop at the `method` of an event. Its `sessionId` is then only read if it comes 
+     * first, the browser sends it after the event's params.
+     * @return false if the frame isn't a JSON object the scanner can read, it should be parsed in full instead.
+     */
+    static bool ScanFrameHeader(std::string_view payload, FrameHeader& header, bool stopAtMethod = false);
+
+    /**
+     * @brief Fail every pending call, their replies will never arrive on a new connection. 
+     * Each handler is called with an `error` reply, see IsConnectionLost.
+     * @return The number of calls dropped.
+     */
+    size_t ClearPendingReplies();
+
+    /**
+     * @brief Check if a reply is the error ClearPendingReplies answers dropped calls with.
+     */
+    static bool IsConnectionLost(const nlohmann::json& reply);
+
+    /**
+     * @brief Get the routed, unmatched and pending message counts as JSON.
+     */
+    nlohmann::json GetMetrics() const;
+
+    CdpRouter(const CdpRouter&) = delete;
+    CdpRouter& operator=(const CdpRouter&) = delete;
+
+private:
+    CdpRouter();
+
+    struct Subscriber {
+        SubscriptionId id;
+        std::string sessionId;
+        Handler handler;
+    };
+
+    struct ReplyRange {
+        SubscriptionId id;
+        long long firstId, lastId;
+        Handler handler;
+    };
+
+    struct Subscriptions {
+        /** Ordered with a transparent comparator, so a scanned method is looked up without copying it. */
+        std::map<std::string, std::vector<Subscriber>, std::less<>> events;
+        std::vector<ReplyRange> replyRanges;
+    };
+
+    std::shared_ptr<const Subscriptions> GetSubscriptions() const;
+    bool IsSessionFiltered(std::string_view method) const;
+    void Invoke(const Handler& handler, const nlohmann::json& message, const char* kind);
+
+    template <typename GetMessage>
+    void Dispatch(const FrameHeader& header, GetMessage&& getMessage);
+
+    /** Only accessed through std::atomic_load/std::atomic_store, routing never locks. */
+    std::shared_ptr<const Subscriptions> m_subscriptions;
+    std::mutex m_subscriptionWriteMutex;
+    SubscriptionId m_nextSubscriptionId = 1;
+
+    mutable std::mutex m_pendingMutex;
+    std::unordered_map<long long, Handler> m_pendingReplies;
+
+    /** The error code of the replies dropped calls get, outside the range the browser uses for its own errors. */
+    static constexpr int m_connectionLostCode = -33000;
+
+    /** Starts well above the fixed ids older callers still use. */
+    std::atomic<long long> m_nextCallId{1000000};
+
+    std::atomic<unsigned long long> m_routedReplies{0}, m_routedEvents{0}, m_unmatchedReplies{0}, m_unmatchedEvents{0}, m_handlerErrors{0};
+    std::atomic<unsigned long long> m_parsedFrames{0}, m_skippedFrames{0}, m_scanFallbacks{0};
+
+    /** Only written by RouteFrame, which is called from the socket thread alone. */
+    std::ofstream m_recording;
+};
@@ -0,0 +1,134 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <optional>
+#include <condition_variable>
+#include <nlohmann/json.hpp>
+#include <websocketpp/config/asio_no_tls_client.hpp>
+#include <websocketpp/client.hpp>
+#include "hook_metrics.h"
+
+/**
+ * @brief The single outbound queue of the browser's CDP connection.
+ * 
+ * Callers on any thread enqueue serialized frames, the frames are written in order by one drain on the 
+ * client's io_context strand, so a burst of fulfills is sent in one pass instead of every caller contending 
+ * for the connection. 
+ * 
+ * The queue is bounded. Callers off the socket thread wait for room (backpressure), callers on the socket thread 
+ * never wait since the drain runs on that same thread, their frames are accepted above the limit instead. 
+ * Frames handed to the connection count towards the bound until the socket wrote them, so a slow socket 
+ * pushes back on callers rather than growing the connection's write buffer. The write buffer is only read on the 
+ * strand, other threads see the snapshot it leaves in m_bufferedBytes.
+ */
+class CdpSendQueue
+{
+public:
+    using Client = websocketpp::client<websocketpp::config::asio_client>;
+
+    static CdpSendQueue& get();
+
+    /**
+     * @brief Start sending on the given connection.
+     * @note Must be called from the client's io thread, i.e. in its open handler.
+     */
+    void Attach(Client* client, websocketpp::connection_hdl handle);
+
+    /**
+     * @brief Stop sending, queued frames are dropped and waiting callers are released.
+     */
+    void Detach();
+
+    /**
+     * @brief Queue a frame to be sent.
+     * @return false if there's no connection, or the queue stayed full for longer than m_maxEnqueueWait.
+     */
+    bool Enqueue(std::string frame);
+
+    /**
+     * @brief Get the queue depth, backpressure counters and send latency as JSON.
+     */
+    nlohmann::json GetMetrics() const;
+
+    CdpSendQueue(const CdpSendQueue&) = delete;
+    CdpSendQueue& operator=(const CdpSendQueue&) = delete;
+
+private:
+    CdpSendQueue() = default;
+
+    struct QueuedFrame {
+        std::string frame;
+        std::chrono::steady_clock::time_point enqueuedAt;
+    };
+
+    void Drain();
+    void PollBufferedAmount();
+    bool HasRoomLocked(size_t frameSize) const;
+    size_t GetUnsentBytesLocked() const;
+
+    static constexpr size_t m_maxQueuedFrames = 4096;
+    static constexpr size_t m_maxQueuedBytes = 64 * 1024 * 1024;
+    static constexpr std::chrono::seconds m_maxEnqueueWait{5};
+    /** Nothing signals when the socket finished a write, the connection's buffer is polled this often while it isn't empty. */
+    static constexpr std::chrono::milliseconds m_bufferPollInterval{10};
+
+    mutable std::mutex m_queueMutex;
+    std::condition_variable m_roomCondition;
+    std::deque<QueuedFrame> m_queue;
+    size_t m_queuedBytes = 0;
+    /** Bytes of the frames the running drain is handing to the connection. */
+    size_t m_drainingBytes = 0;
+    bool m_isDrainPosted = false;
+
+    Client* m_client = nullptr;
+    websocketpp::connection_hdl m_handle;
+    /** Only used for its write buffer size, frames are sent through m_client. */
+    Client::connection_ptr m_connection;
+    /** The connection's write buffer size as of the last drain or poll on the strand. */
+    std::atomic<size_t> m_bufferedBytes{0};
+    bool m_isBufferPollScheduled = false;
+    std::optional<asio::strand<asio::io_context::executor_type>> m_strand;
+    std::thread::id m_ioThreadId;
+
+    size_t m_peakDepth = 0, m_peakBufferedBytes = 0;
+    unsigned long long m_sentFrames = 0, m_sentBytes = 0, m_drains = 0;
+    unsigned long long m_blockedEnqueues = 0, m_rejectedFrames = 0, m_overflowFrames = 0, m_sendErrors = 0;
+    /** Frames written by one drain, shows how much bursts are coalesced. */
+    size_t m_largestBatch = 0;
+    /** Enqueue -> handed to the connection */
+    LatencyHistogram m_sendLatency;
+};
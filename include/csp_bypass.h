@@ -43,64 +43,67 @@
  * 
  */
 #include "loader.h"
-#include "ffi.h"
+#include "cdp_router.h"
 
+/**
+ * Attaches to every non-client page and disables its CSP, through the session returned by the attach.
+ */
 const void BypassCSP(void)
 {
-    JavaScript::SharedJSMessageEmitter::InstanceRef().OnMessage("msg", "BypassCSP", [&](const nlohmann::json& message, std::string listenerId)
+    const long long targetsCallId = CdpRouter::get().NextCallId();
+
+    CdpRouter::get().ExpectReply(targetsCallId, [](const nlohmann::json& message)
     {
+        if (CdpRouter::IsConnectionLost(message))
+        {
+            return;
+        }
+
         try
         {
-            if (message.contains("id") && message.value("id", -1) == 96876) 
+            for (auto& target : message.at("result").at("targetInfos"))
             {
-                for (auto& target : message["result"]["targetInfos"])
+                const std::string targetUrl = target.value("url", std::string());
+
+                // make sure the only target none client pages. 
+                if (target.value("type", std::string()) == "page" && targetUrl.find("steamloopback.host") == std::string::npos && targetUrl.find("about:blank?") == std::string::npos)
                 {
-                    const std::string targetUrl = target["url"].get<std::string>();
+                    const long long attachCallId = CdpRouter::get().NextCallId();
 
-                    // make sure the only target none client pages. 
-                    if (target["type"] == "page" && targetUrl.find("steamloopback.host") == std::string::npos && targetUrl.find("about:blank?") == std::string::npos)
+                    CdpRouter::get().ExpectReply(attachCallId, [](const nlohmann::json& attachReply)
                     {
+                        /** The page may have closed since it was listed. */
+                        if (!attachReply.contains("result")) return;
+
                         Sockets::PostGlobal({
-                            { "id", 567844 },
-                            { "method", "Target.attachToTarget" },
+                            { "id", 0 },
+                            { "method", "Page.setBypassCSP" },
+                            { "sessionId", attachReply.at("result").at("sessionId") },
                             { "params", {
-                                { "targetId", target["targetId"] },
-                                { "flatten", true }
+                                { "enabled", true },
                             }}
                         });
-                    }
-                }
-            }
+                    });
 
-            if (message.value("method", std::string()) == "Target.attachedToTarget")
-            {
-                Sockets::PostGlobal({
-                    { "id", 1235377 },
-                    { "method", "Page.setBypassCSP" },
-                    { "sessionId", message["params"]["sessionId"] },
-                    { "params", {
-                        { "enabled", true },
-                    }}
-                });
-            }
-
-            if (message.contains("id") && message.value("id", -1) == 1235377)
-            {
-                JavaScript::SharedJSMessageEmitter::InstanceRef().RemoveListener("msg", listenerId);
+                    Sockets::PostGlobal({
+                        { "id", attachCallId },
+                        { "method", "Target.attachToTarget" },
+                        { "params", {
+                            { "targetId", target.at("targetId") },
+                            { "flatten", true }
+                        }}
+                    });
+                }
             }
         }
         catch (const nlohmann::detail::exception& e)
         {
             LOG_ERROR("error bypassing CSP -> {}", e.what());
         }
-        catch(const std::exception& e)
-        {
-            LOG_ERROR("error bypassing CSP -> {}", e.what());
-        }
     });
 
     Sockets::PostGlobal({
-        { "id", 96876 },
+        { "id", targetsCallId },
         { "method", "Target.getTargets" }
     });
-}
\ No newline at end of file
+}
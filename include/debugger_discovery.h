@@ -0,0 +1,105 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+#include <condition_variable>
+#include <nlohmann/json.hpp>
+
+/**
+ * @brief Waits for Steam's CEF debugger to come up without busy polling it.
+ * 
+ * The debugger port is probed with a non-blocking connect, and only once it accepts connections is `/json/version` 
+ * requested. Failed probes are spaced with exponential backoff, and a change to the `DevToolsActivePort` file CEF 
+ * writes to its cache directory once the debugger is listening wakes the wait early (where the file can be watched).
+ * A wait gives up at its deadline so the caller can check whether it should keep trying.
+ */
+class DebuggerDiscovery
+{
+public:
+    static DebuggerDiscovery& get();
+
+    /**
+     * @brief Wait for the debugger on the given port to answer.
+     * @return The body of `/json/version`, or nothing if the debugger didn't answer before the deadline.
+     */
+    std::optional<std::string> WaitForDebugger(unsigned short port);
+
+    /**
+     * @brief Called once the browser socket is open, logs how long the first connection took.
+     */
+    void OnConnected();
+
+    nlohmann::json GetMetrics() const;
+
+    DebuggerDiscovery(const DebuggerDiscovery&) = delete;
+    DebuggerDiscovery& operator=(const DebuggerDiscovery&) = delete;
+
+private:
+    DebuggerDiscovery();
+
+    /** @return true if a connection to the port was accepted within the timeout. */
+    static bool ProbePort(unsigned short port, std::chrono::milliseconds timeout);
+    static std::filesystem::path GetActivePortPath();
+
+    /**
+     * @brief Sleep for the given delay, or until the active port file changed since `seenChanges` was read.
+     * @return true if woken by a change to the file.
+     */
+    bool WaitForChange(uint64_t seenChanges, std::chrono::milliseconds delay);
+
+    static constexpr std::chrono::milliseconds m_probeTimeout { 250 };
+    static constexpr std::chrono::milliseconds m_requestTimeout { 2000 };
+    static constexpr std::chrono::milliseconds m_initialBackoff { 10 };
+    static constexpr std::chrono::milliseconds m_maxBackoff { 500 };
+    static constexpr std::chrono::seconds m_deadline { 30 };
+
+    std::filesystem::path m_activePortPath;
+    bool m_watchingActivePort = false;
+
+    mutable std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+    uint64_t m_activePortChanges = 0;
+
+    std::chrono::steady_clock::time_point m_firstWaitStart;
+    bool m_hasWaited = false;
+    bool m_hasConnected = false;
+
+    uint64_t m_probes = 0;
+    uint64_t m_activePortWakeups = 0;
+    uint64_t m_deadlinesMissed = 0;
+    long long m_lastDiscoveryMs = -1;
+    long long m_timeToFirstConnectMs = -1;
+};
@@ -0,0 +1,119 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <optional>
+#include <filesystem>
+#include <unordered_map>
+
+/**
+ * @brief Bounded LRU cache of patched documents.
+ * 
+ * Steam keeps reopening the same documents (the library, popups, the overlay), so the patched output is 
+ * remembered by the document's url, the length and hash of its original body and the hash of the shim that was 
+ * injected into it. A hit is only served if the stored body and shim equal the current ones, so a hash collision 
+ * is a miss. Entries only live as long as the hook generation they were patched with, and are dropped when 
+ * Steam updates `steamui`, noticed by the watcher or by the directory's write time changing.
+ */
+class DocumentCache
+{
+public:
+    struct Stats {
+        unsigned long long hits;
+        unsigned long long misses;
+        unsigned long long evictions;
+        unsigned long long invalidations;
+        size_t entries;
+        size_t bytes;
+    };
+
+    static DocumentCache& get();
+
+    /**
+     * @brief Build the key of a document from its url, its original (possibly base64 encoded) body and its shim.
+     */
+    static std::string MakeKey(const std::string& requestUrl, const std::string& responseBody, bool base64Encoded, const std::string& shimContent);
+
+    /**
+     * @brief Get a patched document, the cache is emptied first if the hook generation changed or `steamui` was updated.
+     * @return The base64 encoded patched document, or nullptr if it isn't cached for this exact body and shim.
+     */
+    std::shared_ptr<const std::string> Get(const std::string& key, unsigned long long hookGeneration, const std::string& responseBody, const std::string& shimContent);
+    void Insert(const std::string& key, unsigned long long hookGeneration, const std::string& responseBody, 
+        std::shared_ptr<const std::string> shimContent, std::shared_ptr<const std::string> patchedBody);
+
+    void Clear();
+    Stats GetStats() const;
+
+    DocumentCache(const DocumentCache&) = delete;
+    DocumentCache& operator=(const DocumentCache&) = delete;
+
+private:
+    DocumentCache();
+
+    static constexpr size_t m_maxCacheBytes = 32 * 1024 * 1024;
+    static constexpr size_t m_maxEntries = 128;
+    static constexpr unsigned long long m_statsLogInterval = 256;
+    /** The watch on `steamui` isn't recursive, its write time is checked this often as well. */
+    static constexpr std::chrono::seconds m_steamUiCheckInterval{2};
+
+    struct CacheEntry {
+        /** Compared on a hit, keys are only hashes of these. */
+        std::string originalBody;
+        std::shared_ptr<const std::string> shimContent;
+        std::shared_ptr<const std::string> patchedBody;
+        std::list<std::string>::iterator lruIterator;
+
+        size_t Size() const { return originalBody.size() + patchedBody->size(); }
+    };
+
+    void ClearLocked();
+    void CheckSteamUiLocked();
+    void EvictLocked(std::unordered_map<std::string, CacheEntry>::iterator entryIterator);
+    void LogStats(unsigned long long lookupCount);
+
+    mutable std::mutex m_cacheMutex;
+    std::list<std::string> m_lruList;
+    std::unordered_map<std::string, CacheEntry> m_entries;
+    unsigned long long m_hookGeneration = 0;
+    size_t m_cacheBytes = 0;
+
+    const std::filesystem::path m_steamUiPath;
+    std::optional<std::filesystem::file_time_type> m_steamUiWriteTime;
+    std::chrono::steady_clock::time_point m_nextSteamUiCheck;
+
+    std::atomic<unsigned long long> m_lookups{0}, m_hits{0}, m_misses{0}, m_evictions{0}, m_invalidations{0};
+};
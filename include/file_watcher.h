@@ -0,0 +1,89 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <functional>
+#include <filesystem>
+#include <unordered_map>
+
+/**
+ * @brief Watches directories for changes and notifies subscribers with the changed path.
+ * 
+ * Backed by inotify on Linux and `ReadDirectoryChangesW` on Windows. On other platforms `WatchDirectory` returns 
+ * false and callers are expected to fall back to validating file metadata themselves. 
+ * 
+ * If a watched directory is removed (or, on Windows, changes faster than they can be reported) the directory 
+ * itself is reported as changed and it's no longer watched.
+ */
+class FileWatcher
+{
+public:
+    using ChangeCallback = std::function<void(const std::filesystem::path& changedPath)>;
+
+    static FileWatcher& get();
+
+    /**
+     * @brief Watch a directory (non-recursively) for file changes.
+     * @return true if the directory is being watched, false if watching isn't supported or failed.
+     */
+    bool WatchDirectory(const std::filesystem::path& directory, ChangeCallback callback);
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+private:
+    FileWatcher();
+    ~FileWatcher();
+
+    void WatcherThread();
+
+    /** A `ReadDirectoryChangesW` call that is kept outstanding on a watched directory. */
+    struct PendingRead;
+    static bool BeginRead(PendingRead& pendingRead);
+
+    int m_notifyHandle = -1;
+    /** Windows only, the completion port of all the watched directories, keyed by their watch id. */
+    void* m_completionPort = nullptr;
+    int m_nextWatchId = 0;
+    std::mutex m_watchMutex;
+    std::thread m_watcherThread;
+
+    struct WatchedDirectory {
+        std::filesystem::path directory;
+        std::vector<ChangeCallback> callbacks;
+        std::shared_ptr<PendingRead> pendingRead;
+    };
+    std::unordered_map<int, WatchedDirectory> m_watches;
+};
@@ -0,0 +1,90 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <regex>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * @brief Compiles the url patterns of every registered hook into a single matcher.
+ * 
+ * Hooks are grouped by their pattern source so identical patterns (i.e the `.*` used by every webkit module) 
+ * are evaluated once. Each group is keyed in a trie by the literal prefix of its pattern, so a url only 
+ * ever evaluates the patterns whose prefix it shares. Results are memoized per url until the next compile.
+ */
+class HookMatcher
+{
+public:
+    /**
+     * @brief Compile the matcher from a list of url pattern sources.
+     * The index of each pattern is the index returned from `Match`.
+     */
+    void Compile(const std::vector<std::string>& patternSources);
+
+    /**
+     * @brief Get the indices of all patterns that fully match the given url, in registration order.
+     */
+    std::vector<size_t> Match(const std::string& url) const;
+
+    /**
+     * @brief Get the literal prefix every url matched by the given pattern must start with.
+     * Patterns that can't be reduced to a prefix (alternations, leading wildcards) return an empty string.
+     */
+    static std::string LiteralPrefix(const std::string& patternSource);
+
+    HookMatcher() = default;
+    HookMatcher(const HookMatcher&) = delete;
+    HookMatcher& operator=(const HookMatcher&) = delete;
+
+private:
+    static constexpr size_t m_maxMemoizedUrls = 512;
+
+    struct PatternGroup {
+        std::string source;
+        std::regex pattern;
+        bool matchesAll;
+        bool isValid;
+        std::vector<size_t> hookIndices;
+    };
+
+    struct TrieNode {
+        std::unordered_map<char, size_t> children;
+        std::vector<size_t> groups;
+    };
+
+    std::vector<PatternGroup> m_groups;
+    std::vector<TrieNode> m_trie;
+
+    mutable std::mutex m_memoMutex;
+    mutable std::unordered_map<std::string, std::vector<size_t>> m_memo;
+};
@@ -0,0 +1,151 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+/**
+ * @brief Lock-free latency histogram with log-linear buckets (HDR histogram style).
+ * 
+ * Values are recorded in microseconds. Each power of two is split into 16 linear sub-buckets, so any 
+ * reported percentile is within ~6% of the recorded value, from 1us up to ~19 hours.
+ */
+class LatencyHistogram
+{
+public:
+    void Record(std::chrono::microseconds latency);
+
+    struct Summary {
+        std::uint64_t count;
+        double meanMs, p50Ms, p90Ms, p99Ms, maxMs;
+    };
+
+    Summary Summarize() const;
+    nlohmann::json ToJson() const;
+
+private:
+    static constexpr int m_subBucketBits = 4;
+    static constexpr int m_subBucketCount = 1 << m_subBucketBits;
+    static constexpr int m_maxValueBits = 36;
+    static constexpr size_t m_bucketCount = (m_maxValueBits - m_subBucketBits + 1) * m_subBucketCount;
+
+    static size_t BucketIndex(std::uint64_t value);
+    static std::uint64_t BucketMidpoint(size_t bucketIndex);
+    double Percentile(double percentile, std::uint64_t count) const;
+
+    std::array<std::atomic<std::uint64_t>, m_bucketCount> m_buckets{};
+    std::atomic<std::uint64_t> m_count{0}, m_sum{0}, m_max{0};
+};
+
+/**
+ * @brief Timings of the request interception path in HttpHookManager.
+ * 
+ * Every intercepted request is timed per stage and aggregated by resource type. Documents are additionally 
+ * broken down by url class (the host), and every hook counts the documents it matched. Metrics are exposed 
+ * as JSON through `ToJson` and summarized in the log once a minute.
+ */
+class HookMetrics
+{
+public:
+    enum Stage {
+        BODY_REQUEST,   /** Fetch.requestPaused received -> Fetch.getResponseBody sent */
+        BODY_WAIT,      /** Fetch.getResponseBody sent -> reply received */
+        PATCH,          /** Response body received -> patched body ready */
+        ASSET_LOAD,     /** Asset lookup in the asset cache, including the disk read on a miss */
+        FULFILL,        /** Response ready -> Fetch.fulfillRequest posted */
+        TOTAL,          /** Fetch.requestPaused received -> request fulfilled or continued */
+        PREFETCH,       /** Warming the assets a patched document references, off the request path */
+        STAGE_COUNT
+    };
+
+    enum ResourceType {
+        DOCUMENT,
+        SCRIPT,
+        STYLESHEET,
+        IMAGE,
+        FONT,
+        MEDIA,
+        IPC,
+        OTHER,
+        RESOURCE_TYPE_COUNT
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    static HookMetrics& get();
+
+    /**
+     * @brief Map a CDP `Network.ResourceType` to the resource types metrics are kept for.
+     */
+    static ResourceType ResourceTypeFromString(const std::string& resourceType);
+
+    void Record(ResourceType resourceType, Stage stage, Clock::time_point start, Clock::time_point end = Clock::now());
+
+    /**
+     * @brief Record the total time of a document, broken down by the class (host) of its url.
+     */
+    void RecordDocument(const std::string& requestUrl, Clock::time_point pausedAt, Clock::time_point end = Clock::now());
+    void RecordHookMatch(unsigned long long hookId);
+
+    /**
+     * @brief Drop the match counts of hooks that aren't in the given list anymore, i.e. after they were removed.
+     */
+    void RetainHookMatches(const std::vector<unsigned long long>& hookIds);
+
+    nlohmann::json ToJson() const;
+
+    HookMetrics(const HookMetrics&) = delete;
+    HookMetrics& operator=(const HookMetrics&) = delete;
+
+private:
+    HookMetrics();
+
+    void LogSummaryIfDue(Clock::time_point now);
+
+    static constexpr std::chrono::seconds m_summaryInterval{60};
+    static constexpr size_t m_maxUrlClasses = 32;
+
+    std::array<std::array<LatencyHistogram, STAGE_COUNT>, RESOURCE_TYPE_COUNT> m_histograms;
+
+    mutable std::mutex m_breakdownMutex;
+    std::unordered_map<std::string, std::unique_ptr<LatencyHistogram>> m_urlClassHistograms;
+    std::unordered_map<unsigned long long, std::uint64_t> m_hookMatches;
+
+    std::atomic<Clock::rep> m_nextSummary;
+};
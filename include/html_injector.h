@@ -0,0 +1,86 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Injects content right after the opening `<head>` tag of an HTML document in a single pass.
+ * 
+ * The document can be written as base64 (as returned by `Fetch.getResponseBody` and `IO.read`) or as plain bytes, 
+ * in one or more chunks. Input is decoded, scanned for the head tag and re-encoded to base64 on the fly into one 
+ * preallocated output buffer, so the body is never materialized in decoded form. The head tag is matched 
+ * case-insensitively and may carry attributes. If the document has no head tag it is re-encoded unchanged.
+ */
+class HtmlHeadInjector
+{
+public:
+    explicit HtmlHeadInjector(std::string content);
+
+    /**
+     * @brief Reserve the output buffer for a document of the given decoded size.
+     */
+    void Reserve(size_t documentSize);
+
+    void Write(std::string_view bytes);
+    void WriteBase64(std::string_view base64);
+
+    /**
+     * @brief Flush the encoder and take the base64 encoded output.
+     */
+    std::string Finish();
+
+    bool HasInjected() const;
+
+private:
+    enum class ScanState {
+        SEARCH,    /** Looking for `<head`, m_matchedLength holds the matched prefix length. */
+        TAG_NAME,  /** `<head` matched, the next byte decides whether it's actually the head tag. */
+        IN_TAG,    /** Inside the head tag's attributes, waiting for the closing `>`. */
+        DONE
+    };
+
+    bool ScanByte(char byte);
+    void EncodeBytes(const char* data, size_t length);
+
+    std::string m_content;
+    std::string m_output;
+
+    ScanState m_scanState = ScanState::SEARCH;
+    size_t m_matchedLength = 0;
+    char m_quote = 0;
+
+    unsigned char m_encodePending[3];
+    size_t m_encodePendingLength = 0;
+
+    unsigned int m_decodeAccumulator = 0;
+    int m_decodeBits = 0;
+};
@@ -32,6 +32,7 @@
 #include <string>
 #include <chrono>
 #include <thread>
+#include <optional>
 #include "internal_logger.h"
 #include <curl/curl.h>
 
@@ -73,4 +74,35 @@ namespace Http
         }
         return response;
     }
+
+    /**
+     * @brief Make a single request that gives up after the timeout.
+     * @return The response body, or nothing if the request failed.
+     */
+    static std::optional<std::string> TryGet(const char* url, std::chrono::milliseconds timeout) 
+    {
+        CURL* curl = curl_easy_init();
+        std::string response;
+
+        if (!curl) 
+        {
+            return std::nullopt;
+        }
+
+        curl_easy_setopt(curl, CURLOPT_URL, url);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteByteCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+        curl_easy_setopt(curl, CURLOPT_USERAGENT, fmt::format("Millennium/{}", MILLENNIUM_VERSION).c_str());
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout.count()));
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+        const CURLcode res = curl_easy_perform(curl);
+        curl_easy_cleanup(curl);
+
+        if (res != CURLE_OK) 
+        {
+            return std::nullopt;
+        }
+        return response;
+    }
 }
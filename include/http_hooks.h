@@ -42,7 +42,16 @@
 #include <regex>
 #include <filesystem>
 #include <chrono>
+#include <unordered_map>
+#include <optional>
 #include <nlohmann/json.hpp>
+#include <websocketpp/config/asio_no_tls_client.hpp>
+#include <websocketpp/client.hpp>
+#include "hook_matcher.h"
+#include "request_scheduler.h"
+#include "pending_request_table.h"
+
+class HtmlHeadInjector;
 
 extern std::atomic<unsigned long long> g_hookedModuleId;
 
@@ -61,6 +70,8 @@ public:
         std::regex urlPattern;
         TagTypes type;
         unsigned long long id;
+        /** The source of urlPattern, used to compile the hook matcher. */
+        std::string urlPatternSource;
     };
     
     enum RedirectType {
@@ -75,10 +86,66 @@ public:
     void SetupGlobalHooks();
     void AddHook(const HookType& hook);
     bool RemoveHook(unsigned long long hookId);
+    /** Removes all hooks with the given ids in a single update, returns how many were removed. */
+    size_t RemoveHooks(const std::vector<unsigned long long>& hookIds);
+
+    /**
+     * Registers a find/replace patch for the scripts and stylesheets whose url fully matches the pattern, see ResponsePatcher.
+     * @throws std::invalid_argument, std::regex_error if the patch is invalid.
+     */
+    unsigned long long AddResponsePatch(const std::string& urlPatternSource, const std::string& find, const std::string& replace);
+    bool RemoveResponsePatch(unsigned long long patchId);
+
+    /**
+     * An immutable view of the hook list and its compiled matcher. 
+     * Snapshots are never modified after they're published, writers publish a new one instead.
+     */
+    struct HookSnapshot {
+        std::vector<HookType> hooks;
+        HookMatcher matcher;
+        /** Bumped every time the hook list changes, invalidates the shim cache. */
+        unsigned long long generation = 0;
+    };
 
     // Thread-safe hook list operations
     void SetHookList(std::shared_ptr<std::vector<HookType>> hookList);
-    std::vector<HookType> GetHookListCopy() const;
+    std::shared_ptr<const HookSnapshot> GetHookSnapshot() const;
+
+    struct PendingRequestStats {
+        unsigned long long inFlight;
+        unsigned long long completed;
+        unsigned long long expired;
+        /** Expired requests whose body was already streamed, these are failed rather than continued. */
+        unsigned long long abortedStreams;
+    };
+
+    PendingRequestStats GetPendingRequestStats() const;
+
+    /**
+     * Checks for expired requests every m_expiryCheckInterval on the client's io context, 
+     * until the next connection starts its own timer.
+     * @note Must be called from the client's io thread, i.e. in its open handler.
+     */
+    void StartExpiryTimer(websocketpp::client<websocketpp::config::asio_client>* client);
+
+    /**
+     * Every document is paused, it gets the preloader unless it's on the do-not-hook list, which `Fetch.enable` 
+     * can't exclude. Denied pauses are those documents, continued before their body is fetched. 
+     * Scripts and stylesheets are only paused within the url patterns of the response patches, those outside 
+     * are never reported by Chromium and can't be counted.
+     */
+    struct DocumentInterceptionStats {
+        unsigned long long documentPauses;
+        unsigned long long deniedPauses;
+        size_t responsePatterns;
+    };
+
+    DocumentInterceptionStats GetDocumentInterceptionStats() const;
+
+    /**
+     * Queue depths, in-flight counts and wait times of the request scheduler, see RequestScheduler::GetMetrics.
+     */
+    nlohmann::json GetSchedulerMetrics() const;
 
     // Delete copy constructor and assignment operator for singleton
     HttpHookManager(const HttpHookManager&) = delete;
@@ -88,29 +155,11 @@ private:
     HttpHookManager();
     ~HttpHookManager();
 
-    class ThreadPool {
-    public:
-        ThreadPool(size_t numThreads = 4);
-        ~ThreadPool();
-        
-        template<typename F>
-        void enqueue(F&& f);
-        void shutdown();
-        
-    private:
-        std::vector<std::thread> workers;
-        std::queue<std::function<void()>> tasks;
-        std::mutex queueMutex;
-        std::condition_variable condition;
-        std::atomic<bool> stop{false};
-    };
-    
-    std::unique_ptr<ThreadPool> m_threadPool;
+    /** Paused requests are handled off the socket thread, IPC first, then documents, then assets. */
+    std::unique_ptr<RequestScheduler> m_scheduler;
     
     // Thread synchronization
-    mutable std::shared_mutex m_hookListMutex;
-    mutable std::shared_mutex m_requestMapMutex;
-    mutable std::mutex m_socketMutex;
+    mutable std::mutex m_hookWriteMutex;
     mutable std::mutex m_configMutex;
     mutable std::mutex m_exceptionTimeMutex;
     
@@ -127,34 +176,126 @@ private:
     const char* m_oldHookAddress       = "https://pseudo.millennium.app/";
     const char* m_javaScriptVirtualUrl = "https://js.millennium.app/";
     const char* m_styleSheetVirtualUrl = "https://css.millennium.app/";
+
+    /** Path prefix of content hashed asset urls, i.e. https://millennium.ftp/h/<hash>/<path> */
+    const char* m_contentHashPrefix    = "h/";
+    bool m_contentHashedUrls           = true;
+    /** Serve gzip variants of text assets, see AssetPrecompressor. Unverified against Steam's CEF, so it's opt-in. */
+    bool m_precompressedAssets         = false;
+
+    /** Path prefix of virtual module bundles, i.e. https://millennium.ftp/bundle/<key>.js */
+    const char* m_bundlePrefix         = "bundle/";
+    bool m_bundleWebkitModules         = true;
+    /** Serve plugin and theme assets from memory-mapped packs, see AssetPackManager */
+    bool m_assetPacks                  = false;
+    /** Warm the assets a patched document references before the browser asks for them */
+    bool m_prefetchAssets              = true;
     
     // Protected data structures
-    std::shared_ptr<std::vector<HookType>> m_hookListPtr;
+    /** Only accessed through std::atomic_load/std::atomic_store, readers never lock. */
+    std::shared_ptr<const HookSnapshot> m_hookSnapshot;
+    unsigned long long m_hookGeneration = 0;
+
+    /** The files a document shim makes the browser request, see PrefetchDocumentAssets */
+    struct DocumentAssets {
+        std::vector<std::string> paths;
+        std::string bundleKey;
+    };
+
+    struct DocumentShim {
+        std::shared_ptr<const std::string> content;
+        std::shared_ptr<const DocumentAssets> assets;
+        /** Whether the assets were prefetched, entries only live for one hook generation and content epoch. */
+        bool isPrefetched = false;
+    };
+
+    /** Finished document shims of the current hook generation, keyed by policy verdict and matched hooks. */
+    mutable std::mutex m_shimCacheMutex;
+    std::unordered_map<std::string, DocumentShim> m_shimCache;
+    unsigned long long m_shimCacheGeneration = 0;
+    unsigned long long m_shimCacheContentEpoch = 0;
+    std::optional<std::string> m_preloadPath;
+    static constexpr size_t m_maxShimCacheEntries = 256;
+    /** Bounds the walk through a document's static import graph. */
+    static constexpr size_t m_maxPrefetchedAssets = 128;
     
+    /** 
+     * A document body read in chunks through `Fetch.takeResponseBodyAsStream` and `IO.read`. 
+     * Once the body is taken the request can't be continued, so a stream that times out fails the page load.
+     */
+    struct BodyStream {
+        /** The IO stream handle, empty until Fetch.takeResponseBodyAsStream replied. */
+        std::string handle;
+        std::shared_ptr<const std::string> shimContent;
+        std::shared_ptr<HtmlHeadInjector> injector;
+        size_t contentLength = 0;
+    };
+
     struct WebHookItem {
         long long id;
         std::string requestId;
         std::string type;
         nlohmann::basic_json<> message;
+        /** When the request was paused and when its body was requested, see HookMetrics */
+        std::chrono::steady_clock::time_point pausedAt, bodyRequestedAt;
+        /** Set if the body is streamed rather than fetched in one reply. */
+        std::shared_ptr<BodyStream> bodyStream;
     };
-    std::shared_ptr<std::vector<WebHookItem>> m_requestMap;
+
+    /** Requests waiting on a `Fetch.getResponseBody` (or body stream) reply, keyed by the CDP message id. */
+    PendingRequestTable<WebHookItem> m_pendingRequests{ m_pendingRequestTimeout };
+    /** Bumped by StartExpiryTimer, the timer of a previous connection stops once it sees it changed. */
+    std::atomic<unsigned long long> m_expiryTimerGeneration{0};
+
+    std::atomic<unsigned long long> m_requestsInFlight{0}, m_requestsCompleted{0}, m_requestsExpired{0}, m_streamsAborted{0};
+    std::atomic<unsigned long long> m_documentPauses{0}, m_deniedDocumentPauses{0};
+    std::atomic<bool> m_isFetchEnabled{false};
+    static constexpr unsigned long long m_documentStatsLogInterval = 256;
+
+    /** How long a paused document may wait for its response body before it's continued unmodified. */
+    static constexpr std::chrono::seconds m_pendingRequestTimeout{30};
+    static constexpr std::chrono::seconds m_expiryCheckInterval{1};
+
+    /** The largest partial response served at once, larger ranges are shortened and continued by the client. */
+    static constexpr std::uintmax_t m_maxRangeLength = 2 * 1024 * 1024;
+
+    /** Files larger than this are always answered in parts with a 206, even if the client didn't ask for a range. */
+    static constexpr std::uintmax_t m_rangeThreshold = 8 * 1024 * 1024;
+
+    /** Documents larger than this are streamed, rather than sent whole in one giant websocket frame. */
+    static constexpr size_t m_streamingThreshold = 1024 * 1024;
+    static constexpr size_t m_streamChunkSize = 256 * 1024;
     
     // Private methods
     bool IsIpcCall(const nlohmann::basic_json<>& message);
     bool IsGetBodyCall(const nlohmann::basic_json<>& message);
+    bool IsBundleCall(const nlohmann::basic_json<>& message);
+    void ServeBundle(const nlohmann::basic_json<>& message);
     std::string HandleCssHook(const std::string& body);
     std::string HandleJsHook(const std::string& body);
-    const std::string PatchDocumentContents(const std::string& requestUrl, const std::string& original);
+    std::shared_ptr<const std::string> BuildDocumentShim(const std::string& requestUrl);
+    std::string FormatDocumentShim(const HookSnapshot& snapshot, const std::vector<size_t>& matchedHooks, const std::string& preloadPath, bool allowJavaScript, DocumentAssets& documentAssets);
+    void PrefetchDocumentAssets(const DocumentAssets& documentAssets);
     void HandleHooks(const nlohmann::basic_json<>& message);
     void RetrieveRequestFromDisk(const nlohmann::basic_json<>& message);
-    void GetResponseBody(const nlohmann::basic_json<>& message);
+    bool ServeFileRange(const nlohmann::basic_json<>& message, const std::filesystem::path& filePath, const std::string& rangeHeader);
+    void GetResponseBody(const nlohmann::basic_json<>& message, std::chrono::steady_clock::time_point pausedAt);
+    void HandleBodyStream(const nlohmann::basic_json<>& message, WebHookItem request);
+    void ReadBodyStream(WebHookItem request);
     void HandleIpcMessage(nlohmann::json message);
-    std::filesystem::path ConvertToLoopBack(const std::string& requestUrl);
+    std::filesystem::path ConvertToLoopBack(const std::string& requestUrl, std::string* contentHash = nullptr);
+    std::string AssetUrlFromPath(const std::string& filePath);
     
     // Thread-safe utilities
+    void PublishHookList(std::vector<HookType> hookList);
+    static std::vector<std::string> BuildUrlPatterns(const std::vector<std::string>& patternSources);
     void PostGlobalMessage(const nlohmann::json& message);
     bool ShouldLogException();
-    void AddRequest(const WebHookItem& request);
-    template<typename Func>
-    void ProcessRequests(Func processor);
+    void ScheduleRequest(RequestScheduler::Priority priority, std::function<void()> handler);
+    void AddRequest(WebHookItem request);
+    std::optional<WebHookItem> TakeRequest(long long messageId);
+    void EvictExpiredRequests();
+    void ScheduleExpiryCheck(websocketpp::client<websocketpp::config::asio_client>* client, unsigned long long timerGeneration);
+    void ContinueRequest(const std::string& requestId);
+    void AbortRequest(const WebHookItem& request);
 };
\ No newline at end of file
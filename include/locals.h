@@ -98,6 +98,7 @@ namespace SystemIO
     nlohmann::json ReadJsonSync(const std::string& filename, bool* success = nullptr);
     std::string ReadFileSync(const std::string& filename);
     std::vector<char> ReadFileBytesSync(const std::string& filePath);
+    std::vector<char> ReadFileRangeSync(const std::string& filePath, std::uintmax_t offset, size_t length);
     void WriteFileSync(const std::filesystem::path& filePath, std::string content);
     void WriteFileBytesSync(const std::filesystem::path& filePath, const std::vector<unsigned char>& fileContent);
     std::optional<std::string> GetMillenniumPreloadPath();
@@ -0,0 +1,108 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "asset_cache.h"
+
+/**
+ * @brief Combines the webkit modules matched by a document into one virtual module.
+ * 
+ * Every module is still evaluated as its own ES module, it's embedded in the bundle and imported from a blob 
+ * url, so plugins keep their own scope and a plugin that throws doesn't stop the others. Modules are imported 
+ * in order, each once the previous one finished evaluating, like the preloader imports them. 
+ * 
+ * Only modules that import nothing are bundled, see IsBundleable. A module with imports would resolve them 
+ * against the blob url, and a dependency shared with another module would be instantiated twice.
+ * 
+ * Bundles are keyed by the paths and content hashes of their modules and the hook generation and content epoch 
+ * of the shim they're planned for, and are rebuilt when any of the modules changes. Planned bundles live as long as 
+ * the shims referencing them, see RetireBundles.
+ */
+class ModuleBundler
+{
+public:
+    static ModuleBundler& get();
+
+    struct BundlePlan {
+        std::string bundleKey;                     /** Empty if nothing was bundled. */
+        std::vector<std::string> standalonePaths;  /** Modules that have to be loaded on their own. */
+    };
+
+    /**
+     * @brief Decide which of the given modules go into a bundle and register it.
+     * @param generation - The hook generation of the shim the bundle is planned for.
+     * @param contentEpoch - The asset cache invalidation epoch of the shim the bundle is planned for.
+     */
+    BundlePlan Plan(const std::vector<std::string>& modulePaths, const AssetCache::AssetLoader& loader, unsigned long long generation, unsigned long long contentEpoch);
+
+    /**
+     * @brief Called whenever the shims referencing the planned bundles are dropped. 
+     * Bundles planned before the previous call are forgotten, the others stay servable until the next call 
+     * for documents that were patched with a dropped shim but haven't requested their bundle yet.
+     */
+    void RetireBundles();
+
+    /**
+     * @brief Get the bundle with the given key, built from the current contents of its modules.
+     * @return The bundle as a base64 encoded asset, or nullptr if the key is unknown or a module can't be read.
+     */
+    std::shared_ptr<const AssetCache::Asset> GetBundle(const std::string& bundleKey, const AssetCache::AssetLoader& loader);
+
+    /**
+     * @brief Check if a module can be evaluated from a blob url, i.e. it has no imports, re-exports or `import.meta`.
+     */
+    static bool IsBundleable(const std::string& source);
+
+    /**
+     * @brief Find the relative specifiers a module statically imports, i.e. `import "./a.js"` or `export * from "../b.js"`.
+     * Dynamic imports aren't included, they may never be evaluated.
+     */
+    static std::vector<std::string> FindStaticImports(const std::string& source);
+
+    ModuleBundler(const ModuleBundler&) = delete;
+    ModuleBundler& operator=(const ModuleBundler&) = delete;
+
+private:
+    ModuleBundler() = default;
+
+    static constexpr size_t m_maxBuiltBundles = 16;
+
+    std::mutex m_bundleMutex;
+    /** The modules of the bundles planned for the current shims, and for the shims dropped last. */
+    std::unordered_map<std::string, std::vector<std::string>> m_bundleModules;
+    std::unordered_map<std::string, std::vector<std::string>> m_retiredBundleModules;
+    /** Built bundles, keyed by the combined content hash of their modules. */
+    std::unordered_map<std::string, std::shared_ptr<const AssetCache::Asset>> m_builtBundles;
+};
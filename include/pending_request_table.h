@@ -0,0 +1,113 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+
+/**
+ * @brief Requests waiting on a reply to one of our CDP calls, keyed by the call's message id.
+ * 
+ * Lookups are O(1). Every request gets a deadline when it's added, requests whose reply never arrives 
+ * (i.e. the navigation was aborted or the target closed) are taken out by TakeExpired so they don't leak.
+ */
+template <typename Request>
+class PendingRequestTable
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit PendingRequestTable(Clock::duration timeout) : m_timeout(timeout) { }
+
+    /**
+     * @brief Add a request that expires after the table's timeout.
+     * @return false if a request is already waiting on the message id, the new one is dropped.
+     */
+    bool Add(long long messageId, Request request, Clock::time_point now = Clock::now())
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.emplace(messageId, Entry{ std::move(request), now + m_timeout }).second;
+    }
+
+    /**
+     * @brief Remove and return the request waiting on the given message id, if any.
+     */
+    std::optional<Request> Take(long long messageId)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto entryIterator = m_entries.find(messageId);
+
+        if (entryIterator == m_entries.end()) {
+            return std::nullopt;
+        }
+
+        Request request = std::move(entryIterator->second.request);
+        m_entries.erase(entryIterator);
+        return request;
+    }
+
+    /**
+     * @brief Remove and return every request whose deadline has passed.
+     */
+    std::vector<Request> TakeExpired(Clock::time_point now = Clock::now())
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<Request> expiredRequests;
+
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (it->second.deadline <= now) {
+                expiredRequests.push_back(std::move(it->second.request));
+                it = m_entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return expiredRequests;
+    }
+
+    size_t Size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+
+private:
+    struct Entry {
+        Request request;
+        Clock::time_point deadline;
+    };
+
+    const Clock::duration m_timeout;
+    mutable std::mutex m_mutex;
+    std::unordered_map<long long, Entry> m_entries;
+};
@@ -0,0 +1,151 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include "cdp_router.h"
+#include "hook_metrics.h"
+
+/**
+ * @brief Keeps the state Millennium sets up on the browser connection, and restores it after a reconnect.
+ * 
+ * State is declared rather than sent: global calls (i.e. `Fetch.enable`), targets to stay attached to (by title) 
+ * with the binding they're exposed, and calls made on a target's session (i.e. injected scripts). Declared state is 
+ * sent right away when connected, and replayed in one pipelined burst on every (re)connect without waiting on the 
+ * reply to each call. Declaring a key again replaces the previous call.
+ * 
+ * Reconnect attempts are spaced with exponential backoff, and the time from a disconnect until the connection 
+ * and every tracked target are back is recorded.
+ */
+class ReconnectManager
+{
+public:
+    using ReplyHandler = CdpRouter::Handler;
+
+    static ReconnectManager& get();
+
+    struct TrackedTarget {
+        /** Exposed to the target through `Target.exposeDevToolsProtocol`, none if empty. */
+        std::string bindingName;
+        /** Called with the new session id after every attach. */
+        std::function<void(const std::string& sessionId)> onAttached;
+    };
+
+    /**
+     * @brief Declare a browser wide call, i.e. `Fetch.enable`.
+     * @param onReply - Called with the reply to every send of the call, including replays.
+     */
+    void SetGlobalState(const std::string& key, nlohmann::json call, ReplyHandler onReply = nullptr);
+
+    /**
+     * @brief Stay attached to the target with the given title, found again on every connection.
+     */
+    void TrackTarget(const std::string& targetTitle, TrackedTarget target);
+
+    /**
+     * @brief Declare a call on the session of a tracked target, sent once the target is attached.
+     */
+    void SetSessionState(const std::string& targetTitle, const std::string& key, nlohmann::json call, ReplyHandler onReply = nullptr);
+
+    /**
+     * @brief Replay the declared state on a new connection.
+     * @note Call once the send queue is attached to the connection.
+     */
+    void OnConnected();
+
+    /**
+     * @brief Note that the connection dropped, or an attempt to connect failed.
+     * @return true if the connection had been established, false if the attempt failed.
+     */
+    bool OnDisconnected();
+
+    /**
+     * @brief Get how long to wait before the next connection attempt, doubled for every failed attempt in a row.
+     */
+    std::chrono::milliseconds NextRetryDelay();
+
+    /**
+     * @brief Get the reconnect count and latencies as JSON.
+     */
+    nlohmann::json GetMetrics() const;
+
+    ReconnectManager(const ReconnectManager&) = delete;
+    ReconnectManager& operator=(const ReconnectManager&) = delete;
+
+private:
+    ReconnectManager() = default;
+
+    struct StateCall {
+        std::string key;
+        nlohmann::json call;
+        ReplyHandler onReply;
+    };
+
+    struct Target {
+        TrackedTarget tracked;
+        std::vector<StateCall> sessionState;
+        /** Empty until attached on the current connection. */
+        std::string sessionId;
+        bool isAttaching = false;
+    };
+
+    using OutgoingCalls = std::vector<nlohmann::json>;
+
+    static void UpsertState(std::vector<StateCall>& state, StateCall stateCall);
+    void AddCallLocked(OutgoingCalls& outgoing, const StateCall& stateCall, const std::string& sessionId);
+    void DiscoverTargetsLocked(OutgoingCalls& outgoing);
+    void OnTargetsListed(const nlohmann::json& reply, unsigned long long connectionId);
+    void OnTargetAttached(const std::string& targetTitle, const nlohmann::json& reply, unsigned long long connectionId);
+    void RecordRecoveryLocked();
+    static void Send(const OutgoingCalls& outgoing);
+
+    static constexpr std::chrono::milliseconds m_initialRetryDelay{100};
+    static constexpr std::chrono::milliseconds m_maxRetryDelay{10000};
+
+    mutable std::mutex m_stateMutex;
+    std::vector<StateCall> m_globalState;
+    std::map<std::string, Target> m_targets;
+
+    bool m_isConnected = false, m_isDiscovering = false, m_isRecovering = false;
+    /** Replies meant for an earlier connection are ignored. */
+    unsigned long long m_connectionId = 0;
+    unsigned m_failedAttempts = 0;
+    unsigned long long m_reconnects = 0;
+    std::chrono::steady_clock::time_point m_disconnectedAt;
+
+    /** Disconnect -> connected again, and disconnect -> every tracked target attached again. */
+    LatencyHistogram m_reconnectLatency, m_recoveryLatency;
+};
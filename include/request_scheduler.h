@@ -0,0 +1,117 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <array>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+#include <nlohmann/json.hpp>
+#include "hook_metrics.h"
+
+/**
+ * @brief Runs the handlers of paused requests on a worker pool, by priority.
+ * 
+ * Tasks are queued per class. Workers take the highest priority task whose class is under its in-flight limit, 
+ * so a burst of asset fulfills can't hold up the IPC replies the UI is waiting on. A task that waited longer than 
+ * the aging threshold is taken first regardless of its priority, so lower classes never starve.
+ */
+class RequestScheduler
+{
+public:
+    enum Priority {
+        IPC,
+        DOCUMENT,
+        ASSET,
+        /** Speculative work, it never ages ahead of requests that are actually waiting. */
+        PREFETCH,
+        PRIORITY_COUNT
+    };
+
+    using Task = std::function<void()>;
+
+    struct Options {
+        size_t workerCount = 4;
+        /** The most tasks of each class that may run at once. */
+        std::array<size_t, PRIORITY_COUNT> inFlightLimits = { 1, 2, 2, 1 };
+        std::chrono::milliseconds agingThreshold{100};
+    };
+
+    explicit RequestScheduler(Options options);
+    ~RequestScheduler();
+
+    void Enqueue(Priority priority, Task task);
+
+    /**
+     * @brief Stop the workers, tasks that haven't started yet are dropped.
+     */
+    void Shutdown();
+
+    /**
+     * @brief Get the queue depth, in-flight count and wait time of every class as JSON.
+     */
+    nlohmann::json GetMetrics() const;
+
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+private:
+    struct QueuedTask {
+        Task task;
+        std::chrono::steady_clock::time_point enqueuedAt;
+    };
+
+    struct TaskQueue {
+        std::deque<QueuedTask> tasks;
+        size_t inFlight = 0;
+        size_t peakDepth = 0;
+        unsigned long long completed = 0;
+        /** Tasks that were taken ahead of higher priority work because they waited too long. */
+        unsigned long long aged = 0;
+        LatencyHistogram waitTime;
+    };
+
+    bool TakeNextLocked(Priority& priority, QueuedTask& queuedTask);
+    void WorkerThread();
+
+    static constexpr size_t m_depthWarningThreshold = 64;
+
+    Options m_options;
+
+    mutable std::mutex m_queueMutex;
+    std::condition_variable m_condition;
+    std::array<TaskQueue, PRIORITY_COUNT> m_queues;
+    std::vector<std::thread> m_workers;
+    bool m_stop = false;
+};
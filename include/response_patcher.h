@@ -0,0 +1,158 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <array>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include "hook_matcher.h"
+
+/**
+ * @brief Multi-pattern byte string searcher (Aho-Corasick).
+ * 
+ * All patterns are compiled into a single automaton, a haystack is scanned once regardless of how many 
+ * patterns there are. Transitions are stored sparsely, Steam's bundles are large but patches are few.
+ */
+class PatternAutomaton
+{
+public:
+    struct Match {
+        size_t position;
+        size_t patternIndex;
+    };
+
+    void Compile(const std::vector<std::string>& patterns);
+
+    /**
+     * @brief Find every non-overlapping occurrence of the enabled patterns, ordered by position. 
+     * Overlaps are resolved leftmost first, the longest pattern wins a tie.
+     */
+    std::vector<Match> FindAll(const std::string& haystack, const std::vector<bool>& enabledPatterns) const;
+
+    size_t PatternLength(size_t patternIndex) const { return m_patternLengths[patternIndex]; }
+
+private:
+    struct State {
+        /** Transitions of every state but the root, which is looked up in m_rootTransitions. */
+        std::vector<std::pair<unsigned char, std::int32_t>> transitions;
+        std::int32_t failure = 0;
+        /** The next state along the failure chain that ends a pattern, -1 if there's none. */
+        std::int32_t outputLink = -1;
+        std::int32_t patternIndex = -1;
+    };
+
+    std::int32_t Transition(std::int32_t state, unsigned char character) const;
+
+    std::vector<State> m_states;
+    std::array<std::int32_t, 256> m_rootTransitions{};
+    std::vector<size_t> m_patternLengths;
+};
+
+/**
+ * @brief Declarative find/replace patches for Steam's own scripts and stylesheets.
+ * 
+ * Responses are intercepted like documents and scanned once for every patch whose url pattern matches. 
+ * Patched bodies are cached by the hash of the original body, so a Steam chunk is only patched once 
+ * per Steam update rather than once per window.
+ */
+class ResponsePatcher
+{
+public:
+    struct Patch {
+        unsigned long long id;
+        /** A regex the response url has to fully match. */
+        std::string urlPatternSource;
+        std::string find;
+        std::string replace;
+    };
+
+    static ResponsePatcher& get();
+
+    /**
+     * @brief Register a patch, every occurrence of `find` is replaced with `replace`.
+     * @throws std::invalid_argument if the find string is empty, std::regex_error if the url pattern is invalid.
+     * @returns The id of the patch.
+     */
+    unsigned long long AddPatch(const std::string& urlPatternSource, const std::string& find, const std::string& replace);
+    bool RemovePatch(unsigned long long patchId);
+
+    /**
+     * @brief Get whether any patch applies to the given url, responses that no patch applies to shouldn't be paused.
+     */
+    bool HasPatchesFor(const std::string& url) const;
+
+    /**
+     * @brief Get the url pattern sources of all patches, used to narrow `Fetch.enable`.
+     */
+    std::vector<std::string> GetUrlPatternSources() const;
+
+    /**
+     * @brief Apply the patches matching the url to a response body.
+     * @returns The base64 encoded patched body, or nullptr if nothing was replaced.
+     */
+    std::shared_ptr<const std::string> Apply(const std::string& url, const std::string& responseBody, bool base64Encoded);
+
+    ResponsePatcher(const ResponsePatcher&) = delete;
+    ResponsePatcher& operator=(const ResponsePatcher&) = delete;
+
+private:
+    ResponsePatcher() = default;
+
+    /** An immutable compiled view of the patch list, swapped in whenever the list changes. */
+    struct PatchSet {
+        std::vector<Patch> patches;
+        HookMatcher urlMatcher;
+        /** Compiled from the distinct find strings, patches sharing one are listed in registration order. */
+        PatternAutomaton automaton;
+        std::vector<std::vector<size_t>> findPatches;
+        unsigned long long generation = 0;
+    };
+
+    std::shared_ptr<const PatchSet> GetPatchSet() const;
+    void PublishPatches(std::vector<Patch> patches);
+
+    static std::string ReplaceMatches(const PatchSet& patchSet, const std::vector<size_t>& matchedPatches, const std::string& body, size_t& replacements);
+
+    static constexpr size_t m_maxCacheBytes = 64 * 1024 * 1024;
+
+    std::mutex m_writeMutex;
+    std::shared_ptr<const PatchSet> m_patchSet = std::make_shared<const PatchSet>();
+    unsigned long long m_nextPatchId = 0;
+
+    std::mutex m_cacheMutex;
+    unsigned long long m_cacheGeneration = 0;
+    size_t m_cacheBytes = 0;
+    /** Patched bodies keyed by the hash of the original body and the matched patches. nullptr if nothing was replaced. */
+    std::unordered_map<std::string, std::shared_ptr<const std::string>> m_cache;
+};
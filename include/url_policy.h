@@ -0,0 +1,78 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <regex>
+#include <filesystem>
+#include <unordered_map>
+
+/**
+ * @brief Decides which urls Millennium is allowed to inject into.
+ * 
+ * Rules are compiled once on first use from the built-in safety list and the optional user policy file 
+ * (`url_policy.json` in the Millennium config directory). Host rules are stored in a hash table and 
+ * matched against the url host and each of its parent domains, pattern rules are precompiled regexes.
+ */
+class UrlPolicy
+{
+public:
+    enum Verdict {
+        ALLOW,
+        DENY_JAVASCRIPT, /** Only stylesheets may be injected. */
+        DENY_ALL         /** The request must not be hooked at all. */
+    };
+
+    static UrlPolicy& get();
+
+    /**
+     * @brief Evaluate the strictest verdict of all rules that apply to the url.
+     */
+    Verdict Evaluate(const std::string& url) const;
+
+    UrlPolicy(const UrlPolicy&) = delete;
+    UrlPolicy& operator=(const UrlPolicy&) = delete;
+
+private:
+    UrlPolicy();
+
+    void AddHostRule(std::string host, Verdict verdict);
+    void AddPatternRule(const std::string& pattern, Verdict verdict);
+    void LoadPolicyFile(const std::filesystem::path& policyPath);
+
+    struct PatternRule {
+        std::regex pattern;
+        Verdict verdict;
+    };
+
+    std::unordered_map<std::string, Verdict> m_hostRules;
+    std::vector<PatternRule> m_patternRules;
+};
@@ -37,6 +37,12 @@
 #include "internal_logger.h"
 #include "locals.h"
 #include "http_hooks.h"
+#include "hook_metrics.h"
+#include "document_cache.h"
+#include "cdp_send_queue.h"
+#include "cdp_router.h"
+#include "reconnect_manager.h"
+#include "debugger_discovery.h"
 #include "co_stub.h"
 #include "plugin_logger.h"
 #include "encoding.h"
@@ -173,7 +179,7 @@ MILLENNIUM unsigned long long AddBrowserModule(PyObject* args, HttpHookManager::
 
     try 
     {
-        HttpHookManager::get().AddHook({ path.generic_string(), std::regex(regexSelector), type, g_hookedModuleId });
+        HttpHookManager::get().AddHook({ path.generic_string(), std::regex(regexSelector), type, g_hookedModuleId, regexSelector });
     } 
     catch (const std::regex_error& e) 
     {
@@ -195,6 +201,41 @@ MILLENNIUM PyObject* AddBrowserJs(PyObject* self, PyObject* args)
     return PyLong_FromLong((long)AddBrowserModule(args, HttpHookManager::TagTypes::JAVASCRIPT)); 
 }
 
+MILLENNIUM PyObject* AddBrowserPatch(PyObject* self, PyObject* args) 
+{
+    const char* urlPattern;
+    const char* findString;
+    const char* replaceString;
+
+    if (!PyArg_ParseTuple(args, "sss", &urlPattern, &findString, &replaceString)) 
+    {
+        return NULL;
+    }
+
+    try 
+    {
+        return PyLong_FromUnsignedLongLong(HttpHookManager::get().AddResponsePatch(urlPattern, findString, replaceString));
+    } 
+    catch (const std::exception& e) 
+    {
+        LOG_ERROR("Attempted to add an invalid browser patch for {} ({})", urlPattern, e.what());
+        ErrorToLogger("executor", fmt::format("Failed to add browser patch for {} ({})", urlPattern, e.what()));
+        return PyLong_FromLong(0);
+    }
+}
+
+MILLENNIUM PyObject* RemoveBrowserPatch(PyObject* self, PyObject* args) 
+{ 
+    unsigned long long patchId;
+
+    if (!PyArg_ParseTuple(args, "K", &patchId)) 
+    {
+        return NULL;
+    }
+
+    return PyBool_FromLong(HttpHookManager::get().RemoveResponsePatch(patchId));
+}
+
 /* 
 This portion of the API is undocumented but you can use it. 
 */
@@ -396,6 +437,47 @@ MILLENNIUM PyObject* GetBuildDate(PyObject* self, PyObject* args)
     return PyUnicode_FromString(getBuildTimestamp().c_str());
 } 
 
+/**
+ * Gets the latency histograms, hook match counts, document cache hit rates, document interception counts, 
+ * scheduler queue depths, CDP send queue and router stats, reconnect latencies and debugger discovery times 
+ * of the request interception path as a JSON string.
+ */
+MILLENNIUM PyObject* GetHookMetrics(PyObject* self, PyObject* args)
+{
+    nlohmann::json metrics = HookMetrics::get().ToJson();
+    const DocumentCache::Stats cacheStats = DocumentCache::get().GetStats();
+
+    metrics["documentCache"] = {
+        { "hits", cacheStats.hits },
+        { "misses", cacheStats.misses },
+        { "evictions", cacheStats.evictions },
+        { "invalidations", cacheStats.invalidations },
+        { "entries", cacheStats.entries },
+        { "bytes", cacheStats.bytes }
+    };
+    const HttpHookManager::DocumentInterceptionStats interceptionStats = HttpHookManager::get().GetDocumentInterceptionStats();
+
+    metrics["documentInterception"] = {
+        { "documentPauses", interceptionStats.documentPauses },
+        { "deniedPauses", interceptionStats.deniedPauses },
+        { "responsePatterns", interceptionStats.responsePatterns }
+    };
+    const HttpHookManager::PendingRequestStats requestStats = HttpHookManager::get().GetPendingRequestStats();
+
+    metrics["pendingRequests"] = {
+        { "inFlight", requestStats.inFlight },
+        { "completed", requestStats.completed },
+        { "expired", requestStats.expired },
+        { "abortedStreams", requestStats.abortedStreams }
+    };
+    metrics["scheduler"] = HttpHookManager::get().GetSchedulerMetrics();
+    metrics["sendQueue"] = CdpSendQueue::get().GetMetrics();
+    metrics["router"] = CdpRouter::get().GetMetrics();
+    metrics["reconnect"] = ReconnectManager::get().GetMetrics();
+    metrics["discovery"] = DebuggerDiscovery::get().GetMetrics();
+    return PyUnicode_FromString(metrics.dump().c_str());
+}
+
 /** 
  * Method API for the Millennium module
  * This is injected individually into each plugins Python backend, enabling them to interop with Millennium's internal API.
@@ -413,6 +495,9 @@ MILLENNIUM PyMethodDef* GetMillenniumModule()
         { "add_browser_js",        AddBrowserJs,                    METH_VARARGS, NULL },
         /** Remove a CSS or JavaScript file, passing the ModuleID provided from add_browser_js/css */
         { "remove_browser_module", RemoveBrowserModule,             METH_VARARGS, NULL },
+        /** Replace every occurrence of a string in the Steam scripts and stylesheets whose url matches a regex. */
+        { "add_browser_patch",     AddBrowserPatch,                 METH_VARARGS, NULL },
+        { "remove_browser_patch",  RemoveBrowserPatch,              METH_VARARGS, NULL },
 
         { "get_user_settings",     GetUserSettings,                 METH_NOARGS,  NULL },
         { "set_user_settings_key", SetUserSettings,                 METH_VARARGS, NULL },
@@ -435,6 +520,7 @@ MILLENNIUM PyMethodDef* GetMillenniumModule()
 
         /** For internal use, but can be used if its useful */
         { "__internal_get_build_date",  GetBuildDate,               METH_VARARGS, NULL },
+        { "__internal_get_hook_metrics", GetHookMetrics,            METH_NOARGS,  NULL },
         {NULL, NULL, 0, NULL} // Sentinel
     };
 
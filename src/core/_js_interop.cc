@@ -31,6 +31,7 @@
 #include "ffi.h"
 #include "co_spawn.h"
 #include "loader.h"
+#include "cdp_router.h"
 #include <future>
 #include "fvisible.h"
 #include <mutex>
@@ -43,8 +44,6 @@ struct EvalResult
     bool successfulCall;
 };
 
-#define SHARED_JS_EVALUATE_ID 54999
-
 /**
  * Executes JavaScript code on the SharedJSContext and retrieves the result.
  *
@@ -62,7 +61,7 @@ struct EvalResult
  *
  * Synchronization:
  * - Uses a `std::mutex` and `std::condition_variable` to ensure safe access to shared data.
- * - The listener is removed once a response is received.
+ * - The reply is routed to this call by its id, see CdpRouter.
  */
 MILLENNIUM const EvalResult ExecuteOnSharedJsContext(std::string javaScriptEval) 
 {
@@ -71,64 +70,66 @@ MILLENNIUM const EvalResult ExecuteOnSharedJsContext(std::string javaScriptEval)
     EvalResult evalResult;
     bool resultReady = false;  // Flag to indicate when the result is ready
 
-    bool messageSendSuccess = Sockets::PostShared(nlohmann::json({ 
-        { "id", SHARED_JS_EVALUATE_ID },
-        { "method", "Runtime.evaluate" }, 
-        { "params", {
-            { "expression", javaScriptEval }, 
-            { "awaitPromise", true }
-        }} 
-    }));
+    /** Every evaluation has its own id, so concurrent calls can't pick up each other's result. */
+    const long long callId = CdpRouter::get().NextCallId();
 
-    if (!messageSendSuccess) 
-    {
-        throw std::runtime_error("couldn't send message to socket");
-    }
-
-    std::string listenerId = JavaScript::SharedJSMessageEmitter::InstanceRef().OnMessage("msg", "ExecuteOnSharedJsContext", [&](const nlohmann::json& eventMessage, std::string listenerId) 
+    CdpRouter::get().ExpectReply(callId, [&](const nlohmann::json& response) 
     {
         std::lock_guard<std::mutex> lock(mtx);  // Lock mutex for safe access
 
-        nlohmann::json response = eventMessage;
-        std::string method = response.value("method", std::string());
-
-        if (method.find("Debugger") != std::string::npos || method.find("Console") != std::string::npos) 
-        {
-            return;
-        }
-
         try 
         {
-            if (!response.contains("id") || (response.contains("id") && !response["id"].is_null() && response["id"] != SHARED_JS_EVALUATE_ID))
+            /** i.e. the connection was lost before the reply arrived, see CdpRouter::ClearPendingReplies */
+            if (response.contains("error"))
             {
+                evalResult = { response["error"].value("message", std::string("CDP call failed")), false };
+                resultReady = true;
+                cv.notify_one();
                 return;
             }
 
-            if (response["result"].contains("exceptionDetails"))
+            nlohmann::json result = response.at("result");
+
+            if (result.contains("exceptionDetails"))
             {
-                const std::string classType = response["result"]["exceptionDetails"]["exception"]["className"];
+                const std::string classType = result["exceptionDetails"]["exception"]["className"];
 
                 // Custom exception type thrown from CallFrontendMethod in executor.cc
                 if (classType == "MillenniumFrontEndError") 
                     evalResult = { "__CONNECTION_ERROR__", false };
                 else
-                    evalResult = { response["result"]["exceptionDetails"]["exception"]["description"], false };
+                    evalResult = { result["exceptionDetails"]["exception"]["description"], false };
             }
             else 
             {
-                evalResult = { response["result"]["result"], true };
+                evalResult = { result["result"], true };
             }
-
-            resultReady = true;
-            cv.notify_one();  // Signal that result is ready
-            JavaScript::SharedJSMessageEmitter::InstanceRef().RemoveListener("msg", listenerId);
         }
         catch (nlohmann::detail::exception& ex) 
         {
-            LOG_ERROR(fmt::format("JavaScript::SharedJSMessageEmitter error -> {}", ex.what()));
+            LOG_ERROR("ExecuteOnSharedJsContext error -> {}", ex.what());
+            evalResult = { ex.what(), false };
         }
+
+        resultReady = true;
+        cv.notify_one();  // Signal that result is ready
     });
 
+    bool messageSendSuccess = Sockets::PostShared(nlohmann::json({ 
+        { "id", callId },
+        { "method", "Runtime.evaluate" }, 
+        { "params", {
+            { "expression", javaScriptEval }, 
+            { "awaitPromise", true }
+        }} 
+    }));
+
+    if (!messageSendSuccess) 
+    {
+        CdpRouter::get().CancelReply(callId);
+        throw std::runtime_error("couldn't send message to socket");
+    }
+
     // Wait for the result to be ready
     std::unique_lock<std::mutex> lock(mtx);
     cv.wait(lock, [&] { return resultReady; });
@@ -0,0 +1,303 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "asset_cache.h"
+#include "file_watcher.h"
+#include "internal_logger.h"
+
+AssetCache& AssetCache::get()
+{
+    static AssetCache instance;
+    return instance;
+}
+
+/**
+ * Checks if the cached asset still describes the file on disk.
+ */
+static bool IsAssetCurrent(const std::filesystem::path& filePath, const AssetCache::Asset& asset)
+{
+    std::error_code errorCode;
+    const auto fileSize = std::filesystem::file_size(filePath, errorCode);
+    if (errorCode) return false;
+
+    const auto lastWriteTime = std::filesystem::last_write_time(filePath, errorCode);
+    if (errorCode) return false;
+
+    return fileSize == asset.fileSize && lastWriteTime == asset.lastWriteTime;
+}
+
+std::shared_ptr<const AssetCache::Asset> AssetCache::Get(const std::filesystem::path& filePath, const AssetLoader& loader)
+{
+    const std::string cacheKey = filePath.generic_string();
+    const std::filesystem::path directory = filePath.parent_path();
+    const unsigned long long lookupCount = ++m_lookups;
+
+    if (lookupCount % m_statsLogInterval == 0)
+    {
+        this->LogStats(lookupCount);
+    }
+
+    std::shared_ptr<const Asset> cachedAsset;
+    bool isWatched = false;
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        auto entryIterator = m_entries.find(cacheKey);
+
+        if (entryIterator != m_entries.end())
+        {
+            auto watchIterator = m_watchedDirectories.find(directory.generic_string());
+
+            cachedAsset = entryIterator->second.asset;
+            isWatched   = watchIterator != m_watchedDirectories.end() && watchIterator->second;
+            m_lruList.splice(m_lruList.begin(), m_lruList, entryIterator->second.lruIterator);
+        }
+    }
+
+    /** Watched entries are evicted on change, unwatched entries are validated against the file metadata. */
+    if (cachedAsset && (isWatched || IsAssetCurrent(filePath, *cachedAsset)))
+    {
+        m_hits++;
+        return cachedAsset;
+    }
+
+    std::promise<std::shared_ptr<const Asset>> loadPromise;
+    unsigned long long invalidationEpoch;
+    {
+        std::unique_lock<std::mutex> lock(m_cacheMutex);
+
+        if (cachedAsset)
+        {
+            auto entryIterator = m_entries.find(cacheKey);
+            if (entryIterator != m_entries.end() && entryIterator->second.asset == cachedAsset) 
+            {
+                EvictLocked(entryIterator);
+                m_invalidations++;
+
+                if (!m_excludedDirectories.count(directory.generic_string()))
+                {
+                    m_invalidationEpoch++;
+                }
+            }
+        }
+
+        /** Another thread is already reading this file, wait for its result instead of reading it again. */
+        auto inFlightIterator = m_inFlight.find(cacheKey);
+        if (inFlightIterator != m_inFlight.end())
+        {
+            auto sharedResult = inFlightIterator->second;
+            lock.unlock();
+
+            m_coalesced++;
+            return sharedResult.get();
+        }
+
+        m_inFlight.emplace(cacheKey, loadPromise.get_future().share());
+        invalidationEpoch = m_invalidationEpoch;
+        WatchDirectoryLocked(directory);
+    }
+
+    m_misses++;
+
+    std::error_code errorCode;
+    const auto fileSize      = std::filesystem::file_size(filePath, errorCode);
+    const auto lastWriteTime = std::filesystem::last_write_time(filePath, errorCode);
+
+    std::shared_ptr<Asset> loadedAsset;
+    try
+    {
+        loadedAsset = errorCode ? nullptr : loader(filePath);
+    }
+    catch (const std::exception& error)
+    {
+        LOG_ERROR("Failed to load asset '{}': {}", cacheKey, error.what());
+    }
+
+    if (loadedAsset)
+    {
+        loadedAsset->fileSize      = fileSize;
+        loadedAsset->lastWriteTime = lastWriteTime;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        m_inFlight.erase(cacheKey);
+
+        /** Don't cache the asset if the file was changed while it was being read. */
+        if (loadedAsset && invalidationEpoch == m_invalidationEpoch)
+        {
+            InsertLocked(cacheKey, loadedAsset);
+        }
+    }
+
+    loadPromise.set_value(loadedAsset);
+    return loadedAsset;
+}
+
+void AssetCache::InsertLocked(const std::string& key, std::shared_ptr<const Asset> asset)
+{
+    if (asset->body.size() > m_maxEntryBytes)
+    {
+        return;
+    }
+
+    auto existingIterator = m_entries.find(key);
+    if (existingIterator != m_entries.end())
+    {
+        EvictLocked(existingIterator);
+    }
+
+    m_lruList.push_front(key);
+    m_cacheBytes += asset->body.size();
+    m_entries.emplace(key, CacheEntry { std::move(asset), m_lruList.begin() });
+
+    while (m_cacheBytes > m_maxCacheBytes && !m_lruList.empty())
+    {
+        EvictLocked(m_entries.find(m_lruList.back()));
+        m_evictions++;
+    }
+}
+
+void AssetCache::EvictLocked(std::unordered_map<std::string, CacheEntry>::iterator entryIterator)
+{
+    m_cacheBytes -= entryIterator->second.asset->body.size();
+    m_lruList.erase(entryIterator->second.lruIterator);
+    m_entries.erase(entryIterator);
+}
+
+std::optional<std::string> AssetCache::GetContentHash(const std::filesystem::path& filePath, const AssetLoader& loader)
+{
+    std::shared_ptr<const Asset> asset = this->Get(filePath, loader);
+
+    if (!asset || asset->contentHash.empty())
+    {
+        return std::nullopt;
+    }
+    return asset->contentHash;
+}
+
+unsigned long long AssetCache::GetInvalidationEpoch() const
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    return m_invalidationEpoch;
+}
+
+void AssetCache::Invalidate(const std::filesystem::path& filePath)
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_invalidationEpoch++;
+
+    auto entryIterator = m_entries.find(filePath.generic_string());
+    if (entryIterator != m_entries.end())
+    {
+        EvictLocked(entryIterator);
+        m_invalidations++;
+    }
+}
+
+/**
+ * Starts watching the directory if it isn't already, directories that can't be watched are remembered 
+ * so they are only attempted once.
+ * 
+ * @returns {bool} - `true` if the directory is watched. 
+ */
+bool AssetCache::WatchDirectoryLocked(const std::filesystem::path& directory)
+{
+    const std::string directoryKey = directory.generic_string();
+    auto watchIterator = m_watchedDirectories.find(directoryKey);
+
+    if (watchIterator != m_watchedDirectories.end())
+    {
+        return watchIterator->second;
+    }
+
+    const bool isWatched = FileWatcher::get().WatchDirectory(directory, [this](const std::filesystem::path& changedPath) {
+        this->OnFileChanged(changedPath);
+    });
+
+    m_watchedDirectories.emplace(directoryKey, isWatched);
+    return isWatched;
+}
+
+void AssetCache::OnFileChanged(const std::filesystem::path& changedPath)
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_invalidationEpoch++;
+
+    const std::string changedKey = changedPath.generic_string();
+    auto watchIterator = m_watchedDirectories.find(changedKey);
+
+    /** The watched directory itself was removed, drop everything in it and forget the watch. */
+    if (watchIterator != m_watchedDirectories.end())
+    {
+        m_watchedDirectories.erase(watchIterator);
+
+        for (auto entryIterator = m_entries.begin(); entryIterator != m_entries.end(); )
+        {
+            auto currentIterator = entryIterator++;
+
+            if (std::filesystem::path(currentIterator->first).parent_path().generic_string() == changedKey)
+            {
+                EvictLocked(currentIterator);
+                m_invalidations++;
+            }
+        }
+        return;
+    }
+
+    auto entryIterator = m_entries.find(changedKey);
+    if (entryIterator != m_entries.end())
+    {
+        EvictLocked(entryIterator);
+        m_invalidations++;
+    }
+}
+
+void AssetCache::ExcludeDirectory(const std::filesystem::path& directory)
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    const std::string directoryKey = directory.generic_string();
+
+    m_excludedDirectories.insert(directoryKey);
+    /** Marked as unwatchable, so it's never attempted. */
+    m_watchedDirectories.emplace(directoryKey, false);
+}
+
+AssetCache::Stats AssetCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    return { m_hits.load(), m_misses.load(), m_coalesced.load(), m_evictions.load(), m_invalidations.load(), m_entries.size(), m_cacheBytes };
+}
+
+void AssetCache::LogStats(unsigned long long lookupCount)
+{
+    const Stats stats = this->GetStats();
+    Logger.Log("Asset cache: {} lookups, {} hits, {} misses, {} coalesced, {} evictions, {} invalidations, {} entries ({} KiB)", 
+        lookupCount, stats.hits, stats.misses, stats.coalesced, stats.evictions, stats.invalidations, stats.entries, stats.bytes / 1024);
+}
@@ -0,0 +1,464 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "asset_pack.h"
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <fmt/core.h>
+#include "internal_logger.h"
+#include "hash.h"
+#include "env.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static constexpr char g_packMagic[8] = { 'M', 'L', 'N', 'M', 'P', 'A', 'C', 'K' };
+static constexpr size_t g_packHeaderSize = sizeof(g_packMagic) + 2 * sizeof(std::uint64_t);
+
+/**
+ * @brief A read-only view of a whole file.
+ */
+class MappedFile
+{
+public:
+    static std::unique_ptr<MappedFile> Open(const std::filesystem::path& filePath)
+    {
+        auto mappedFile = std::unique_ptr<MappedFile>(new MappedFile());
+
+        #ifdef _WIN32
+        HANDLE fileHandle = CreateFileW(filePath.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE) return nullptr;
+
+        LARGE_INTEGER fileSize;
+        HANDLE mappingHandle = GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0 ? CreateFileMappingW(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+
+        /** The view keeps the file mapped on its own. */
+        const void* view = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+        if (mappingHandle) CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+
+        if (!view) return nullptr;
+
+        mappedFile->m_data = static_cast<const char*>(view);
+        mappedFile->m_size = static_cast<size_t>(fileSize.QuadPart);
+        #else
+        const int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+        if (fileDescriptor == -1) return nullptr;
+
+        struct stat fileStatus;
+        void* view = fstat(fileDescriptor, &fileStatus) == 0 && fileStatus.st_size > 0 
+            ? mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0) : MAP_FAILED;
+
+        close(fileDescriptor);
+
+        if (view == MAP_FAILED) return nullptr;
+
+        mappedFile->m_data = static_cast<const char*>(view);
+        mappedFile->m_size = static_cast<size_t>(fileStatus.st_size);
+        #endif
+
+        return mappedFile;
+    }
+
+    ~MappedFile()
+    {
+        if (!m_data) return;
+
+        #ifdef _WIN32
+        UnmapViewOfFile(m_data);
+        #else
+        munmap(const_cast<char*>(m_data), m_size);
+        #endif
+    }
+
+    const char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    MappedFile() = default;
+
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+AssetPack::~AssetPack() = default;
+
+std::shared_ptr<const AssetPack> AssetPack::Open(const std::filesystem::path& packPath)
+{
+    std::unique_ptr<MappedFile> mapping = MappedFile::Open(packPath);
+
+    if (!mapping || mapping->Size() < g_packHeaderSize || std::memcmp(mapping->Data(), g_packMagic, sizeof(g_packMagic)) != 0)
+    {
+        return nullptr;
+    }
+
+    std::uint64_t indexOffset, indexLength;
+    std::memcpy(&indexOffset, mapping->Data() + sizeof(g_packMagic), sizeof(indexOffset));
+    std::memcpy(&indexLength, mapping->Data() + sizeof(g_packMagic) + sizeof(indexOffset), sizeof(indexLength));
+
+    if (indexOffset < g_packHeaderSize || indexOffset > mapping->Size() || indexLength > mapping->Size() - indexOffset)
+    {
+        return nullptr;
+    }
+
+    auto pack = std::shared_ptr<AssetPack>(new AssetPack());
+
+    try
+    {
+        const char* indexStart = mapping->Data() + indexOffset;
+        const nlohmann::json index = nlohmann::json::parse(indexStart, indexStart + indexLength);
+
+        for (const auto& entry : index.at("entries"))
+        {
+            const std::uint64_t offset = entry.at("offset").get<std::uint64_t>();
+            const std::uint64_t length = entry.at("length").get<std::uint64_t>();
+
+            /** Bodies live between the header and the index. */
+            if (offset < g_packHeaderSize || offset > indexOffset || length > indexOffset - offset)
+            {
+                return nullptr;
+            }
+
+            pack->m_entries.emplace(entry.at("path").get<std::string>(), Entry {
+                offset,
+                length,
+                entry.at("contentHash").get<std::string>(),
+                entry.at("headers"),
+                entry.at("fileSize").get<std::uintmax_t>(),
+                std::filesystem::file_time_type(std::filesystem::file_time_type::duration(entry.at("lastWriteTime").get<std::int64_t>()))
+            });
+        }
+    }
+    catch (const nlohmann::detail::exception& error)
+    {
+        LOG_ERROR("Malformed asset pack '{}': {}", packPath.string(), error.what());
+        return nullptr;
+    }
+
+    pack->m_mapping = std::move(mapping);
+    return pack;
+}
+
+bool AssetPack::Write(const std::filesystem::path& packPath, const std::vector<std::filesystem::path>& files, const AssetCache::AssetLoader& loader)
+{
+    std::ofstream packFile(packPath, std::ios::binary | std::ios::trunc);
+
+    if (!packFile)
+    {
+        return false;
+    }
+
+    /** The index location is filled in once the bodies are written. */
+    const char emptyHeader[g_packHeaderSize] = {};
+    packFile.write(emptyHeader, sizeof(emptyHeader));
+
+    nlohmann::json entries = nlohmann::json::array();
+    std::uint64_t offset = g_packHeaderSize;
+
+    for (const auto& filePath : files)
+    {
+        std::error_code errorCode;
+        const auto fileSize      = std::filesystem::file_size(filePath, errorCode);
+        const auto lastWriteTime = std::filesystem::last_write_time(filePath, errorCode);
+
+        if (errorCode) continue;
+
+        std::shared_ptr<AssetCache::Asset> asset;
+        try
+        {
+            asset = loader(filePath);
+        }
+        catch (const std::exception&) { }
+
+        if (!asset) continue;
+
+        packFile.write(asset->body.data(), static_cast<std::streamsize>(asset->body.size()));
+
+        entries.push_back({
+            { "path", filePath.generic_string() },
+            { "offset", offset },
+            { "length", asset->body.size() },
+            { "contentHash", asset->contentHash },
+            { "headers", asset->headers },
+            { "fileSize", fileSize },
+            { "lastWriteTime", static_cast<std::int64_t>(lastWriteTime.time_since_epoch().count()) }
+        });
+        offset += asset->body.size();
+    }
+
+    const std::string index = nlohmann::json({ { "entries", entries } }).dump();
+    const std::uint64_t indexLength = index.size();
+    packFile.write(index.data(), static_cast<std::streamsize>(index.size()));
+
+    packFile.seekp(0);
+    packFile.write(g_packMagic, sizeof(g_packMagic));
+    packFile.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    packFile.write(reinterpret_cast<const char*>(&indexLength), sizeof(indexLength));
+
+    return static_cast<bool>(packFile.flush());
+}
+
+std::shared_ptr<AssetCache::Asset> AssetPack::Find(const std::filesystem::path& filePath) const
+{
+    const auto entryIterator = m_entries.find(filePath.generic_string());
+
+    if (entryIterator == m_entries.end())
+    {
+        return nullptr;
+    }
+
+    const Entry& entry = entryIterator->second;
+
+    /** Much cheaper than reading the file, and the loose file stays authoritative. */
+    std::error_code errorCode;
+    const auto fileSize      = std::filesystem::file_size(filePath, errorCode);
+    const auto lastWriteTime = std::filesystem::last_write_time(filePath, errorCode);
+
+    if (errorCode || fileSize != entry.fileSize || lastWriteTime != entry.lastWriteTime)
+    {
+        return nullptr;
+    }
+
+    auto asset = std::make_shared<AssetCache::Asset>();
+    asset->body.assign(m_mapping->Data() + entry.offset, entry.length);
+    asset->headers       = entry.headers;
+    asset->contentHash   = entry.contentHash;
+    asset->fileSize      = entry.fileSize;
+    asset->lastWriteTime = entry.lastWriteTime;
+    return asset;
+}
+
+size_t AssetPack::EntryCount() const
+{
+    return m_entries.size();
+}
+
+AssetPackManager& AssetPackManager::get()
+{
+    static AssetPackManager instance;
+    return instance;
+}
+
+AssetPackManager::AssetPackManager() : m_packDirectory(std::filesystem::path(GetEnv("MILLENNIUM__CONFIG_PATH")) / "packs")
+{
+    m_workerThread = std::thread(&AssetPackManager::WorkerThread, this);
+}
+
+AssetPackManager::~AssetPackManager()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mountMutex);
+        m_stop = true;
+    }
+    m_queueCondition.notify_all();
+
+    if (m_workerThread.joinable())
+    {
+        m_workerThread.join();
+    }
+}
+
+void AssetPackManager::Mount(const std::filesystem::path& rootDirectory, AssetCache::AssetLoader loader)
+{
+    const std::string rootKey = rootDirectory.generic_string();
+    {
+        std::lock_guard<std::mutex> lock(m_mountMutex);
+        m_mountedRoots[rootKey].loader = std::move(loader);
+    }
+
+    /** Remounting checks the directory again, an unchanged directory keeps its pack. */
+    Enqueue(rootKey, std::chrono::steady_clock::now());
+}
+
+void AssetPackManager::Enqueue(const std::string& rootKey, std::chrono::steady_clock::time_point notBefore)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mountMutex);
+        MountedRoot& mountedRoot = m_mountedRoots[rootKey];
+
+        if (mountedRoot.isQueued || m_stop) return;
+
+        mountedRoot.isQueued = true;
+        m_queue.emplace_back(rootKey, notBefore);
+    }
+    m_queueCondition.notify_one();
+}
+
+std::shared_ptr<AssetCache::Asset> AssetPackManager::Find(const std::filesystem::path& filePath)
+{
+    const std::string fileKey = filePath.generic_string();
+    std::string rootKey;
+    std::shared_ptr<const AssetPack> pack;
+    {
+        std::lock_guard<std::mutex> lock(m_mountMutex);
+
+        for (const auto& [mountedKey, mountedRoot] : m_mountedRoots)
+        {
+            if (fileKey.size() > mountedKey.size() && fileKey[mountedKey.size()] == '/' && fileKey.compare(0, mountedKey.size(), mountedKey) == 0)
+            {
+                rootKey = mountedKey;
+                pack = mountedRoot.pack;
+                break;
+            }
+        }
+    }
+
+    if (!pack)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<AssetCache::Asset> asset = pack->Find(filePath);
+
+    /** The file changed or was added since the pack was built, it's served loose until the pack is rebuilt. */
+    std::error_code errorCode;
+    if (!asset && std::filesystem::file_size(filePath, errorCode) <= m_maxPackedFileSize && !errorCode)
+    {
+        Enqueue(rootKey, std::chrono::steady_clock::now() + m_rebuildDelay);
+    }
+    return asset;
+}
+
+void AssetPackManager::WorkerThread()
+{
+    while (true)
+    {
+        std::string rootKey;
+        AssetCache::AssetLoader loader;
+        {
+            std::unique_lock<std::mutex> lock(m_mountMutex);
+            m_queueCondition.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+
+            if (m_stop) return;
+
+            const auto notBefore = m_queue.front().second;
+
+            if (std::chrono::steady_clock::now() < notBefore)
+            {
+                m_queueCondition.wait_until(lock, notBefore, [this] { return m_stop; });
+                continue;
+            }
+
+            rootKey = std::move(m_queue.front().first);
+            m_queue.pop_front();
+
+            MountedRoot& mountedRoot = m_mountedRoots[rootKey];
+            mountedRoot.isQueued = false;
+            loader = mountedRoot.loader;
+        }
+
+        try
+        {
+            BuildPack(rootKey, loader);
+        }
+        catch (const std::exception& error)
+        {
+            LOG_ERROR("Failed to build the asset pack of '{}': {}", rootKey, error.what());
+        }
+    }
+}
+
+void AssetPackManager::BuildPack(const std::string& rootKey, const AssetCache::AssetLoader& loader)
+{
+    std::vector<std::filesystem::path> files;
+    std::string manifest;
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(rootKey, std::filesystem::directory_options::skip_permission_denied))
+    {
+        std::error_code errorCode;
+        if (entry.is_regular_file(errorCode) && entry.file_size(errorCode) <= m_maxPackedFileSize && !errorCode)
+        {
+            files.push_back(entry.path());
+        }
+    }
+
+    std::sort(files.begin(), files.end());
+
+    /** Packs are named after the directory's state, a directory that didn't change reuses its pack. */
+    for (const auto& filePath : files)
+    {
+        std::error_code errorCode;
+        manifest += fmt::format("{}:{}:{}\n", filePath.generic_string(), std::filesystem::file_size(filePath, errorCode), 
+            std::filesystem::last_write_time(filePath, errorCode).time_since_epoch().count());
+    }
+
+    const std::string rootPrefix = fmt::format("{:016x}-", Fnv1a64(rootKey.data(), rootKey.size()));
+    const std::filesystem::path packPath = m_packDirectory / fmt::format("{}{:016x}.pack", rootPrefix, Fnv1a64(manifest.data(), manifest.size()));
+
+    std::shared_ptr<const AssetPack> pack = AssetPack::Open(packPath);
+
+    if (!pack)
+    {
+        std::filesystem::create_directories(m_packDirectory);
+
+        const std::filesystem::path temporaryPath = packPath.string() + ".tmp";
+
+        if (!AssetPack::Write(temporaryPath, files, loader))
+        {
+            LOG_ERROR("Failed to write the asset pack of '{}'", rootKey);
+            return;
+        }
+
+        std::filesystem::rename(temporaryPath, packPath);
+        pack = AssetPack::Open(packPath);
+
+        if (!pack)
+        {
+            LOG_ERROR("Failed to map the asset pack of '{}'", rootKey);
+            return;
+        }
+        Logger.Log("Built asset pack of '{}' ({} files)", rootKey, pack->EntryCount());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mountMutex);
+        m_mountedRoots[rootKey].pack = pack;
+    }
+
+    /** Superseded packs of the directory, a pack that is still mapped elsewhere is removed on the next build. */
+    for (const auto& entry : std::filesystem::directory_iterator(m_packDirectory))
+    {
+        const std::string fileName = entry.path().filename().string();
+
+        if (fileName.rfind(rootPrefix, 0) == 0 && entry.path() != packPath)
+        {
+            std::error_code errorCode;
+            std::filesystem::remove(entry.path(), errorCode);
+        }
+    }
+}
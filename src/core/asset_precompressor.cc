@@ -0,0 +1,233 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "asset_precompressor.h"
+#include <array>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <zlib.h>
+#include "internal_logger.h"
+#include "locals.h"
+#include "hash.h"
+#include "env.h"
+#include "asset_cache.h"
+
+static constexpr std::array<const char*, 8> g_compressibleExtensions = {
+    ".css", ".js", ".mjs", ".json", ".map", ".svg", ".html", ".txt"
+};
+
+AssetPrecompressor& AssetPrecompressor::get()
+{
+    static AssetPrecompressor instance;
+    return instance;
+}
+
+AssetPrecompressor::AssetPrecompressor() : m_variantDirectory(std::filesystem::path(GetEnv("MILLENNIUM__CONFIG_PATH")) / "compressed")
+{
+    /** Writing a variant must not invalidate the shims and bundles, see AssetCache::ExcludeDirectory */
+    AssetCache::get().ExcludeDirectory(m_variantDirectory);
+    m_workerThread = std::thread(&AssetPrecompressor::WorkerThread, this);
+}
+
+AssetPrecompressor::~AssetPrecompressor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stop = true;
+    }
+    m_queueCondition.notify_all();
+
+    if (m_workerThread.joinable())
+    {
+        m_workerThread.join();
+    }
+}
+
+bool AssetPrecompressor::IsCompressible(const std::filesystem::path& filePath)
+{
+    const std::string extension = filePath.extension().string();
+    return std::find(g_compressibleExtensions.begin(), g_compressibleExtensions.end(), extension) != g_compressibleExtensions.end();
+}
+
+std::filesystem::path AssetPrecompressor::VariantPath(const std::filesystem::path& filePath) const
+{
+    const std::string sourcePath = filePath.lexically_normal().generic_string();
+    return m_variantDirectory / fmt::format("{:016x}-{}.gz", Fnv1a64(sourcePath.data(), sourcePath.size()), filePath.filename().string());
+}
+
+/**
+ * Gets a key that changes whenever the file does, so failures are retried once the file is updated.
+ */
+static std::string FailureKey(const std::filesystem::path& filePath)
+{
+    std::error_code errorCode;
+    const auto lastWriteTime = std::filesystem::last_write_time(filePath, errorCode);
+
+    return fmt::format("{}|{}", filePath.generic_string(), errorCode ? 0 : lastWriteTime.time_since_epoch().count());
+}
+
+void AssetPrecompressor::Enqueue(const std::filesystem::path& filePath)
+{
+    if (!IsCompressible(filePath))
+    {
+        return;
+    }
+
+    const std::string failureKey = FailureKey(filePath);
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+
+        if (m_failed.count(failureKey) || !m_queued.insert(filePath.generic_string()).second)
+        {
+            return;
+        }
+        m_queue.push_back(filePath);
+    }
+    m_queueCondition.notify_one();
+}
+
+void AssetPrecompressor::WorkerThread()
+{
+    while (true)
+    {
+        std::filesystem::path filePath;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCondition.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+
+            /** Pending work is dropped on shutdown, variants are rebuilt on the next start. */
+            if (m_stop) return;
+
+            filePath = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        const bool success = CompressFile(filePath);
+
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_queued.erase(filePath.generic_string());
+
+        if (!success)
+        {
+            m_failed.insert(FailureKey(filePath));
+        }
+    }
+}
+
+/**
+ * Compresses the file with gzip into its variant path, unless the variant is already up to date. 
+ * The variant is written to a temporary file first, so a half written variant is never served.
+ * 
+ * @returns {boolean} - `false` if the file won't have a variant, i.e. it's too small, doesn't compress well or can't be written.
+ */
+bool AssetPrecompressor::CompressFile(const std::filesystem::path& filePath)
+{
+    std::error_code errorCode;
+    const auto fileSize = std::filesystem::file_size(filePath, errorCode);
+    if (errorCode) return false;
+
+    const auto lastWriteTime = std::filesystem::last_write_time(filePath, errorCode);
+    if (errorCode) return false;
+
+    const std::filesystem::path variantPath = VariantPath(filePath);
+    const auto variantWriteTime = std::filesystem::last_write_time(variantPath, errorCode);
+
+    if (!errorCode && variantWriteTime == lastWriteTime)
+    {
+        return true;
+    }
+
+    if (fileSize < m_minimumFileSize)
+    {
+        return false;
+    }
+
+    const std::vector<char> fileBytes = SystemIO::ReadFileBytesSync(filePath.string());
+
+    z_stream stream {};
+    /** 15 window bits + 16 writes a gzip header and trailer instead of a raw zlib stream. */
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return false;
+    }
+
+    std::vector<char> compressed(deflateBound(&stream, static_cast<uLong>(fileBytes.size())));
+
+    stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(fileBytes.data()));
+    stream.avail_in  = static_cast<uInt>(fileBytes.size());
+    stream.next_out  = reinterpret_cast<Bytef*>(compressed.data());
+    stream.avail_out = static_cast<uInt>(compressed.size());
+
+    const int result = deflate(&stream, Z_FINISH);
+    compressed.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if (result != Z_STREAM_END)
+    {
+        LOG_ERROR("Failed to compress '{}'", filePath.string());
+        return false;
+    }
+
+    /** Keep the original if compression doesn't make a meaningful difference. */
+    if (compressed.size() > fileBytes.size() * 9 / 10)
+    {
+        return false;
+    }
+
+    const std::filesystem::path temporaryPath = std::filesystem::path(variantPath.string() + ".tmp");
+    std::filesystem::create_directories(m_variantDirectory, errorCode);
+    {
+        std::ofstream variantFile(temporaryPath, std::ios::binary | std::ios::trunc);
+        variantFile.write(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+
+        if (!variantFile)
+        {
+            std::filesystem::remove(temporaryPath, errorCode);
+            return false;
+        }
+    }
+
+    /** The variant is stamped with the original's write time, a mismatch means it's stale. */
+    std::filesystem::last_write_time(temporaryPath, lastWriteTime, errorCode);
+    if (!errorCode) 
+    {
+        std::filesystem::rename(temporaryPath, variantPath, errorCode);
+    }
+
+    if (errorCode)
+    {
+        std::filesystem::remove(temporaryPath, errorCode);
+        return false;
+    }
+
+    Logger.Log("Precompressed '{}' ({} KiB -> {} KiB)", filePath.filename().string(), fileBytes.size() / 1024, compressed.size() / 1024);
+    return true;
+}
@@ -0,0 +1,68 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "byte_range.h"
+#include <regex>
+#include <algorithm>
+#include <stdexcept>
+
+bool ParseByteRange(const std::string& rangeHeader, std::uintmax_t fileSize, std::uintmax_t& firstByte, std::uintmax_t& lastByte, bool& isSatisfiable)
+{
+    static const std::regex byteRangePattern(R"(^\s*bytes\s*=\s*(\d*)\s*-\s*(\d*)\s*$)", std::regex::icase);
+    std::smatch rangeMatch;
+
+    if (!std::regex_match(rangeHeader, rangeMatch, byteRangePattern) || (rangeMatch[1].length() == 0 && rangeMatch[2].length() == 0))
+    {
+        return false;
+    }
+
+    try
+    {
+        if (rangeMatch[1].length() == 0)
+        {
+            /** Suffix range, the last N bytes of the file. */
+            const std::uintmax_t suffixLength = std::stoull(rangeMatch[2].str());
+
+            isSatisfiable = suffixLength > 0 && fileSize > 0;
+            firstByte = suffixLength >= fileSize ? 0 : fileSize - suffixLength;
+            lastByte  = fileSize - 1;
+            return true;
+        }
+
+        firstByte = std::stoull(rangeMatch[1].str());
+        lastByte  = rangeMatch[2].length() ? std::min<std::uintmax_t>(std::stoull(rangeMatch[2].str()), fileSize - 1) : fileSize - 1;
+        isSatisfiable = firstByte < fileSize && firstByte <= lastByte;
+        return true;
+    }
+    catch (const std::out_of_range&)
+    {
+        return false;
+    }
+}
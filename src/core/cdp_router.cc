@@ -0,0 +1,510 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cdp_router.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include "internal_logger.h"
+
+CdpRouter& CdpRouter::get()
+{
+    static CdpRouter instance;
+    return instance;
+}
+
+CdpRouter::CdpRouter() : m_subscriptions(std::make_shared<const Subscriptions>()) 
+{
+    if (const char* recordingPath = std::getenv("MILLENNIUM__RECORD_CDP_PATH"))
+    {
+        m_recording.open(recordingPath, std::ios::binary | std::ios::app);
+        Logger.Warn("Recording CDP traffic to '{}'", recordingPath);
+    }
+}
+
+std::shared_ptr<const CdpRouter::Subscriptions> CdpRouter::GetSubscriptions() const
+{
+    return std::atomic_load(&m_subscriptions);
+}
+
+/**
+ * Checks if any subscriber of the method only wants the events of one session.
+ */
+bool CdpRouter::IsSessionFiltered(std::string_view method) const
+{
+    const std::shared_ptr<const Subscriptions> subscriptions = GetSubscriptions();
+    const auto subscribers = subscriptions->events.find(method);
+
+    if (subscribers == subscriptions->events.end())
+    {
+        return false;
+    }
+
+    return std::any_of(subscribers->second.begin(), subscribers->second.end(), [](const Subscriber& subscriber) { 
+        return !subscriber.sessionId.empty(); 
+    });
+}
+
+long long CdpRouter::NextCallId()
+{
+    return m_nextCallId.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CdpRouter::ExpectReply(long long callId, Handler handler)
+{
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    m_pendingReplies[callId] = std::move(handler);
+}
+
+void CdpRouter::CancelReply(long long callId)
+{
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    m_pendingReplies.erase(callId);
+}
+
+size_t CdpRouter::ClearPendingReplies()
+{
+    decltype(m_pendingReplies) droppedReplies;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        droppedReplies.swap(m_pendingReplies);
+    }
+
+    /** Handlers are called outside the lock, they may make calls of their own. */
+    for (const auto& [callId, handler] : droppedReplies)
+    {
+        Invoke(handler, {
+            { "id", callId },
+            { "error", {
+                { "code", m_connectionLostCode },
+                { "message", "The connection to the browser was lost before the call was answered." }
+            }}
+        }, "dropped reply");
+    }
+    return droppedReplies.size();
+}
+
+bool CdpRouter::IsConnectionLost(const nlohmann::json& reply)
+{
+    return reply.contains("error") && reply["error"].value("code", 0) == m_connectionLostCode;
+}
+
+CdpRouter::SubscriptionId CdpRouter::RouteReplies(long long firstId, long long lastId, Handler handler)
+{
+    std::lock_guard<std::mutex> lock(m_subscriptionWriteMutex);
+
+    auto subscriptions = std::make_shared<Subscriptions>(*GetSubscriptions());
+    const SubscriptionId subscriptionId = m_nextSubscriptionId++;
+
+    subscriptions->replyRanges.push_back({ subscriptionId, firstId, lastId, std::move(handler) });
+    std::atomic_store(&m_subscriptions, std::shared_ptr<const Subscriptions>(std::move(subscriptions)));
+    return subscriptionId;
+}
+
+CdpRouter::SubscriptionId CdpRouter::Subscribe(const std::string& method, Handler handler, const std::string& sessionId)
+{
+    std::lock_guard<std::mutex> lock(m_subscriptionWriteMutex);
+
+    auto subscriptions = std::make_shared<Subscriptions>(*GetSubscriptions());
+    const SubscriptionId subscriptionId = m_nextSubscriptionId++;
+
+    subscriptions->events[method].push_back({ subscriptionId, sessionId, std::move(handler) });
+    std::atomic_store(&m_subscriptions, std::shared_ptr<const Subscriptions>(std::move(subscriptions)));
+    return subscriptionId;
+}
+
+void CdpRouter::Unsubscribe(SubscriptionId subscriptionId)
+{
+    std::lock_guard<std::mutex> lock(m_subscriptionWriteMutex);
+
+    auto subscriptions = std::make_shared<Subscriptions>(*GetSubscriptions());
+
+    for (auto eventIterator = subscriptions->events.begin(); eventIterator != subscriptions->events.end(); )
+    {
+        auto& subscribers = eventIterator->second;
+        subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(), [subscriptionId](const Subscriber& subscriber) { 
+            return subscriber.id == subscriptionId; 
+        }), subscribers.end());
+
+        eventIterator = subscribers.empty() ? subscriptions->events.erase(eventIterator) : std::next(eventIterator);
+    }
+
+    auto& replyRanges = subscriptions->replyRanges;
+    replyRanges.erase(std::remove_if(replyRanges.begin(), replyRanges.end(), [subscriptionId](const ReplyRange& replyRange) { 
+        return replyRange.id == subscriptionId; 
+    }), replyRanges.end());
+
+    std::atomic_store(&m_subscriptions, std::shared_ptr<const Subscriptions>(std::move(subscriptions)));
+}
+
+/**
+ * Runs a handler, an exception thrown by one handler doesn't keep the message from the others.
+ */
+void CdpRouter::Invoke(const Handler& handler, const nlohmann::json& message, const char* kind)
+{
+    try
+    {
+        handler(message);
+    }
+    catch (const std::exception& error)
+    {
+        m_handlerErrors++;
+        LOG_ERROR("CDP {} handler threw -> {}", kind, error.what());
+    }
+}
+
+/**
+ * Skips the JSON string starting at the opening quote at `position`.
+ * @returns The position after the closing quote, or npos if the string isn't terminated.
+ */
+static size_t SkipString(std::string_view payload, size_t position)
+{
+    while (true)
+    {
+        position = payload.find('"', position + 1);
+
+        if (position == std::string_view::npos)
+        {
+            return position;
+        }
+
+        /** The quote is escaped if it's preceded by an odd number of backslashes. */
+        size_t backslashCount = 0;
+        while (payload[position - 1 - backslashCount] == '\\') backslashCount++;
+
+        if (backslashCount % 2 == 0)
+        {
+            return position + 1;
+        }
+    }
+}
+
+/**
+ * Skips the JSON value starting at `position`, nested objects and arrays are skipped without looking at their keys.
+ * @returns The position after the value, or npos if the payload ends early.
+ */
+static size_t SkipValue(std::string_view payload, size_t position)
+{
+    size_t depth = 0;
+
+    while (position < payload.size())
+    {
+        const char character = payload[position];
+
+        if (character == '"')
+        {
+            position = SkipString(payload, position);
+            if (position == std::string_view::npos) return position;
+            if (depth == 0) return position;
+            continue;
+        }
+
+        if (character == '{' || character == '[')
+        {
+            depth++;
+        }
+        else if (character == '}' || character == ']')
+        {
+            if (depth == 0) return position;
+            if (--depth == 0) return position + 1;
+        }
+        else if (depth == 0 && (character == ',' || std::isspace(static_cast<unsigned char>(character))))
+        {
+            return position;
+        }
+        position++;
+    }
+    return depth == 0 ? position : std::string_view::npos;
+}
+
+static size_t SkipWhitespace(std::string_view payload, size_t position)
+{
+    while (position < payload.size() && std::isspace(static_cast<unsigned char>(payload[position]))) position++;
+    return position;
+}
+
+/**
+ * Reads a JSON string without escapes, which is all ids, methods and session ids ever are.
+ */
+static bool ReadPlainString(std::string_view payload, size_t& position, std::string_view& value)
+{
+    const size_t end = SkipString(payload, position);
+
+    if (end == std::string_view::npos || payload.substr(position + 1, end - position - 2).find('\\') != std::string_view::npos)
+    {
+        return false;
+    }
+
+    value = payload.substr(position + 1, end - position - 2);
+    position = end;
+    return true;
+}
+
+bool CdpRouter::ScanFrameHeader(std::string_view payload, FrameHeader& header, bool stopAtMethod)
+{
+    size_t position = SkipWhitespace(payload, 0);
+
+    if (position >= payload.size() || payload[position] != '{')
+    {
+        return false;
+    }
+
+    position = SkipWhitespace(payload, position + 1);
+
+    if (position < payload.size() && payload[position] == '}')
+    {
+        return true;
+    }
+
+    while (position < payload.size())
+    {
+        std::string_view key;
+
+        if (payload[position] != '"' || !ReadPlainString(payload, position, key))
+        {
+            return false;
+        }
+
+        position = SkipWhitespace(payload, position);
+        if (position >= payload.size() || payload[position] != ':') return false;
+        position = SkipWhitespace(payload, position + 1);
+        if (position >= payload.size()) return false;
+
+        if (key == "id")
+        {
+            const bool isNegative = payload[position] == '-';
+            size_t digitPosition = position + (isNegative ? 1 : 0), digitCount = 0;
+            long long callId = 0;
+
+            for (; digitPosition < payload.size() && std::isdigit(static_cast<unsigned char>(payload[digitPosition])); digitPosition++, digitCount++)
+            {
+                callId = callId * 10 + (payload[digitPosition] - '0');
+            }
+
+            /** Not a plain integer, i.e. 1.5, the full parse decides what it is. */
+            if (digitCount == 0 || digitCount > 18 || (digitPosition < payload.size() && (payload[digitPosition] == '.' || payload[digitPosition] == 'e' || payload[digitPosition] == 'E')))
+            {
+                return false;
+            }
+
+            if (isNegative) callId = -callId;
+            header.id = callId;
+
+            /** Replies are routed by id alone, the rest of the frame (i.e. a response body) isn't looked at. */
+            return true;
+        }
+        else if (key == "method" || key == "sessionId")
+        {
+            const bool isMethod = key == "method";
+
+            if (payload[position] != '"' || !ReadPlainString(payload, position, isMethod ? header.method : header.sessionId))
+            {
+                return false;
+            }
+
+            /** Messages carry either an id or a method, an event's params don't have to be skipped to route it. */
+            if (isMethod && stopAtMethod)
+            {
+                return true;
+            }
+        }
+        else
+        {
+            position = SkipValue(payload, position);
+            if (position == std::string_view::npos) return false;
+        }
+
+        position = SkipWhitespace(payload, position);
+        if (position >= payload.size()) return false;
+
+        if (payload[position] == '}') return true;
+        if (payload[position] != ',') return false;
+
+        position = SkipWhitespace(payload, position + 1);
+    }
+    return false;
+}
+
+template <typename GetMessage>
+void CdpRouter::Dispatch(const FrameHeader& header, GetMessage&& getMessage)
+{
+    if (header.id.has_value())
+    {
+        const long long callId = header.id.value();
+        Handler handler;
+        {
+            std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+            if (auto pendingReply = m_pendingReplies.find(callId); pendingReply != m_pendingReplies.end())
+            {
+                handler = std::move(pendingReply->second);
+                m_pendingReplies.erase(pendingReply);
+            }
+        }
+
+        if (handler)
+        {
+            m_routedReplies++;
+            Invoke(handler, getMessage(), "reply");
+            return;
+        }
+
+        const std::shared_ptr<const Subscriptions> subscriptions = GetSubscriptions();
+
+        for (const ReplyRange& replyRange : subscriptions->replyRanges)
+        {
+            if (callId >= replyRange.firstId && callId <= replyRange.lastId)
+            {
+                m_routedReplies++;
+                Invoke(replyRange.handler, getMessage(), "reply");
+                return;
+            }
+        }
+
+        /** Fire and forget calls, i.e. the `"id": 0` ones. */
+        m_unmatchedReplies++;
+        return;
+    }
+
+    if (header.method.empty())
+    {
+        return;
+    }
+
+    const std::shared_ptr<const Subscriptions> subscriptions = GetSubscriptions();
+    const auto subscribers = subscriptions->events.find(header.method);
+
+    if (subscribers == subscriptions->events.end())
+    {
+        m_unmatchedEvents++;
+        return;
+    }
+
+    bool isRouted = false;
+
+    for (const Subscriber& subscriber : subscribers->second)
+    {
+        if (subscriber.sessionId.empty() || subscriber.sessionId == header.sessionId)
+        {
+            isRouted = true;
+            Invoke(subscriber.handler, getMessage(), "event");
+        }
+    }
+
+    isRouted ? m_routedEvents++ : m_unmatchedEvents++;
+}
+
+void CdpRouter::Route(const nlohmann::json& message)
+{
+    FrameHeader header;
+
+    const auto idIterator = message.find("id");
+    const auto methodIterator = message.find("method");
+    const auto sessionIterator = message.find("sessionId");
+
+    if (idIterator != message.end() && idIterator->is_number_integer()) header.id = idIterator->get<long long>();
+    if (methodIterator != message.end() && methodIterator->is_string()) header.method = methodIterator->get_ref<const std::string&>();
+    if (sessionIterator != message.end() && sessionIterator->is_string()) header.sessionId = sessionIterator->get_ref<const std::string&>();
+
+    Dispatch(header, [&message]() -> const nlohmann::json& { return message; });
+}
+
+void CdpRouter::RouteFrame(std::string_view payload)
+{
+    FrameHeader header;
+
+    if (m_recording.is_open())
+    {
+        m_recording.write(payload.data(), payload.size()).put('\n');
+    }
+
+    bool isScanned = ScanFrameHeader(payload, header, true);
+
+    /** The rest of an event is only scanned for its session id if one of the method's subscribers is narrowed to a session. */
+    if (isScanned && !header.id.has_value() && !header.method.empty() && header.sessionId.empty() && IsSessionFiltered(header.method))
+    {
+        header = {};
+        isScanned = ScanFrameHeader(payload, header);
+    }
+
+    /** Anything the scanner doesn't understand is parsed in full, it only ever takes the fast path for well formed frames. */
+    if (!isScanned)
+    {
+        m_scanFallbacks++;
+        Route(nlohmann::json::parse(payload));
+        return;
+    }
+
+    std::optional<nlohmann::json> message;
+
+    Dispatch(header, [&]() -> const nlohmann::json& {
+        if (!message.has_value())
+        {
+            m_parsedFrames++;
+            message = nlohmann::json::parse(payload);
+        }
+        return *message;
+    });
+
+    if (!message.has_value())
+    {
+        m_skippedFrames++;
+    }
+}
+
+nlohmann::json CdpRouter::GetMetrics() const
+{
+    size_t pendingReplies;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        pendingReplies = m_pendingReplies.size();
+    }
+
+    const std::shared_ptr<const Subscriptions> subscriptions = GetSubscriptions();
+    size_t subscriberCount = subscriptions->replyRanges.size();
+
+    for (const auto& [method, subscribers] : subscriptions->events)
+    {
+        subscriberCount += subscribers.size();
+    }
+
+    return {
+        { "routedReplies", m_routedReplies.load() },
+        { "routedEvents", m_routedEvents.load() },
+        { "unmatchedReplies", m_unmatchedReplies.load() },
+        { "unmatchedEvents", m_unmatchedEvents.load() },
+        { "handlerErrors", m_handlerErrors.load() },
+        { "parsedFrames", m_parsedFrames.load() },
+        { "skippedFrames", m_skippedFrames.load() },
+        { "scanFallbacks", m_scanFallbacks.load() },
+        { "pendingReplies", pendingReplies },
+        { "subscribers", subscriberCount }
+    };
+}
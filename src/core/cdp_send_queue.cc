@@ -0,0 +1,282 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cdp_send_queue.h"
+#include <algorithm>
+#include "internal_logger.h"
+
+CdpSendQueue& CdpSendQueue::get()
+{
+    static CdpSendQueue instance;
+    return instance;
+}
+
+void CdpSendQueue::Attach(Client* client, websocketpp::connection_hdl handle)
+{
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+
+    /** Frames queued for a previous connection belong to its sessions and request ids. */
+    m_queue.clear();
+    m_queuedBytes = 0;
+
+    m_client = client;
+    m_handle = std::move(handle);
+
+    websocketpp::lib::error_code errorCode;
+    m_connection = client->get_con_from_hdl(m_handle, errorCode);
+    m_drainingBytes = 0;
+    m_bufferedBytes = 0;
+    m_isBufferPollScheduled = false;
+    m_strand.emplace(asio::make_strand(client->get_io_service()));
+    m_ioThreadId = std::this_thread::get_id();
+    m_isDrainPosted = false;
+}
+
+void CdpSendQueue::Detach()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+
+        m_rejectedFrames += m_queue.size();
+        m_queue.clear();
+        m_queuedBytes = 0;
+        m_drainingBytes = 0;
+        m_bufferedBytes = 0;
+        m_client = nullptr;
+        m_connection.reset();
+    }
+    m_roomCondition.notify_all();
+}
+
+/**
+ * Gets the bytes that are queued, being handed to the connection, or waiting in its write buffer.
+ * @note The caller must hold m_queueMutex.
+ */
+size_t CdpSendQueue::GetUnsentBytesLocked() const
+{
+    return m_queuedBytes + m_drainingBytes + m_bufferedBytes.load(std::memory_order_relaxed);
+}
+
+/**
+ * @note The caller must hold m_queueMutex.
+ */
+bool CdpSendQueue::HasRoomLocked(size_t frameSize) const
+{
+    const size_t unsentBytes = GetUnsentBytesLocked();
+
+    /** A frame larger than the byte limit still goes through on its own. */
+    return (m_queue.empty() && unsentBytes == 0) || (m_queue.size() < m_maxQueuedFrames && unsentBytes + frameSize <= m_maxQueuedBytes);
+}
+
+bool CdpSendQueue::Enqueue(std::string frame)
+{
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+
+    if (m_client == nullptr)
+    {
+        return false;
+    }
+
+    if (!HasRoomLocked(frame.size()))
+    {
+        /** Waiting on the io thread would wait on ourselves, the drain can't run until we return. */
+        if (std::this_thread::get_id() == m_ioThreadId)
+        {
+            m_overflowFrames++;
+        }
+        else
+        {
+            m_blockedEnqueues++;
+
+            const Client* client = m_client;
+            const auto waitDeadline = std::chrono::steady_clock::now() + m_maxEnqueueWait;
+            bool hasRoom = false;
+
+            /** Drains and buffer polls notify, see PollBufferedAmount */
+            hasRoom = m_roomCondition.wait_until(lock, waitDeadline, [&] { 
+                return m_client != client || HasRoomLocked(frame.size()); 
+            });
+
+            if (!hasRoom || m_client != client)
+            {
+                m_rejectedFrames++;
+                Logger.Warn("Dropped a CDP message, the send queue stayed full ({} frames, {} bytes unsent)", m_queue.size(), GetUnsentBytesLocked());
+                return false;
+            }
+        }
+    }
+
+    m_queuedBytes += frame.size();
+    m_queue.push_back({ std::move(frame), std::chrono::steady_clock::now() });
+    m_peakDepth = std::max(m_peakDepth, m_queue.size());
+
+    /** One drain is posted per burst, frames queued before it runs are written along with it. */
+    if (!m_isDrainPosted)
+    {
+        m_isDrainPosted = true;
+        asio::post(*m_strand, [this] { Drain(); });
+    }
+    return true;
+}
+
+void CdpSendQueue::Drain()
+{
+    std::deque<QueuedFrame> frames;
+    Client* client;
+    websocketpp::connection_hdl handle;
+    Client::connection_ptr connection;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+
+        /** The frames still count towards the bound until they're in the connection's write buffer. */
+        frames.swap(m_queue);
+        m_drainingBytes += m_queuedBytes;
+        m_queuedBytes = 0;
+        m_isDrainPosted = false;
+        client = m_client;
+        handle = m_handle;
+        connection = m_connection;
+    }
+
+    if (client == nullptr || frames.empty())
+    {
+        return;
+    }
+
+    unsigned long long sentBytes = 0, sendErrors = 0;
+
+    for (const QueuedFrame& queuedFrame : frames)
+    {
+        websocketpp::lib::error_code errorCode;
+        client->send(handle, queuedFrame.frame, websocketpp::frame::opcode::text, errorCode);
+
+        if (errorCode)
+        {
+            if (sendErrors++ == 0) LOG_ERROR("Failed to send a CDP message: {}", errorCode.message());
+            continue;
+        }
+
+        sentBytes += queuedFrame.frame.size();
+        m_sendLatency.Record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - queuedFrame.enqueuedAt));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_drains++;
+        m_sentFrames += frames.size() - sendErrors;
+        m_sentBytes += sentBytes;
+        m_sendErrors += sendErrors;
+        m_largestBatch = std::max(m_largestBatch, frames.size());
+
+        /** A Detach or Attach since the swap already reset it for the new connection. */
+        if (connection == m_connection)
+        {
+            m_drainingBytes = 0;
+        }
+    }
+    PollBufferedAmount();
+}
+
+/**
+ * Takes a snapshot of the connection's write buffer, its size is only read here on the strand, where the 
+ * connection writes. While the socket is still writing, the buffer is polled again after m_bufferPollInterval 
+ * so waiting callers notice it emptying.
+ */
+void CdpSendQueue::PollBufferedAmount()
+{
+    Client* client;
+    Client::connection_ptr connection;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        client = m_client;
+        connection = m_connection;
+    }
+
+    const size_t bufferedBytes = connection ? connection->get_buffered_amount() : 0;
+    bool shouldPoll = false;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+
+        if (connection == m_connection)
+        {
+            m_bufferedBytes.store(bufferedBytes, std::memory_order_relaxed);
+            m_peakBufferedBytes = std::max(m_peakBufferedBytes, bufferedBytes);
+
+            shouldPoll = client != nullptr && bufferedBytes > 0 && !m_isBufferPollScheduled;
+            m_isBufferPollScheduled = m_isBufferPollScheduled || shouldPoll;
+        }
+    }
+    m_roomCondition.notify_all();
+
+    if (!shouldPoll)
+    {
+        return;
+    }
+
+    client->set_timer(static_cast<long>(m_bufferPollInterval.count()), [this, connection](const websocketpp::lib::error_code& errorCode)
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+
+        /** An Attach since then reset the flag for its own connection. */
+        if (connection != m_connection)
+        {
+            return;
+        }
+
+        m_isBufferPollScheduled = false;
+
+        if (!errorCode && m_strand)
+        {
+            asio::post(*m_strand, [this] { PollBufferedAmount(); });
+        }
+    });
+}
+
+nlohmann::json CdpSendQueue::GetMetrics() const
+{
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+
+    return {
+        { "depth", m_queue.size() },
+        { "queuedBytes", m_queuedBytes },
+        { "bufferedBytes", m_bufferedBytes.load(std::memory_order_relaxed) },
+        { "peakBufferedBytes", m_peakBufferedBytes },
+        { "peakDepth", m_peakDepth },
+        { "sentFrames", m_sentFrames },
+        { "sentBytes", m_sentBytes },
+        { "averageBatch", m_drains ? static_cast<double>(m_sentFrames) / m_drains : 0.0 },
+        { "largestBatch", m_largestBatch },
+        { "blockedEnqueues", m_blockedEnqueues },
+        { "overflowFrames", m_overflowFrames },
+        { "rejectedFrames", m_rejectedFrames },
+        { "sendErrors", m_sendErrors },
+        { "sendLatency", m_sendLatency.ToJson() }
+    };
+}
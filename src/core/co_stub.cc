@@ -36,6 +36,8 @@
 #include "loader.h"
 #include "http_hooks.h"
 #include "ffi.h"
+#include "cdp_router.h"
+#include "reconnect_manager.h"
 #include <tuple>
 #include "plugin_logger.h"
 #include <mutex>
@@ -572,15 +574,47 @@ MILLENNIUM const void UnPatchSharedJSContext()
 }
 
 
+/**
+ * Reloads the frontend, retried until the reload succeeds.
+ */
+static void ReloadFrontend()
+{
+    const long long callId = CdpRouter::get().NextCallId();
+
+    CdpRouter::get().ExpectReply(callId, [](const nlohmann::json& reply)
+    {
+        /** The reload is requested again once the script is replayed on the new connection. */
+        if (CdpRouter::IsConnectionLost(reply))
+        {
+            return;
+        }
+
+        if (reply.contains("error"))
+        {
+            Logger.Log("Failed to reload frontend: {}", reply["error"].dump(4));
+            ReloadFrontend();
+            return;
+        }
+
+        Logger.Log("Successfully notified frontend...");
+    });
+
+    if (!Sockets::PostShared({ {"id", callId }, {"method", "Page.reload"}, { "params", { { "ignoreCache", true } }} }))
+    {
+        CdpRouter::get().CancelReply(callId);
+    }
+}
+
 /**
  * Notifies the frontend of the backend load and handles script injection and state updates.
  * 
  * This function performs the following tasks:
  * 1. Logs the start of the backend load notification process.
- * 2. Sets up a message listener to handle the frontend's response, specifically waiting for a script identifier.
- * 3. Sends messages to enable the page and inject a script to the frontend for execution.
- * 4. Waits for a response from the frontend indicating successful script injection, then triggers a page reload.
- * 5. Logs completion of the process and removes the message listener.
+ * 2. Declares the page enable and the script the frontend evaluates on new documents as SharedJSContext session state.
+ * 3. Waits for the reply with the script identifier, then triggers a page reload.
+ * 4. Logs completion of the process.
+ *
+ * The calls are replayed on every reconnect, see ReconnectManager, and the reply handler runs again each time.
  *
  * Synchronization:
  * - Uses a mutex and condition variable to ensure thread-safe waiting for the frontend's script injection acknowledgment.
@@ -593,61 +627,39 @@ MILLENNIUM void OnBackendLoad(bool reloadFrontend)
     UnPatchSharedJSContext(); // Restore the original SharedJSContext
     Logger.Log("Notifying frontend of backend load...");
 
-    enum PageMessage
-    {
-        DEBUGGER_RESUME = 1,
-        PAGE_ENABLE = 2,
-        PAGE_SCRIPT = 3,
-        PAGE_RELOAD = 4
-    };
+    ReconnectManager::get().SetSessionState("SharedJSContext", "Page.enable", { {"method", "Page.enable"} });
 
-    JavaScript::SharedJSMessageEmitter::InstanceRef().OnMessage("msg", "OnBackendLoad", [reloadFrontend] (const nlohmann::json& eventMessage, std::string listenerId)
+    Logger.Log("Injecting script to evaluate on new document...");
+    ReconnectManager::get().SetSessionState("SharedJSContext", "Page.addScriptToEvaluateOnNewDocument", 
+        { {"method", "Page.addScriptToEvaluateOnNewDocument"}, {"params", {{ "source", ConstructOnLoadModule() }}} }, 
+        [reloadFrontend] (const nlohmann::json& scriptReply)
     {
+        /** The script is declared again on the next connection, this handler runs once more then. */
+        if (CdpRouter::IsConnectionLost(scriptReply))
+        {
+            return;
+        }
+
         auto& state = BackendLoadState::get();
         std::unique_lock<std::mutex> lock(state.mtx);
-        
+
         try
         {
-            const PageMessage messageId = (PageMessage)(int)eventMessage.value("id", -1);
+            Logger.Log("Script injected, waiting for identifier...");
 
-            if (messageId == PAGE_ENABLE)
-            {
-                Logger.Log("Injecting script to evaluate on new document...");
-                Sockets::PostShared({ {"id", PAGE_SCRIPT }, {"method", "Page.addScriptToEvaluateOnNewDocument"}, {"params", {{ "source", ConstructOnLoadModule() }}} });
-            }
-            if (messageId == PAGE_SCRIPT)
-            {
-                Logger.Log("Script injected, waiting for identifier...");
-
-                addedScriptOnNewDocumentId = eventMessage["result"]["identifier"];
-                state.hasScriptIdentifier = true;
-                Logger.Log("Successfully injected shims, reloading frontend...");
+            addedScriptOnNewDocumentId = scriptReply.at("result").at("identifier");
+            state.hasScriptIdentifier = true;
+            Logger.Log("Successfully injected shims, reloading frontend...");
 
-                if (reloadFrontend) Sockets::PostShared({ {"id", PAGE_RELOAD }, {"method", "Page.reload"}, { "params", { { "ignoreCache", true } }} });
-                state.cvScript.notify_one();  
-
-            }
-            if (messageId == PAGE_RELOAD)
-            {
-                if (eventMessage.contains("error"))
-                {
-                    Logger.Log("Failed to reload frontend: {}", eventMessage["error"].dump(4));
-                    if (reloadFrontend) Sockets::PostShared({ {"id", PAGE_RELOAD }, {"method", "Page.reload"}, { "params", { { "ignoreCache", true } }} });
-                    return;
-                }
-                
-                Logger.Log("Successfully notified frontend...");
-                JavaScript::SharedJSMessageEmitter::InstanceRef().RemoveListener("msg", listenerId);
-            }
+            if (reloadFrontend) ReloadFrontend();
+            state.cvScript.notify_one();  
         }
         catch (nlohmann::detail::exception& ex)
         {
-            LOG_ERROR("JavaScript::SharedJSMessageEmitter error -> {}", ex.what());
+            LOG_ERROR("OnBackendLoad error -> {}", ex.what());
         }
     });
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    Sockets::PostShared({ {"id", PAGE_ENABLE }, {"method", "Page.enable"} });
     {
         auto& state = BackendLoadState::get();
         std::unique_lock<std::mutex> lock(state.mtx);
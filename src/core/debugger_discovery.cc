@@ -0,0 +1,284 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include "debugger_discovery.h"
+#include <algorithm>
+#include "http.h"
+#include "locals.h"
+#include "file_watcher.h"
+#include "internal_logger.h"
+#include <env.h>
+
+DebuggerDiscovery& DebuggerDiscovery::get()
+{
+    static DebuggerDiscovery instance;
+    return instance;
+}
+
+DebuggerDiscovery::DebuggerDiscovery() : m_activePortPath(GetActivePortPath())
+{
+    #ifdef _WIN32
+    {
+        WSADATA wsaData;
+        WSAStartup(MAKEWORD(2, 2), &wsaData);
+    }
+    #endif
+
+    m_watchingActivePort = FileWatcher::get().WatchDirectory(m_activePortPath.parent_path(), [this](const std::filesystem::path& changedPath)
+    {
+        if (changedPath.filename() != m_activePortPath.filename())
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_activePortChanges++;
+        }
+        m_wakeCondition.notify_all();
+    });
+
+    if (!m_watchingActivePort)
+    {
+        Logger.Log("Can't watch '{}', the debugger will only be found by probing its port.", m_activePortPath.string());
+    }
+}
+
+/**
+ * CEF writes the port it listens on to `DevToolsActivePort` in its cache directory.
+ */
+std::filesystem::path DebuggerDiscovery::GetActivePortPath()
+{
+    #ifdef _WIN32
+    {
+        return std::filesystem::path(GetEnv("LOCALAPPDATA")) / "Steam" / "htmlcache" / "DevToolsActivePort";
+    }
+    #else
+    {
+        return SystemIO::GetSteamPath() / "config" / "htmlcache" / "DevToolsActivePort";
+    }
+    #endif
+}
+
+bool DebuggerDiscovery::ProbePort(unsigned short port, std::chrono::milliseconds timeout)
+{
+    sockaddr_in address = {};
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    #ifdef _WIN32
+    {
+        SOCKET probeSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+        if (probeSocket == INVALID_SOCKET)
+        {
+            return false;
+        }
+
+        u_long nonBlocking = 1;
+        ioctlsocket(probeSocket, FIONBIO, &nonBlocking);
+
+        bool isOpen = connect(probeSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+
+        /** A refused connection to loopback is only reported after Windows retried it, so it's bounded by the timeout. */
+        if (!isOpen && WSAGetLastError() == WSAEWOULDBLOCK)
+        {
+            fd_set writeSet, exceptSet;
+            FD_ZERO(&writeSet);
+            FD_ZERO(&exceptSet);
+            FD_SET(probeSocket, &writeSet);
+            FD_SET(probeSocket, &exceptSet);
+
+            timeval waitTime = { 0, static_cast<long>(timeout.count() * 1000) };
+            isOpen = select(0, nullptr, &writeSet, &exceptSet, &waitTime) > 0 && FD_ISSET(probeSocket, &writeSet);
+        }
+
+        closesocket(probeSocket);
+        return isOpen;
+    }
+    #else
+    {
+        const int probeSocket = socket(AF_INET, SOCK_STREAM, 0);
+
+        if (probeSocket == -1)
+        {
+            return false;
+        }
+
+        fcntl(probeSocket, F_SETFD, FD_CLOEXEC);
+        fcntl(probeSocket, F_SETFL, fcntl(probeSocket, F_GETFL, 0) | O_NONBLOCK);
+
+        bool isOpen = connect(probeSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+
+        if (!isOpen && errno == EINPROGRESS)
+        {
+            pollfd pollEntry = { probeSocket, POLLOUT, 0 };
+
+            if (poll(&pollEntry, 1, static_cast<int>(timeout.count())) > 0)
+            {
+                int socketError = 0;
+                socklen_t errorLength = sizeof(socketError);
+
+                isOpen = getsockopt(probeSocket, SOL_SOCKET, SO_ERROR, &socketError, &errorLength) == 0 && socketError == 0;
+            }
+        }
+
+        close(probeSocket);
+        return isOpen;
+    }
+    #endif
+}
+
+bool DebuggerDiscovery::WaitForChange(uint64_t seenChanges, std::chrono::milliseconds delay)
+{
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+
+    const bool hasChanged = m_wakeCondition.wait_for(lock, delay, [this, seenChanges] { return m_activePortChanges != seenChanges; });
+
+    if (hasChanged)
+    {
+        m_activePortWakeups++;
+    }
+    return hasChanged;
+}
+
+std::optional<std::string> DebuggerDiscovery::WaitForDebugger(unsigned short port)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto deadline  = startTime + m_deadline;
+    const std::string versionUrl = fmt::format("http://localhost:{}/json/version", port);
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+
+        if (!m_hasWaited)
+        {
+            m_firstWaitStart = startTime;
+            m_hasWaited = true;
+        }
+    }
+
+    auto backoff = m_initialBackoff;
+    uint64_t probes = 0;
+
+    while (true)
+    {
+        uint64_t seenChanges;
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            seenChanges = m_activePortChanges;
+            m_probes++;
+        }
+        probes++;
+
+        /** The HTTP request is only made once the port accepts connections, it would otherwise fail just the same. */
+        if (ProbePort(port, m_probeTimeout))
+        {
+            std::optional<std::string> versionInfo = Http::TryGet(versionUrl.c_str(), m_requestTimeout);
+
+            if (versionInfo.has_value() && !versionInfo->empty())
+            {
+                const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+                {
+                    std::lock_guard<std::mutex> lock(m_wakeMutex);
+                    m_lastDiscoveryMs = elapsed;
+                }
+
+                Logger.Log("Steam's debugger answered on port {} after {} ms ({} probes).", port, elapsed, probes);
+                return versionInfo;
+            }
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_wakeMutex);
+                m_deadlinesMissed++;
+            }
+
+            Logger.Warn("Steam's debugger didn't answer on port {} within {} s.", port, m_deadline.count());
+            return std::nullopt;
+        }
+
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+
+        /** The active port file changing means the debugger just started listening, so the next wait starts short again. */
+        backoff = WaitForChange(seenChanges, std::min(backoff, remaining)) ? m_initialBackoff : std::min(backoff * 2, m_maxBackoff);
+    }
+}
+
+void DebuggerDiscovery::OnConnected()
+{
+    long long timeToFirstConnect;
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+
+        if (m_hasConnected || !m_hasWaited)
+        {
+            return;
+        }
+
+        m_hasConnected = true;
+        m_timeToFirstConnectMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_firstWaitStart).count();
+        timeToFirstConnect = m_timeToFirstConnectMs;
+    }
+
+    Logger.Log("First connection to Steam took {} ms from the start of debugger discovery.", timeToFirstConnect);
+}
+
+nlohmann::json DebuggerDiscovery::GetMetrics() const
+{
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+
+    return {
+        { "watchingActivePort", m_watchingActivePort },
+        { "probes", m_probes },
+        { "activePortWakeups", m_activePortWakeups },
+        { "deadlinesMissed", m_deadlinesMissed },
+        { "lastDiscoveryMs", m_lastDiscoveryMs },
+        { "timeToFirstConnectMs", m_timeToFirstConnectMs }
+    };
+}
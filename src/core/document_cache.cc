@@ -0,0 +1,206 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "document_cache.h"
+#include <fmt/core.h>
+#include "file_watcher.h"
+#include "internal_logger.h"
+#include "locals.h"
+#include "hash.h"
+
+DocumentCache& DocumentCache::get()
+{
+    static DocumentCache instance;
+    return instance;
+}
+
+/**
+ * Gets the last write time of a directory, it changes whenever an entry is added, removed or renamed in it.
+ */
+static std::optional<std::filesystem::file_time_type> GetWriteTime(const std::filesystem::path& directory)
+{
+    std::error_code errorCode;
+    const auto lastWriteTime = std::filesystem::last_write_time(directory, errorCode);
+
+    if (errorCode)
+    {
+        return std::nullopt;
+    }
+    return lastWriteTime;
+}
+
+DocumentCache::DocumentCache() : m_steamUiPath(SystemIO::GetSteamPath() / "steamui")
+{
+    m_steamUiWriteTime = GetWriteTime(m_steamUiPath);
+    m_nextSteamUiCheck = std::chrono::steady_clock::now() + m_steamUiCheckInterval;
+
+    /** 
+     * Hits are compared against the stored body, so a stale entry can never be served, an update only makes them unreachable. 
+     * Updates within subdirectories aren't reported by the watch, those are caught by CheckSteamUiLocked.
+     */
+    FileWatcher::get().WatchDirectory(m_steamUiPath, [this](const std::filesystem::path&) {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+        if (!m_entries.empty()) 
+        {
+            m_invalidations += m_entries.size();
+            this->ClearLocked();
+        }
+    });
+}
+
+std::string DocumentCache::MakeKey(const std::string& requestUrl, const std::string& responseBody, bool base64Encoded, const std::string& shimContent)
+{
+    return fmt::format("{}|{}:{:016x}:{:016x}:{}", requestUrl, responseBody.size(),
+        Fnv1a64(responseBody.data(), responseBody.size()), Fnv1a64(shimContent.data(), shimContent.size()), base64Encoded ? "b64" : "raw");
+}
+
+/**
+ * Empties the cache if `steamui` was written to since the last check, at most once per m_steamUiCheckInterval. 
+ * Platforms without a watcher rely on this alone.
+ */
+void DocumentCache::CheckSteamUiLocked()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    if (now < m_nextSteamUiCheck)
+    {
+        return;
+    }
+    m_nextSteamUiCheck = now + m_steamUiCheckInterval;
+
+    const std::optional<std::filesystem::file_time_type> steamUiWriteTime = GetWriteTime(m_steamUiPath);
+
+    if (steamUiWriteTime != m_steamUiWriteTime)
+    {
+        m_steamUiWriteTime = steamUiWriteTime;
+        m_invalidations += m_entries.size();
+        this->ClearLocked();
+    }
+}
+
+std::shared_ptr<const std::string> DocumentCache::Get(const std::string& key, unsigned long long hookGeneration, const std::string& responseBody, const std::string& shimContent)
+{
+    const unsigned long long lookupCount = ++m_lookups;
+
+    if (lookupCount % m_statsLogInterval == 0)
+    {
+        this->LogStats(lookupCount);
+    }
+
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+    if (m_hookGeneration != hookGeneration)
+    {
+        m_invalidations += m_entries.size();
+        this->ClearLocked();
+        m_hookGeneration = hookGeneration;
+    }
+    this->CheckSteamUiLocked();
+
+    auto entryIterator = m_entries.find(key);
+
+    /** The shim is usually the very same cached string, its contents are only compared if it was rebuilt. */
+    if (entryIterator == m_entries.end() || entryIterator->second.originalBody != responseBody || 
+        (entryIterator->second.shimContent.get() != &shimContent && *entryIterator->second.shimContent != shimContent))
+    {
+        m_misses++;
+        return nullptr;
+    }
+
+    m_lruList.splice(m_lruList.begin(), m_lruList, entryIterator->second.lruIterator);
+    m_hits++;
+    return entryIterator->second.patchedBody;
+}
+
+void DocumentCache::Insert(const std::string& key, unsigned long long hookGeneration, const std::string& responseBody, 
+    std::shared_ptr<const std::string> shimContent, std::shared_ptr<const std::string> patchedBody)
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+    /** Patched against a hook list that has since been replaced. */
+    if (m_hookGeneration != hookGeneration || !patchedBody || !shimContent || responseBody.size() + patchedBody->size() > m_maxCacheBytes)
+    {
+        return;
+    }
+
+    const size_t entrySize = responseBody.size() + patchedBody->size();
+
+    if (auto existing = m_entries.find(key); existing != m_entries.end())
+    {
+        EvictLocked(existing);
+    }
+
+    while (!m_lruList.empty() && (m_entries.size() >= m_maxEntries || m_cacheBytes + entrySize > m_maxCacheBytes))
+    {
+        EvictLocked(m_entries.find(m_lruList.back()));
+        m_evictions++;
+    }
+
+    m_cacheBytes += entrySize;
+    m_lruList.push_front(key);
+    m_entries.emplace(key, CacheEntry{ responseBody, std::move(shimContent), std::move(patchedBody), m_lruList.begin() });
+}
+
+void DocumentCache::EvictLocked(std::unordered_map<std::string, CacheEntry>::iterator entryIterator)
+{
+    m_cacheBytes -= entryIterator->second.Size();
+    m_lruList.erase(entryIterator->second.lruIterator);
+    m_entries.erase(entryIterator);
+}
+
+void DocumentCache::ClearLocked()
+{
+    m_entries.clear();
+    m_lruList.clear();
+    m_cacheBytes = 0;
+}
+
+void DocumentCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_invalidations += m_entries.size();
+    this->ClearLocked();
+}
+
+DocumentCache::Stats DocumentCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    return { m_hits.load(), m_misses.load(), m_evictions.load(), m_invalidations.load(), m_entries.size(), m_cacheBytes };
+}
+
+void DocumentCache::LogStats(unsigned long long lookupCount)
+{
+    const Stats stats = this->GetStats();
+    const double hitRate = lookupCount != 0 ? 100.0 * stats.hits / lookupCount : 0.0;
+
+    Logger.Log("Document cache: {} lookups, {:.1f}% hits, {} evictions, {} invalidations, {} entries ({} KiB)", 
+        lookupCount, hitRate, stats.evictions, stats.invalidations, stats.entries, stats.bytes / 1024);
+}
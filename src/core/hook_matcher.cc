@@ -0,0 +1,222 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "hook_matcher.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include "internal_logger.h"
+
+/**
+ * Checks if the pattern is a catch-all pattern, these are matched without evaluating a regex.
+ */
+static bool IsMatchAllPattern(const std::string& patternSource)
+{
+    return patternSource == ".*" || patternSource == "^.*" || patternSource == ".*$" || patternSource == "^.*$";
+}
+
+/**
+ * Checks if the pattern contains an alternation outside of any group or character class.
+ * A top level alternation means the pattern has no single literal prefix.
+ */
+static bool HasTopLevelAlternation(const std::string& patternSource)
+{
+    int groupDepth = 0;
+    bool inCharacterClass = false;
+
+    for (size_t i = 0; i < patternSource.size(); i++)
+    {
+        const char character = patternSource[i];
+
+        if      (character == '\\')                         { i++; continue; }
+        else if (inCharacterClass)                          { if (character == ']') inCharacterClass = false; }
+        else if (character == '[')                          { inCharacterClass = true; }
+        else if (character == '(')                          { groupDepth++; }
+        else if (character == ')')                          { groupDepth = std::max(0, groupDepth - 1); }
+        else if (character == '|' && groupDepth == 0)       { return true; }
+    }
+    return false;
+}
+
+std::string HookMatcher::LiteralPrefix(const std::string& patternSource)
+{
+    if (HasTopLevelAlternation(patternSource))
+    {
+        return {};
+    }
+
+    std::string prefix;
+    size_t i = (!patternSource.empty() && patternSource[0] == '^') ? 1 : 0;
+
+    for (; i < patternSource.size(); i++)
+    {
+        const char character = patternSource[i];
+
+        /** The previous literal is optional or repeated zero times, so it isn't part of the prefix. */
+        if (character == '?' || character == '*' || character == '{')
+        {
+            if (!prefix.empty()) prefix.pop_back();
+            break;
+        }
+
+        if (character == '\\')
+        {
+            /** Escaped punctuation is a literal, escaped letters/digits are classes or assertions (\w, \d, \b, ...) */
+            if (i + 1 < patternSource.size() && !std::isalnum(static_cast<unsigned char>(patternSource[i + 1])))
+            {
+                prefix.push_back(patternSource[++i]);
+                continue;
+            }
+            break;
+        }
+
+        if (std::strchr("^$.|+()[]", character) != nullptr)
+        {
+            break;
+        }
+
+        prefix.push_back(character);
+    }
+
+    return prefix;
+}
+
+void HookMatcher::Compile(const std::vector<std::string>& patternSources)
+{
+    m_groups.clear();
+    m_trie.assign(1, TrieNode{});
+
+    std::unordered_map<std::string, size_t> groupIndexMap;
+
+    for (size_t hookIndex = 0; hookIndex < patternSources.size(); hookIndex++)
+    {
+        const std::string& source = patternSources[hookIndex];
+        auto groupIterator = groupIndexMap.find(source);
+
+        if (groupIterator != groupIndexMap.end())
+        {
+            m_groups[groupIterator->second].hookIndices.push_back(hookIndex);
+            continue;
+        }
+
+        PatternGroup group { source, std::regex(), IsMatchAllPattern(source), true, { hookIndex } };
+
+        if (!group.matchesAll)
+        {
+            try 
+            {
+                group.pattern = std::regex(source);
+            }
+            catch (const std::regex_error& error)
+            {
+                LOG_ERROR("Failed to compile hook pattern '{}': {}", source, error.what());
+                group.isValid = false;
+            }
+        }
+
+        const size_t groupIndex = m_groups.size();
+        groupIndexMap.emplace(source, groupIndex);
+        m_groups.push_back(std::move(group));
+
+        /** Insert the group into the trie at the node of its literal prefix */
+        size_t nodeIndex = 0;
+        for (const char character : LiteralPrefix(source))
+        {
+            auto childIterator = m_trie[nodeIndex].children.find(character);
+
+            if (childIterator == m_trie[nodeIndex].children.end())
+            {
+                m_trie.push_back(TrieNode{});
+                childIterator = m_trie[nodeIndex].children.emplace(character, m_trie.size() - 1).first;
+            }
+            nodeIndex = childIterator->second;
+        }
+        m_trie[nodeIndex].groups.push_back(groupIndex);
+    }
+
+    std::lock_guard<std::mutex> lock(m_memoMutex);
+    m_memo.clear();
+}
+
+std::vector<size_t> HookMatcher::Match(const std::string& url) const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_memoMutex);
+        auto memoIterator = m_memo.find(url);
+
+        if (memoIterator != m_memo.end()) 
+        {
+            return memoIterator->second;
+        }
+    }
+
+    std::vector<size_t> matchedHooks;
+
+    const auto EvaluateNode = [&](const TrieNode& node)
+    {
+        for (const size_t groupIndex : node.groups)
+        {
+            const PatternGroup& group = m_groups[groupIndex];
+
+            if (group.isValid && (group.matchesAll || std::regex_match(url, group.pattern)))
+            {
+                matchedHooks.insert(matchedHooks.end(), group.hookIndices.begin(), group.hookIndices.end());
+            }
+        }
+    };
+
+    if (!m_trie.empty())
+    {
+        size_t nodeIndex = 0;
+        EvaluateNode(m_trie[nodeIndex]);
+
+        for (const char character : url)
+        {
+            auto childIterator = m_trie[nodeIndex].children.find(character);
+
+            if (childIterator == m_trie[nodeIndex].children.end()) 
+                break;
+
+            nodeIndex = childIterator->second;
+            EvaluateNode(m_trie[nodeIndex]);
+        }
+    }
+
+    /** Hooks are injected in the order they were registered */
+    std::sort(matchedHooks.begin(), matchedHooks.end());
+
+    std::lock_guard<std::mutex> lock(m_memoMutex);
+    if (m_memo.size() >= m_maxMemoizedUrls)
+    {
+        m_memo.clear();
+    }
+    m_memo.emplace(url, matchedHooks);
+    return matchedHooks;
+}
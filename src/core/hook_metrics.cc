@@ -0,0 +1,285 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "hook_metrics.h"
+#include <algorithm>
+#include <fmt/core.h>
+#include "internal_logger.h"
+
+static constexpr std::array<const char*, HookMetrics::STAGE_COUNT> g_stageNames = {
+    "bodyRequest", "bodyWait", "patch", "assetLoad", "fulfill", "total", "prefetch"
+};
+
+static constexpr std::array<const char*, HookMetrics::RESOURCE_TYPE_COUNT> g_resourceTypeNames = {
+    "Document", "Script", "Stylesheet", "Image", "Font", "Media", "IPC", "Other"
+};
+
+size_t LatencyHistogram::BucketIndex(std::uint64_t value)
+{
+    value = std::min<std::uint64_t>(value, (1ull << m_maxValueBits) - 1);
+
+    if (value < m_subBucketCount) {
+        return static_cast<size_t>(value);
+    }
+
+    int exponent = m_subBucketBits;
+    while ((value >> (exponent + 1)) != 0) {
+        exponent++;
+    }
+
+    /** The leading bit selects the power of two, the next m_subBucketBits bits select the linear sub-bucket. */
+    const int shift = exponent - m_subBucketBits;
+    const std::uint64_t subBucket = (value >> shift) - m_subBucketCount;
+    return static_cast<size_t>((shift + 1) * m_subBucketCount + subBucket);
+}
+
+std::uint64_t LatencyHistogram::BucketMidpoint(size_t bucketIndex)
+{
+    if (bucketIndex < m_subBucketCount) {
+        return bucketIndex;
+    }
+
+    const int shift = static_cast<int>(bucketIndex / m_subBucketCount) - 1;
+    const std::uint64_t lowerBound = (bucketIndex % m_subBucketCount + m_subBucketCount) << shift;
+    return lowerBound + ((1ull << shift) >> 1);
+}
+
+void LatencyHistogram::Record(std::chrono::microseconds latency)
+{
+    const std::uint64_t value = static_cast<std::uint64_t>(std::max<std::chrono::microseconds::rep>(latency.count(), 0));
+
+    m_buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    std::uint64_t currentMax = m_max.load(std::memory_order_relaxed);
+    while (value > currentMax && !m_max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed)) { }
+}
+
+double LatencyHistogram::Percentile(double percentile, std::uint64_t count) const
+{
+    const std::uint64_t target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(percentile * count + 0.5));
+    std::uint64_t seen = 0;
+
+    for (size_t i = 0; i < m_bucketCount; i++) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+
+        if (seen >= target) {
+            /** Never report more than the largest recorded value, the bucket midpoint can overshoot it. */
+            return std::min(BucketMidpoint(i), m_max.load(std::memory_order_relaxed)) / 1000.0;
+        }
+    }
+    return m_max.load(std::memory_order_relaxed) / 1000.0;
+}
+
+LatencyHistogram::Summary LatencyHistogram::Summarize() const
+{
+    const std::uint64_t count = m_count.load(std::memory_order_relaxed);
+
+    if (count == 0) {
+        return { 0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    }
+
+    return {
+        count,
+        m_sum.load(std::memory_order_relaxed) / 1000.0 / count,
+        Percentile(0.50, count),
+        Percentile(0.90, count),
+        Percentile(0.99, count),
+        m_max.load(std::memory_order_relaxed) / 1000.0
+    };
+}
+
+nlohmann::json LatencyHistogram::ToJson() const
+{
+    const Summary summary = Summarize();
+
+    return {
+        { "count", summary.count },
+        { "meanMs", summary.meanMs },
+        { "p50Ms", summary.p50Ms },
+        { "p90Ms", summary.p90Ms },
+        { "p99Ms", summary.p99Ms },
+        { "maxMs", summary.maxMs }
+    };
+}
+
+HookMetrics& HookMetrics::get()
+{
+    static HookMetrics instance;
+    return instance;
+}
+
+HookMetrics::HookMetrics() : m_nextSummary((Clock::now() + m_summaryInterval).time_since_epoch().count())
+{ }
+
+HookMetrics::ResourceType HookMetrics::ResourceTypeFromString(const std::string& resourceType)
+{
+    static const std::unordered_map<std::string, ResourceType> resourceTypes = {
+        { "Document",   DOCUMENT   },
+        { "Script",     SCRIPT     },
+        { "Stylesheet", STYLESHEET },
+        { "Image",      IMAGE      },
+        { "Font",       FONT       },
+        { "Media",      MEDIA      }
+    };
+
+    const auto it = resourceTypes.find(resourceType);
+    return it != resourceTypes.end() ? it->second : OTHER;
+}
+
+void HookMetrics::Record(ResourceType resourceType, Stage stage, Clock::time_point start, Clock::time_point end)
+{
+    m_histograms[resourceType][stage].Record(std::chrono::duration_cast<std::chrono::microseconds>(end - start));
+
+    if (stage == TOTAL) {
+        LogSummaryIfDue(end);
+    }
+}
+
+/**
+ * @brief Documents are classed by host, e.g. "steamloopback.host" or "store.steampowered.com".
+ */
+static std::string GetUrlClass(const std::string& requestUrl)
+{
+    const size_t schemeEnd = requestUrl.find("://");
+    const size_t hostStart = schemeEnd == std::string::npos ? 0 : schemeEnd + 3;
+    const size_t hostEnd   = requestUrl.find_first_of(":/?#", hostStart);
+
+    std::string host = requestUrl.substr(hostStart, hostEnd == std::string::npos ? std::string::npos : hostEnd - hostStart);
+    return host.empty() ? "other" : host;
+}
+
+void HookMetrics::RecordDocument(const std::string& requestUrl, Clock::time_point pausedAt, Clock::time_point end)
+{
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(end - pausedAt);
+    std::string urlClass = GetUrlClass(requestUrl);
+
+    {
+        std::lock_guard<std::mutex> lock(m_breakdownMutex);
+
+        /** Keep the breakdown bounded, hosts past the limit are folded into a single class. */
+        if (m_urlClassHistograms.find(urlClass) == m_urlClassHistograms.end() && m_urlClassHistograms.size() >= m_maxUrlClasses) {
+            urlClass = "other";
+        }
+
+        auto& histogram = m_urlClassHistograms[urlClass];
+        if (!histogram) {
+            histogram = std::make_unique<LatencyHistogram>();
+        }
+        histogram->Record(latency);
+    }
+
+    Record(DOCUMENT, TOTAL, pausedAt, end);
+}
+
+void HookMetrics::RecordHookMatch(unsigned long long hookId)
+{
+    std::lock_guard<std::mutex> lock(m_breakdownMutex);
+    m_hookMatches[hookId]++;
+}
+
+void HookMetrics::RetainHookMatches(const std::vector<unsigned long long>& hookIds)
+{
+    std::vector<unsigned long long> sortedIds = hookIds;
+    std::sort(sortedIds.begin(), sortedIds.end());
+
+    std::lock_guard<std::mutex> lock(m_breakdownMutex);
+
+    for (auto it = m_hookMatches.begin(); it != m_hookMatches.end();) {
+        if (!std::binary_search(sortedIds.begin(), sortedIds.end(), it->first)) {
+            it = m_hookMatches.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+nlohmann::json HookMetrics::ToJson() const
+{
+    nlohmann::json result = {
+        { "resourceTypes", nlohmann::json::object() },
+        { "urlClasses", nlohmann::json::object() },
+        { "hookMatches", nlohmann::json::object() }
+    };
+
+    for (size_t type = 0; type < RESOURCE_TYPE_COUNT; type++) {
+        nlohmann::json stages = nlohmann::json::object();
+
+        for (size_t stage = 0; stage < STAGE_COUNT; stage++) {
+            const LatencyHistogram& histogram = m_histograms[type][stage];
+
+            if (histogram.Summarize().count != 0) {
+                stages[g_stageNames[stage]] = histogram.ToJson();
+            }
+        }
+
+        if (!stages.empty()) {
+            result["resourceTypes"][g_resourceTypeNames[type]] = std::move(stages);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_breakdownMutex);
+
+    for (const auto& [urlClass, histogram] : m_urlClassHistograms) {
+        result["urlClasses"][urlClass] = histogram->ToJson();
+    }
+
+    for (const auto& [hookId, matches] : m_hookMatches) {
+        result["hookMatches"][std::to_string(hookId)] = matches;
+    }
+    return result;
+}
+
+void HookMetrics::LogSummaryIfDue(Clock::time_point now)
+{
+    Clock::rep nextSummary = m_nextSummary.load(std::memory_order_relaxed);
+
+    /** Only the thread that wins the exchange logs, the others carry on untouched. */
+    if (now.time_since_epoch().count() < nextSummary || 
+        !m_nextSummary.compare_exchange_strong(nextSummary, (now + m_summaryInterval).time_since_epoch().count(), std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::string summaryLine;
+
+    for (size_t type = 0; type < RESOURCE_TYPE_COUNT; type++) {
+        const LatencyHistogram::Summary summary = m_histograms[type][TOTAL].Summarize();
+
+        if (summary.count != 0) {
+            summaryLine += fmt::format("{}{} n={} p50={:.2f}ms p90={:.2f}ms p99={:.2f}ms max={:.2f}ms", 
+                summaryLine.empty() ? "" : ", ", g_resourceTypeNames[type], summary.count, summary.p50Ms, summary.p90Ms, summary.p99Ms, summary.maxMs);
+        }
+    }
+
+    if (!summaryLine.empty()) {
+        Logger.Log("Interception latency: {}", summaryLine);
+    }
+}
@@ -0,0 +1,277 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "html_injector.h"
+#include <array>
+#include <algorithm>
+#include <cstring>
+
+static constexpr char g_base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/** Maps a base64 character to its 6-bit value, or -1 for anything that isn't part of the alphabet. */
+static constexpr std::array<signed char, 256> g_base64Lookup = []
+{
+    std::array<signed char, 256> lookup{};
+
+    for (auto& value : lookup) value = -1;
+    for (int i = 0; i < 64; i++) lookup[static_cast<unsigned char>(g_base64Alphabet[i])] = static_cast<signed char>(i);
+
+    return lookup;
+}();
+
+static constexpr char g_headTag[] = "<head";
+static constexpr size_t g_headTagLength = sizeof(g_headTag) - 1;
+
+/** Size of the stack buffer base64 input is decoded into before it's scanned. */
+static constexpr size_t g_decodeBlockSize = 3 * 1024;
+
+HtmlHeadInjector::HtmlHeadInjector(std::string content) : m_content(std::move(content))
+{ }
+
+void HtmlHeadInjector::Reserve(size_t documentSize)
+{
+    m_output.reserve(((documentSize + m_content.size() + 2) / 3) * 4);
+}
+
+bool HtmlHeadInjector::HasInjected() const
+{
+    return m_scanState == ScanState::DONE;
+}
+
+/**
+ * Advances the head tag scanner by one byte.
+ * @returns {boolean} - `true` if the byte closed the head tag, i.e. the content goes right after it.
+ */
+bool HtmlHeadInjector::ScanByte(char byte)
+{
+    switch (m_scanState)
+    {
+        case ScanState::SEARCH:
+        {
+            const char lowered = (byte >= 'A' && byte <= 'Z') ? static_cast<char>(byte | 0x20) : byte;
+
+            if (lowered == g_headTag[m_matchedLength]) 
+            {
+                if (++m_matchedLength == g_headTagLength) m_scanState = ScanState::TAG_NAME;
+            }
+            else 
+            {
+                /** '<' only occurs at the start of the tag, so a mismatch can only restart on it. */
+                m_matchedLength = (byte == '<') ? 1 : 0;
+            }
+            return false;
+        }
+        case ScanState::TAG_NAME:
+        {
+            if (byte == '>') 
+            {
+                m_scanState = ScanState::DONE;
+                return true;
+            }
+            if (byte == ' ' || byte == '\t' || byte == '\n' || byte == '\r' || byte == '\f' || byte == '/') 
+            {
+                m_scanState = ScanState::IN_TAG;
+                return false;
+            }
+
+            /** Some other tag that starts with "head", i.e. <header> */
+            m_scanState = ScanState::SEARCH;
+            m_matchedLength = (byte == '<') ? 1 : 0;
+            return false;
+        }
+        case ScanState::IN_TAG:
+        {
+            if (m_quote) 
+            {
+                if (byte == m_quote) m_quote = 0;
+            }
+            else if (byte == '"' || byte == '\'') 
+            {
+                m_quote = byte;
+            }
+            else if (byte == '>') 
+            {
+                m_scanState = ScanState::DONE;
+                return true;
+            }
+            return false;
+        }
+        case ScanState::DONE:
+        default: 
+        {
+            return false;
+        }
+    }
+}
+
+void HtmlHeadInjector::Write(std::string_view bytes)
+{
+    const char* data = bytes.data();
+    size_t length = bytes.size();
+
+    while (length && m_scanState != ScanState::DONE)
+    {
+        /** Skip straight to the next tag while nothing is partially matched. */
+        if (m_scanState == ScanState::SEARCH && m_matchedLength == 0) 
+        {
+            const char* tagStart = static_cast<const char*>(std::memchr(data, '<', length));
+            const size_t skipped = tagStart ? static_cast<size_t>(tagStart - data) : length;
+
+            EncodeBytes(data, skipped);
+            data += skipped;
+            length -= skipped;
+
+            if (!length) break;
+        }
+
+        EncodeBytes(data, 1);
+
+        if (ScanByte(*data)) 
+        {
+            EncodeBytes(m_content.data(), m_content.size());
+        }
+        data++;
+        length--;
+    }
+
+    EncodeBytes(data, length);
+}
+
+void HtmlHeadInjector::WriteBase64(std::string_view base64)
+{
+    /** 
+     * Past the head tag the input only has to be re-encoded. While the encoder is on a group boundary, 
+     * unpadded input already is the output and is spliced in as is.
+     */
+    if (m_scanState == ScanState::DONE && m_encodePendingLength == 0 && m_decodeBits == 0 && base64.size() % 4 == 0 &&
+        std::all_of(base64.begin(), base64.end(), [](unsigned char character) { return g_base64Lookup[character] >= 0; }))
+    {
+        m_output.append(base64);
+        return;
+    }
+
+    char decoded[g_decodeBlockSize];
+    size_t decodedLength = 0;
+
+    for (const unsigned char character : base64)
+    {
+        const int value = g_base64Lookup[character];
+
+        /** Padding ends a group, streamed chunks are encoded one by one so it can occur mid input. */
+        if (character == '=') 
+        {
+            m_decodeBits = 0;
+            continue;
+        }
+
+        /** Whitespace and anything else outside of the alphabet carries no data. */
+        if (value < 0) continue;
+
+        m_decodeAccumulator = (m_decodeAccumulator << 6) | static_cast<unsigned int>(value);
+        m_decodeBits += 6;
+
+        if (m_decodeBits >= 8) 
+        {
+            m_decodeBits -= 8;
+            decoded[decodedLength++] = static_cast<char>((m_decodeAccumulator >> m_decodeBits) & 0xFF);
+
+            if (decodedLength == g_decodeBlockSize) 
+            {
+                Write(std::string_view(decoded, decodedLength));
+                decodedLength = 0;
+            }
+        }
+    }
+
+    Write(std::string_view(decoded, decodedLength));
+}
+
+void HtmlHeadInjector::EncodeBytes(const char* data, size_t length)
+{
+    if (!length) return;
+
+    const unsigned char* input = reinterpret_cast<const unsigned char*>(data);
+
+    /** Complete a triplet left over from the previous write. */
+    while (m_encodePendingLength && m_encodePendingLength < 3 && length) 
+    {
+        m_encodePending[m_encodePendingLength++] = *input++;
+        length--;
+    }
+
+    const size_t fullTriplets = length / 3;
+    const size_t outputOffset = m_output.size();
+    m_output.resize(outputOffset + (m_encodePendingLength == 3 ? 4 : 0) + fullTriplets * 4);
+
+    char* output = &m_output[outputOffset];
+
+    const auto EncodeTriplet = [&output](const unsigned char* triplet) 
+    {
+        output[0] = g_base64Alphabet[triplet[0] >> 2];
+        output[1] = g_base64Alphabet[((triplet[0] & 0x03) << 4) | (triplet[1] >> 4)];
+        output[2] = g_base64Alphabet[((triplet[1] & 0x0f) << 2) | (triplet[2] >> 6)];
+        output[3] = g_base64Alphabet[triplet[2] & 0x3f];
+        output += 4;
+    };
+
+    if (m_encodePendingLength == 3) 
+    {
+        EncodeTriplet(m_encodePending);
+        m_encodePendingLength = 0;
+    }
+
+    for (size_t i = 0; i < fullTriplets; i++, input += 3) 
+    {
+        EncodeTriplet(input);
+    }
+
+    for (size_t i = fullTriplets * 3; i < length; i++) 
+    {
+        m_encodePending[m_encodePendingLength++] = *input++;
+    }
+}
+
+std::string HtmlHeadInjector::Finish()
+{
+    if (m_encodePendingLength) 
+    {
+        unsigned char triplet[3] = { m_encodePending[0], 0, 0 };
+        if (m_encodePendingLength > 1) triplet[1] = m_encodePending[1];
+
+        m_output.push_back(g_base64Alphabet[triplet[0] >> 2]);
+        m_output.push_back(g_base64Alphabet[((triplet[0] & 0x03) << 4) | (triplet[1] >> 4)]);
+        m_output.push_back(m_encodePendingLength > 1 ? g_base64Alphabet[(triplet[1] & 0x0f) << 2] : '=');
+        m_output.push_back('=');
+
+        m_encodePendingLength = 0;
+    }
+
+    return std::move(m_output);
+}
@@ -34,15 +34,35 @@
 #include "ffi.h"
 #include "encoding.h"
 #include "http.h"
-#include <unordered_set>
+#include "url_policy.h"
+#include "asset_cache.h"
+#include "document_cache.h"
+#include "asset_precompressor.h"
+#include "asset_pack.h"
+#include "html_injector.h"
+#include "module_bundler.h"
+#include "response_patcher.h"
 #include "csp_bypass.h"
 #include "url_parser.h"
+#include "hash.h"
+#include "byte_range.h"
+#include "hook_metrics.h"
+#include "cdp_router.h"
+#include "cdp_send_queue.h"
+#include "reconnect_manager.h"
+#include "locals.h"
 #include "env.h"
 #include "fvisible.h"
 #include <secure_socket.h>
 #include "ipc.h"
 #include <thread>
+#include <deque>
+#include <algorithm>
+#include <unordered_set>
 #include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <limits>
 
 using namespace nlohmann;
 
@@ -68,6 +88,13 @@ enum eFileType
     woff,
     woff2,
     gif,
+    svg,
+    png,
+    jpg,
+    webp,
+    wasm,
+    mp4,
+    webm,
     unknown
 };
 
@@ -91,9 +118,41 @@ static std::map<eFileType, std::string> fileTypes
     { eFileType::woff,    "font/woff"              },
     { eFileType::woff2,   "font/woff2"             },
     { eFileType::gif,     "image/gif"              },
+    { eFileType::svg,     "image/svg+xml"          },
+    { eFileType::png,     "image/png"              },
+    { eFileType::jpg,     "image/jpeg"             },
+    { eFileType::webp,    "image/webp"             },
+    { eFileType::wasm,    "application/wasm"       },
+    { eFileType::mp4,     "video/mp4"              },
+    { eFileType::webm,    "video/webm"             },
     { eFileType::unknown, "text/plain"             },
 };
 
+/**
+ * A map that associates each (lowercase) file extension to its file type.
+ */
+static const std::unordered_map<std::string, eFileType> fileExtensions 
+{
+    { ".css",   eFileType::css   },
+    { ".js",    eFileType::js    },
+    { ".mjs",   eFileType::js    },
+    { ".json",  eFileType::json  },
+    { ".py",    eFileType::py    },
+    { ".ttf",   eFileType::ttf   },
+    { ".otf",   eFileType::otf   },
+    { ".woff",  eFileType::woff  },
+    { ".woff2", eFileType::woff2 },
+    { ".gif",   eFileType::gif   },
+    { ".svg",   eFileType::svg   },
+    { ".png",   eFileType::png   },
+    { ".jpg",   eFileType::jpg   },
+    { ".jpeg",  eFileType::jpg   },
+    { ".webp",  eFileType::webp  },
+    { ".wasm",  eFileType::wasm  },
+    { ".mp4",   eFileType::mp4   },
+    { ".webm",  eFileType::webm  },
+};
+
 /**
  * Checks if the file type is a binary file.
  * 
@@ -102,9 +161,12 @@ static std::map<eFileType, std::string> fileTypes
  */
 static constexpr bool IsBinaryFile(eFileType fileType)
 {
-    return fileType == eFileType::ttf || fileType == eFileType::otf || 
+    return fileType == eFileType::ttf  || fileType == eFileType::otf  || 
            fileType == eFileType::woff || fileType == eFileType::woff2 || 
-           fileType == eFileType::gif || fileType == eFileType::unknown;
+           fileType == eFileType::gif  || fileType == eFileType::png  || 
+           fileType == eFileType::jpg  || fileType == eFileType::webp || 
+           fileType == eFileType::wasm || fileType == eFileType::mp4  || 
+           fileType == eFileType::webm || fileType == eFileType::unknown;
 }
 
 /**
@@ -112,39 +174,15 @@ static constexpr bool IsBinaryFile(eFileType fileType)
  */
 static const eFileType EvaluateFileType(std::filesystem::path filePath)
 {
-    const std::string extension = filePath.extension().string();
-
-    if      (extension == ".css"  ) { return eFileType::css;   }
-    else if (extension == ".js"   ) { return eFileType::js;    }
-    else if (extension == ".json" ) { return eFileType::json;  }
-    else if (extension == ".py"   ) { return eFileType::py;    }
-    else if (extension == ".ttf"  ) { return eFileType::ttf;   }
-    else if (extension == ".otf"  ) { return eFileType::otf;   }
-    else if (extension == ".woff" ) { return eFileType::woff;  }
-    else if (extension == ".woff2") { return eFileType::woff2; }
-    else if (extension == ".gif"  ) { return eFileType::gif;   }
-    
-    else
-    {
-        return eFileType::unknown;
-    }
+    std::string extension = filePath.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    auto fileExtension = fileExtensions.find(extension);
+    return fileExtension != fileExtensions.end() ? fileExtension->second : eFileType::unknown;
 }
 
 std::atomic<unsigned long long> g_hookedModuleId{0};
 
-// Millennium will not load JavaScript into the following URLs to favor user safety.
-// This is a list of URLs that may have sensitive information or are not safe to load JavaScript into.
-static const std::vector<std::string> g_blackListedUrls = {
-    "https://checkout\\.steampowered\\.com/.*"
-};
-
-// Millennium will not hook the following URLs to favor user safety. (Neither JavaScript nor CSS will be injected into these URLs.)
-static const std::unordered_set<std::string> g_doNotHook = {
-    R"(https?:\/\/(?:[\w-]+\.)*paypal\.com\/[^\s"']*)",
-    R"(https?:\/\/(?:[\w-]+\.)*paypalobjects\.com\/[^\s"']*)",
-    R"(https?:\/\/(?:[\w-]+\.)*recaptcha\.net\/[^\s"']*)",
-};
-
 // Thread-safe singleton implementation
 HttpHookManager& HttpHookManager::get() 
 {
@@ -153,70 +191,335 @@ HttpHookManager& HttpHookManager::get()
 }
 
 // Thread-safe hook list operations
+std::shared_ptr<const HttpHookManager::HookSnapshot> HttpHookManager::GetHookSnapshot() const
+{
+    return std::atomic_load(&m_hookSnapshot);
+}
+
 void HttpHookManager::SetHookList(std::shared_ptr<std::vector<HookType>> hookList)
 {
-    std::unique_lock<std::shared_mutex> lock(m_hookListMutex);
-    m_hookListPtr = hookList;
+    std::lock_guard<std::mutex> lock(m_hookWriteMutex);
+    PublishHookList(hookList ? *hookList : std::vector<HookType>());
 }
 
-std::vector<HttpHookManager::HookType> HttpHookManager::GetHookListCopy() const
+static std::shared_ptr<AssetCache::Asset> LoadAssetFromDisk(const std::filesystem::path& filePath);
+
+/** Set once a directory is mounted, keeps AssetPackManager idle when packs are disabled. */
+static std::atomic<bool> g_assetPacksMounted { false };
+
+/**
+ * The directory a hook's assets are packed from, a theme's skin folder or a plugin's `.millennium/Dist` folder. 
+ * Other hooks aren't packed, their folder could be anything up to steamui itself.
+ */
+static std::optional<std::filesystem::path> GetPackRoot(const std::filesystem::path& hookPath)
 {
-    std::shared_lock<std::shared_mutex> lock(m_hookListMutex);
-    return m_hookListPtr ? *m_hookListPtr : std::vector<HookType>();
+    const std::filesystem::path skinsPath = SystemIO::GetSteamPath() / "steamui" / "skins";
+    const std::filesystem::path relativePath = hookPath.lexically_normal().lexically_relative(skinsPath);
+
+    if (!relativePath.empty() && *relativePath.begin() != ".." && std::distance(relativePath.begin(), relativePath.end()) > 1)
+    {
+        return skinsPath / *relativePath.begin();
+    }
+
+    /** A plugin's webkit module, see SettingsStore::PluginTypeSchema::webkitAbsolutePath */
+    const std::filesystem::path distPath = hookPath.lexically_normal().parent_path();
+
+    if (distPath.filename() == "Dist" && distPath.parent_path().filename() == ".millennium")
+    {
+        return distPath;
+    }
+    return std::nullopt;
 }
 
 void HttpHookManager::AddHook(const HookType& hook)
 {
-    std::unique_lock<std::shared_mutex> lock(m_hookListMutex);
-    if (m_hookListPtr) {
-        m_hookListPtr->push_back(hook);
+    if (m_precompressedAssets)
+    {
+        AssetPrecompressor::get().Enqueue(hook.path);
+    }
+
+    if (m_assetPacks)
+    {
+        if (const std::optional<std::filesystem::path> packRoot = GetPackRoot(hook.path))
+        {
+            AssetPackManager::get().Mount(packRoot.value(), LoadAssetFromDisk);
+            g_assetPacksMounted.store(true, std::memory_order_release);
+        }
     }
+
+    std::lock_guard<std::mutex> lock(m_hookWriteMutex);
+
+    std::vector<HookType> hookList = GetHookSnapshot()->hooks;
+    hookList.push_back(hook);
+
+    PublishHookList(std::move(hookList));
 }
 
 bool HttpHookManager::RemoveHook(unsigned long long moduleId)
 {
-    std::unique_lock<std::shared_mutex> lock(m_hookListMutex);
-    
-    if (!m_hookListPtr) {
-        return false; // Nothing to remove
+    return RemoveHooks({ moduleId }) != 0;
+}
+
+size_t HttpHookManager::RemoveHooks(const std::vector<unsigned long long>& moduleIds)
+{
+    std::lock_guard<std::mutex> lock(m_hookWriteMutex);
+
+    const std::shared_ptr<const HookSnapshot> snapshot = GetHookSnapshot();
+    std::vector<HookType> hookList;
+    hookList.reserve(snapshot->hooks.size());
+
+    for (const auto& hook : snapshot->hooks) {
+        if (std::find(moduleIds.begin(), moduleIds.end(), hook.id) == moduleIds.end()) {
+            hookList.push_back(hook);
+        }
     }
-    
-    size_t originalSize = m_hookListPtr->size();
-    
-    auto newEnd = std::remove_if(m_hookListPtr->begin(), m_hookListPtr->end(),
-        [moduleId](const HookType& hook) {
-            return hook.id == moduleId;
-        });
-    
-    m_hookListPtr->erase(newEnd, m_hookListPtr->end());
-    
-    return m_hookListPtr->size() < originalSize; // Return true if something was removed
+
+    const size_t removedCount = snapshot->hooks.size() - hookList.size();
+
+    if (removedCount == 0) {
+        return 0; // Nothing matched the module ids
+    }
+
+    PublishHookList(std::move(hookList));
+    return removedCount;
+}
+
+/**
+ * Compiles a new immutable snapshot from the given hook list and swaps it in. 
+ * Readers that pinned the previous snapshot keep using it until they release it.
+ * @note The caller must hold m_hookWriteMutex.
+ */
+void HttpHookManager::PublishHookList(std::vector<HookType> hookList)
+{
+    auto snapshot = std::make_shared<HookSnapshot>();
+    snapshot->hooks = std::move(hookList);
+    snapshot->generation = ++m_hookGeneration;
+
+    std::vector<std::string> patternSources;
+    std::vector<unsigned long long> hookIds;
+    patternSources.reserve(snapshot->hooks.size());
+    hookIds.reserve(snapshot->hooks.size());
+
+    for (const auto& hook : snapshot->hooks) {
+        patternSources.push_back(hook.urlPatternSource);
+        hookIds.push_back(hook.id);
+    }
+
+    snapshot->matcher.Compile(patternSources);
+    std::atomic_store(&m_hookSnapshot, std::shared_ptr<const HookSnapshot>(std::move(snapshot)));
+
+    /** Removed hooks never match again, their counts would otherwise pile up as modules are reloaded. */
+    HookMetrics::get().RetainHookMatches(hookIds);
+}
+
+/**
+ * Escapes the wildcard characters of a `Fetch.RequestPattern` url pattern.
+ */
+static std::string EscapeUrlPattern(const std::string& literal)
+{
+    std::string escaped;
+    escaped.reserve(literal.size());
+
+    for (const char character : literal)
+    {
+        if (character == '*' || character == '?' || character == '\\') escaped.push_back('\\');
+        escaped.push_back(character);
+    }
+    return escaped;
+}
+
+/**
+ * Derives the `Fetch.enable` url patterns to intercept from regex url patterns. Each pattern contributes 
+ * its literal prefix, patterns without one (i.e. `.*`) require every url to be intercepted.
+ * Prefixes already covered by a shorter prefix are dropped.
+ */
+std::vector<std::string> HttpHookManager::BuildUrlPatterns(const std::vector<std::string>& patternSources)
+{
+    std::vector<std::string> prefixes;
+    prefixes.reserve(patternSources.size());
+
+    for (const auto& patternSource : patternSources)
+    {
+        std::string prefix = HookMatcher::LiteralPrefix(patternSource);
+
+        if (prefix.empty())
+        {
+            return { "*" };
+        }
+        prefixes.push_back(std::move(prefix));
+    }
+
+    std::sort(prefixes.begin(), prefixes.end());
+
+    std::vector<std::string> urlPatterns;
+    std::string lastPrefix;
+
+    for (const auto& prefix : prefixes)
+    {
+        /** Sorted, so a covering prefix is always visited right before the prefixes it covers. */
+        if (!urlPatterns.empty() && prefix.compare(0, lastPrefix.size(), lastPrefix) == 0)
+        {
+            continue;
+        }
+
+        lastPrefix = prefix;
+        urlPatterns.push_back(EscapeUrlPattern(prefix) + "*");
+    }
+    return urlPatterns;
+}
+
+unsigned long long HttpHookManager::AddResponsePatch(const std::string& urlPatternSource, const std::string& find, const std::string& replace)
+{
+    std::lock_guard<std::mutex> lock(m_hookWriteMutex);
+
+    const std::vector<std::string> previousPatterns = BuildUrlPatterns(ResponsePatcher::get().GetUrlPatternSources());
+    const unsigned long long patchId = ResponsePatcher::get().AddPatch(urlPatternSource, find, replace);
+
+    if (m_isFetchEnabled && BuildUrlPatterns(ResponsePatcher::get().GetUrlPatternSources()) != previousPatterns)
+    {
+        SetupGlobalHooks();
+    }
+    return patchId;
+}
+
+bool HttpHookManager::RemoveResponsePatch(unsigned long long patchId)
+{
+    std::lock_guard<std::mutex> lock(m_hookWriteMutex);
+
+    const std::vector<std::string> previousPatterns = BuildUrlPatterns(ResponsePatcher::get().GetUrlPatternSources());
+
+    if (!ResponsePatcher::get().RemovePatch(patchId))
+    {
+        return false;
+    }
+
+    if (m_isFetchEnabled && BuildUrlPatterns(ResponsePatcher::get().GetUrlPatternSources()) != previousPatterns)
+    {
+        SetupGlobalHooks();
+    }
+    return true;
+}
+
+HttpHookManager::DocumentInterceptionStats HttpHookManager::GetDocumentInterceptionStats() const
+{
+    return { m_documentPauses.load(), m_deniedDocumentPauses.load(), BuildUrlPatterns(ResponsePatcher::get().GetUrlPatternSources()).size() };
 }
 
 // Thread-safe request management
-void HttpHookManager::AddRequest(const WebHookItem& request)
+void HttpHookManager::AddRequest(WebHookItem request)
+{
+    const long long messageId = request.id;
+
+    if (m_pendingRequests.Add(messageId, std::move(request))) {
+        m_requestsInFlight++;
+    }
+}
+
+/**
+ * Removes and returns the request waiting on the given CDP message id, if any.
+ */
+std::optional<HttpHookManager::WebHookItem> HttpHookManager::TakeRequest(long long messageId)
+{
+    std::optional<WebHookItem> request = m_pendingRequests.Take(messageId);
+
+    if (request.has_value()) {
+        m_requestsInFlight--;
+    }
+    return request;
+}
+
+/**
+ * Gives up on requests whose response body never arrived (i.e. the navigation was aborted or the target closed), 
+ * so they neither leak nor stay paused forever. Requests are continued unmodified, unless their body was already 
+ * taken as a stream, those are failed, see AbortRequest. Runs on the expiry timer, see StartExpiryTimer.
+ */
+void HttpHookManager::EvictExpiredRequests()
+{
+    const std::vector<WebHookItem> expiredRequests = m_pendingRequests.TakeExpired();
+    m_requestsInFlight -= expiredRequests.size();
+
+    if (expiredRequests.empty()) {
+        return;
+    }
+
+    const size_t abortedStreams = std::count_if(expiredRequests.begin(), expiredRequests.end(), [](const WebHookItem& request) {
+        return request.bodyStream && !request.bodyStream->handle.empty();
+    });
+
+    m_requestsExpired += expiredRequests.size();
+    m_streamsAborted += abortedStreams;
+    Logger.Warn("{} document request(s) timed out waiting for their response body, continued {} unmodified and failed {} already streamed. [in flight: {}, expired: {}, failed streams: {}]", 
+        expiredRequests.size(), expiredRequests.size() - abortedStreams, abortedStreams, m_requestsInFlight.load(), m_requestsExpired.load(), m_streamsAborted.load());
+
+    for (const auto& request : expiredRequests) {
+        AbortRequest(request);
+    }
+}
+
+HttpHookManager::PendingRequestStats HttpHookManager::GetPendingRequestStats() const
+{
+    return { m_requestsInFlight.load(), m_requestsCompleted.load(), m_requestsExpired.load(), m_streamsAborted.load() };
+}
+
+void HttpHookManager::StartExpiryTimer(websocketpp::client<websocketpp::config::asio_client>* client)
 {
-    std::unique_lock<std::shared_mutex> lock(m_requestMapMutex);
-    m_requestMap->push_back(request);
+    this->ScheduleExpiryCheck(client, ++m_expiryTimerGeneration);
 }
 
-template<typename Func>
-void HttpHookManager::ProcessRequests(Func processor)
+/**
+ * Requests can expire while the socket is quiet, so they're checked on a timer rather than when messages arrive.
+ */
+void HttpHookManager::ScheduleExpiryCheck(websocketpp::client<websocketpp::config::asio_client>* client, unsigned long long timerGeneration)
 {
-    std::unique_lock<std::shared_mutex> lock(m_requestMapMutex);
-    for (auto it = m_requestMap->begin(); it != m_requestMap->end();) {
-        if (processor(it)) {
-            it = m_requestMap->erase(it);
-        } else {
-            ++it;
+    const long expiryCheckInterval = static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(m_expiryCheckInterval).count());
+
+    client->set_timer(expiryCheckInterval, [this, client, timerGeneration](const websocketpp::lib::error_code& errorCode) 
+    {
+        /** Cancelled when the client shut down, or replaced by the timer of a newer connection. */
+        if (errorCode || timerGeneration != m_expiryTimerGeneration.load()) {
+            return;
         }
+
+        this->EvictExpiredRequests();
+        this->ScheduleExpiryCheck(client, timerGeneration);
+    });
+}
+
+void HttpHookManager::ContinueRequest(const std::string& requestId)
+{
+    PostGlobalMessage({
+        { "id", 0 },
+        { "method", "Fetch.continueRequest" },
+        { "params", { { "requestId", requestId } }}
+    });
+}
+
+/**
+ * Gives up on patching a request. Once its body has been taken as a stream the request can't be continued 
+ * anymore, it's failed instead and the stream is closed.
+ */
+void HttpHookManager::AbortRequest(const WebHookItem& request)
+{
+    if (!request.bodyStream || request.bodyStream->handle.empty()) {
+        ContinueRequest(request.requestId);
+        return;
     }
+
+    PostGlobalMessage({
+        { "id", 0 },
+        { "method", "IO.close" },
+        { "params", { { "handle", request.bodyStream->handle } }}
+    });
+    PostGlobalMessage({
+        { "id", 0 },
+        { "method", "Fetch.failRequest" },
+        { "params", { { "requestId", request.requestId }, { "errorReason", "Failed" } }}
+    });
 }
 
-// Thread-safe socket communication
+// Thread-safe socket communication, see CdpSendQueue
 void HttpHookManager::PostGlobalMessage(const nlohmann::json& message)
 {
-    std::lock_guard<std::mutex> lock(m_socketMutex);
     Sockets::PostGlobal(message);
 }
 
@@ -234,20 +537,35 @@ bool HttpHookManager::ShouldLogException()
 
 void HttpHookManager::SetupGlobalHooks() 
 {
-    PostGlobalMessage({
-        { "id", 3242 }, { "method", "Fetch.enable" },
-        { "params", {
-            { "patterns", {
-                { { "urlPattern", "*" }, { "resourceType", "Document" }, { "requestStage", "Response" } },     
-                { { "urlPattern", fmt::format("{}*", this->m_ipcHookAddress      ) }, { "requestStage", "Request" } },
-                { { "urlPattern", fmt::format("{}*", this->m_ftpHookAddress      ) }, { "requestStage", "Request" } },
-                /** Maintain backwards compatibility for themes that explicitly rely on this url */
-                { { "urlPattern", fmt::format("{}*", this->m_oldHookAddress      ) }, { "requestStage", "Request" } },
-                { { "urlPattern", fmt::format("{}*", this->m_javaScriptVirtualUrl) }, { "requestStage", "Request" } },
-                { { "urlPattern", fmt::format("{}*", this->m_styleSheetVirtualUrl) }, { "requestStage", "Request" } }
-            }
-        }}}
+    nlohmann::json patterns = nlohmann::json::array({
+        { { "urlPattern", fmt::format("{}*", this->m_ipcHookAddress      ) }, { "requestStage", "Request" } },
+        { { "urlPattern", fmt::format("{}*", this->m_ftpHookAddress      ) }, { "requestStage", "Request" } },
+        /** Maintain backwards compatibility for themes that explicitly rely on this url */
+        { { "urlPattern", fmt::format("{}*", this->m_oldHookAddress      ) }, { "requestStage", "Request" } },
+        { { "urlPattern", fmt::format("{}*", this->m_javaScriptVirtualUrl) }, { "requestStage", "Request" } },
+        { { "urlPattern", fmt::format("{}*", this->m_styleSheetVirtualUrl) }, { "requestStage", "Request" } }
+    });
+
+    /** Every document gets the preloader, the do-not-hook list can't be expressed as a pattern, see GetResponseBody. */
+    patterns.push_back({ { "urlPattern", "*" }, { "resourceType", "Document" }, { "requestStage", "Response" } });
+
+    /** Only scripts and stylesheets a response patch could match are paused. */
+    const std::vector<std::string> responsePatterns = BuildUrlPatterns(ResponsePatcher::get().GetUrlPatternSources());
+
+    for (const auto& responsePattern : responsePatterns)
+    {
+        patterns.push_back({ { "urlPattern", responsePattern }, { "resourceType", "Script"     }, { "requestStage", "Response" } });
+        patterns.push_back({ { "urlPattern", responsePattern }, { "resourceType", "Stylesheet" }, { "requestStage", "Response" } });
+    }
+
+    /** Declared rather than sent, so it's restored after a reconnect, see ReconnectManager. */
+    ReconnectManager::get().SetGlobalState("Fetch.enable", {
+        { "method", "Fetch.enable" },
+        { "params", { { "patterns", patterns } }}
     });
+
+    m_isFetchEnabled = true;
+    Logger.Log("Intercepting all documents, and scripts and stylesheets matching {} pattern(s)", responsePatterns.size());
 }
 
 bool HttpHookManager::IsGetBodyCall(const nlohmann::basic_json<>& message) 
@@ -266,7 +584,7 @@ bool HttpHookManager::IsIpcCall(const nlohmann::basic_json<>& message)
     return requestUrl.find(this->m_ipcHookAddress) != std::string::npos;
 }
 
-std::filesystem::path HttpHookManager::ConvertToLoopBack(const std::string& requestUrl)
+std::filesystem::path HttpHookManager::ConvertToLoopBack(const std::string& requestUrl, std::string* contentHash)
 {
     std::string url = requestUrl;
     
@@ -280,152 +598,553 @@ std::filesystem::path HttpHookManager::ConvertToLoopBack(const std::string& requ
     else if (cssPos != std::string::npos) url.erase(cssPos, std::string(this->m_styleSheetVirtualUrl).length());
     else if (oldPos != std::string::npos) url.erase(oldPos, std::string(this->m_oldHookAddress).length());
 
+    /** Content hashed urls are formatted as h/<hash>/<path>, the hash isn't part of the path. */
+    if (newPos != std::string::npos && url.rfind(m_contentHashPrefix, 0) == 0)
+    {
+        const size_t hashEnd = url.find('/', std::strlen(m_contentHashPrefix));
+
+        if (hashEnd != std::string::npos)
+        {
+            if (contentHash) *contentHash = url.substr(std::strlen(m_contentHashPrefix), hashEnd - std::strlen(m_contentHashPrefix));
+            url.erase(0, hashEnd + 1);
+        }
+    }
+
     return std::filesystem::path(PathFromUrl(url));
 }
 
-void HttpHookManager::RetrieveRequestFromDisk(const nlohmann::basic_json<>& message)
+/**
+ * Reads a file from disk and prepares it to be sent in a `Fetch.fulfillRequest`.
+ * 
+ * @param {std::filesystem::path} filePath - The path of the file to read.
+ * @returns {AssetCache::Asset} - The base64 encoded file contents and its response headers.
+ * @throws {std::runtime_error} - If the file couldn't be read.
+ */
+static std::shared_ptr<AssetCache::Asset> LoadAssetFromDisk(const std::filesystem::path& filePath)
 {
-    std::string fileContent;
-    std::filesystem::path localFilePath = this->ConvertToLoopBack(message["params"]["request"]["url"]);
-    std::ifstream localFileStream(localFilePath);
+    auto asset = std::make_shared<AssetCache::Asset>();
+    const std::vector<char> fileBytes = SystemIO::ReadFileBytesSync(filePath.string());
+
+    asset->contentHash = ContentHash(fileBytes.data(), fileBytes.size());
+    asset->body    = Base64Encode(fileBytes);
+    asset->headers = nlohmann::json::array
+    ({
+        { {"name", "Access-Control-Allow-Origin"}, {"value", "*"} },
+        { {"name", "Content-Type"}, {"value", fileTypes[EvaluateFileType(filePath)]} }
+    });
 
-    bool bFailedRead = !localFileStream.is_open();
-    if (bFailedRead)
+    /** Lets media elements fetch large files in parts, see ServeFileRange */
+    if (IsBinaryFile(EvaluateFileType(filePath)))
     {
-        LOG_ERROR("failed to retrieve file '{}' info from disk.", localFilePath.string());
+        asset->headers.push_back({ {"name", "Accept-Ranges"}, {"value", "bytes"} });
     }
 
-    uint16_t    responseCode    = bFailedRead ? 404 : 200;
-    std::string responseMessage = bFailedRead ? "millennium" : "millennium couldn't read " + localFilePath.string();
-    eFileType   fileType        = EvaluateFileType(localFilePath.string());
+    return asset;
+}
 
-    if (IsBinaryFile(fileType)) 
+/**
+ * Loads an asset from its directory's pack when one is mounted and current, otherwise from disk.
+ */
+static std::shared_ptr<AssetCache::Asset> LoadAsset(const std::filesystem::path& filePath)
+{
+    if (g_assetPacksMounted.load(std::memory_order_acquire))
     {
-        try
+        if (std::shared_ptr<AssetCache::Asset> asset = AssetPackManager::get().Find(filePath))
         {
-            fileContent = Base64Encode(SystemIO::ReadFileBytesSync(localFilePath.string()));
+            return asset;
         }
-        catch(const std::exception& error)
-        {
-            LOG_ERROR("Failed to read file bytes from disk: {}", error.what());
-            bFailedRead = true; /** Force fail even if the file exists. */
-        }       
-    } 
-    else 
-    {
-        fileContent = Base64Encode(std::string(
-            std::istreambuf_iterator<char>(localFileStream),
-            std::istreambuf_iterator<char>()
-        ));
     }
-
-    const auto responseHeaders = nlohmann::json::array
-    ({
-        { {"name", "Access-Control-Allow-Origin"}, {"value", "*"} },
-        { {"name", "Content-Type"}, {"value", fileTypes[fileType]} }
-    });
-
-    PostGlobalMessage({
-        { "id", 63453 },
-        { "method", "Fetch.fulfillRequest" },
-        { "params", {
-            { "responseCode", responseCode },
-            { "requestId", message["params"]["requestId"] },
-            { "responseHeaders", responseHeaders },
-            { "responsePhrase", responseMessage },
-            { "body", fileContent }
-        }}
-    });
+    return LoadAssetFromDisk(filePath);
 }
 
-void HttpHookManager::GetResponseBody(const nlohmann::basic_json<>& message)
+/**
+ * Finds a request header by name, header names are case-insensitive.
+ */
+static std::string FindRequestHeader(const nlohmann::basic_json<>& headers, const std::string& headerName)
 {
-    const RedirectType statusCode = message["params"]["responseStatusCode"].get<RedirectType>();
-
-    const auto ContinueOriginalRequest = [this, &message]() {
-        PostGlobalMessage({
-            { "id", 0 },
-            { "method", "Fetch.continueRequest" },
-            { "params", { { "requestId", message["params"]["requestId"] } }}
-        });
-    };
-
-    // Check if the request URL is a do-not-hook URL.
-    for (const auto& doNotHook : g_doNotHook) 
+    for (const auto& [name, value] : headers.items())
     {
-        if (std::regex_match(message["params"]["request"]["url"].get<std::string>(), std::regex(doNotHook))) 
+        if (name.size() == headerName.size() && std::equal(name.begin(), name.end(), headerName.begin(), 
+            [](unsigned char a, unsigned char b) { return std::tolower(a) == std::tolower(b); }))
         {
-            ContinueOriginalRequest();
-            return;
+            return value.is_string() ? value.get<std::string>() : std::string();
         }
     }
+    return {};
+}
 
-    // If the status code is a redirect, we just continue the request. 
-    if (statusCode == REDIRECT || statusCode == MOVED_PERMANENTLY || statusCode == FOUND || 
-        statusCode == TEMPORARY_REDIRECT || statusCode == PERMANENT_REDIRECT)
-    {
-        ContinueOriginalRequest();
-    }
-    else
+/**
+ * Finds a response header by name in a `Fetch.requestPaused` header array, header names are case-insensitive.
+ */
+static std::string FindResponseHeader(const nlohmann::basic_json<>& headers, const std::string& headerName)
+{
+    if (!headers.is_array()) return {};
+
+    for (const auto& header : headers)
     {
-        long long currentMessageId = hookMessageId.fetch_sub(1) - 1;
-        
-        WebHookItem item = {
-            currentMessageId,
-            message.value("/params/requestId"_json_pointer, std::string{}),
-            message.value("/params/resourceType"_json_pointer, std::string{}), 
-            message
-        };
-        
-        AddRequest(item);
+        const std::string name = header.value("name", std::string{});
 
-        PostGlobalMessage({
-            { "id", currentMessageId },
-            { "method", "Fetch.getResponseBody" },
-            { "params", { { "requestId", message["params"]["requestId"] } }}
-        });
+        if (name.size() == headerName.size() && std::equal(name.begin(), name.end(), headerName.begin(), 
+            [](unsigned char a, unsigned char b) { return std::tolower(a) == std::tolower(b); }))
+        {
+            return header.value("value", std::string{});
+        }
     }
+    return {};
 }
 
-const std::string HttpHookManager::PatchDocumentContents(const std::string& requestUrl, const std::string& original) 
+/**
+ * Gets the entity tag of a file from its size and last write time, so partial responses never have to read 
+ * the whole file to validate it.
+ * 
+ * @returns {std::string} - The quoted entity tag, empty if the file couldn't be stat'ed.
+ */
+static std::string GetFileEntityTag(const std::filesystem::path& filePath, std::uintmax_t fileSize)
 {
-    std::string patched = original;
-    std::optional<std::string> millenniumPreloadPath = SystemIO::GetMillenniumPreloadPath();
+    std::error_code errorCode;
+    const auto lastWriteTime = std::filesystem::last_write_time(filePath, errorCode);
 
-    if (!millenniumPreloadPath.has_value()) 
+    if (errorCode)
     {
-        LOG_ERROR("Missing webkit preload module. Please re-install Millennium.");
-        #ifdef _WIN32
-        MessageBoxA(NULL, "Missing webkit preload module. Please re-install Millennium.", "Millennium", MB_ICONERROR);
-        #endif
-        return patched;
+        return {};
     }
 
-    // Get thread-safe copy of hook list
-    auto hookList = GetHookListCopy();
-    
-    std::vector<std::string> scriptModules;
-    std::string cssShimContent, scriptModuleArray;
-    std::string linkPreloadsArray;
+    return fmt::format("\"{:x}-{:x}\"", fileSize, static_cast<std::uint64_t>(lastWriteTime.time_since_epoch().count()));
+}
+
+/**
+ * Answers a Range request with 206 Partial Content, reading only the requested bytes from disk. 
+ * Ranges are capped at m_maxRangeLength, which the client has to accept and continue from. The ETag is derived 
+ * from the file's size and write time, partial responses are always revalidated as their content isn't hashed.
+ * 
+ * @returns {boolean} - `false` if the request should be served as a regular, full request.
+ */
+bool HttpHookManager::ServeFileRange(const nlohmann::basic_json<>& message, const std::filesystem::path& filePath, const std::string& rangeHeader)
+{
+    std::error_code errorCode;
+    const std::uintmax_t fileSize = std::filesystem::file_size(filePath, errorCode);
 
-    for (const auto& hookItem : hookList) 
+    if (errorCode)
     {
-        if (hookItem.type == TagTypes::STYLESHEET) 
+        return false;
+    }
+
+    std::uintmax_t firstByte = 0, lastByte = 0;
+    bool isSatisfiable = false;
+
+    if (!ParseByteRange(rangeHeader, fileSize, firstByte, lastByte, isSatisfiable))
+    {
+        return false;
+    }
+
+    nlohmann::json responseHeaders = nlohmann::json::array
+    ({
+        { {"name", "Access-Control-Allow-Origin"}, {"value", "*"} },
+        { {"name", "Content-Type"}, {"value", fileTypes[EvaluateFileType(filePath)]} },
+        { {"name", "Accept-Ranges"}, {"value", "bytes"} }
+    });
+
+    const std::string entityTag = GetFileEntityTag(filePath, fileSize);
+
+    if (!entityTag.empty())
+    {
+        responseHeaders.push_back({ {"name", "ETag"}, {"value", entityTag} });
+    }
+    responseHeaders.push_back({ {"name", "Cache-Control"}, {"value", "no-cache"} });
+
+    if (!isSatisfiable)
+    {
+        responseHeaders.push_back({ {"name", "Content-Range"}, {"value", fmt::format("bytes */{}", fileSize)} });
+
+        PostGlobalMessage({
+            { "id", 63453 },
+            { "method", "Fetch.fulfillRequest" },
+            { "params", {
+                { "responseCode", 416 },
+                { "requestId", message["params"]["requestId"] },
+                { "responseHeaders", responseHeaders },
+                { "responsePhrase", "Range Not Satisfiable" },
+                { "body", std::string() }
+            }}
+        });
+        return true;
+    }
+
+    lastByte = std::min<std::uintmax_t>(lastByte, firstByte + m_maxRangeLength - 1);
+    const size_t rangeLength = static_cast<size_t>(lastByte - firstByte + 1);
+
+    std::string rangeBody;
+    try
+    {
+        rangeBody = Base64Encode(SystemIO::ReadFileRangeSync(filePath.string(), firstByte, rangeLength));
+    }
+    catch (const std::exception& error)
+    {
+        LOG_ERROR("failed to read range {}-{} of '{}': {}", firstByte, lastByte, filePath.string(), error.what());
+        return false;
+    }
+
+    responseHeaders.push_back({ {"name", "Content-Range"}, {"value", fmt::format("bytes {}-{}/{}", firstByte, lastByte, fileSize)} });
+    responseHeaders.push_back({ {"name", "Content-Length"}, {"value", std::to_string(rangeLength)} });
+
+    nlohmann::json fulfillMessage = {
+        { "id", 63453 },
+        { "method", "Fetch.fulfillRequest" },
+        { "params", {
+            { "responseCode", 206 },
+            { "requestId", message["params"]["requestId"] },
+            { "responseHeaders", std::move(responseHeaders) },
+            { "responsePhrase", "Partial Content" }
+        }}
+    };
+
+    fulfillMessage["params"]["body"] = std::move(rangeBody);
+    PostGlobalMessage(fulfillMessage);
+    return true;
+}
+
+/**
+ * Gets the up to date gzip variant of an asset, if the request allows it. 
+ * Missing or stale variants are queued to be rebuilt and the asset is served with identity encoding meanwhile.
+ */
+static std::shared_ptr<const AssetCache::Asset> GetCompressedVariant(const nlohmann::basic_json<>& message, const std::filesystem::path& filePath, const AssetCache::Asset& asset)
+{
+    if (asset.fileSize < AssetPrecompressor::m_minimumFileSize || !AssetPrecompressor::IsCompressible(filePath))
+    {
+        return nullptr;
+    }
+
+    /** Intercepted requests usually don't list it yet, gzip is always supported by the browser itself. */
+    const std::string acceptEncoding = FindRequestHeader(message["params"]["request"]["headers"], "Accept-Encoding");
+
+    if (!acceptEncoding.empty() && acceptEncoding.find("gzip") == std::string::npos)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<const AssetCache::Asset> variant = AssetCache::get().Get(AssetPrecompressor::get().VariantPath(filePath), LoadAssetFromDisk);
+
+    if (!variant || variant->lastWriteTime != asset.lastWriteTime)
+    {
+        AssetPrecompressor::get().Enqueue(filePath);
+        return nullptr;
+    }
+
+    return variant;
+}
+
+void HttpHookManager::RetrieveRequestFromDisk(const nlohmann::basic_json<>& message)
+{
+    std::string requestedHash;
+    std::filesystem::path localFilePath = this->ConvertToLoopBack(message["params"]["request"]["url"], &requestedHash);
+
+    /** 
+     * Partial requests are read straight from disk. Files above m_rangeThreshold are never loaded as a whole either, 
+     * they're answered with their first part and the client continues with Range requests.
+     */
+    std::string rangeHeader = FindRequestHeader(message["params"]["request"]["headers"], "Range");
+
+    if (rangeHeader.empty())
+    {
+        std::error_code errorCode;
+        const std::uintmax_t fileSize = std::filesystem::file_size(localFilePath, errorCode);
+
+        if (!errorCode && fileSize > m_rangeThreshold)
         {
-            if (!std::regex_match(requestUrl, hookItem.urlPattern)) 
-                continue;
+            rangeHeader = "bytes=0-";
+        }
+    }
+
+    if (!rangeHeader.empty() && this->ServeFileRange(message, localFilePath, rangeHeader))
+    {
+        return;
+    }
+
+    const auto loadStartedAt = HookMetrics::Clock::now();
+    std::shared_ptr<const AssetCache::Asset> asset = AssetCache::get().Get(localFilePath, LoadAsset);
+
+    HookMetrics::get().Record(HookMetrics::ResourceTypeFromString(message["params"].value("resourceType", std::string{})), HookMetrics::ASSET_LOAD, loadStartedAt);
+
+    if (!asset)
+    {
+        LOG_ERROR("failed to retrieve file '{}' info from disk.", localFilePath.string());
+
+        PostGlobalMessage({
+            { "id", 63453 },
+            { "method", "Fetch.fulfillRequest" },
+            { "params", {
+                { "responseCode", 404 },
+                { "requestId", message["params"]["requestId"] },
+                { "responseHeaders", nlohmann::json::array({ { {"name", "Access-Control-Allow-Origin"}, {"value", "*"} } }) },
+                { "responsePhrase", "millennium couldn't read " + localFilePath.string() },
+                { "body", std::string() }
+            }}
+        });
+        return;
+    }
+
+    const std::string entityTag = fmt::format("\"{}\"", asset->contentHash);
+    nlohmann::json responseHeaders = asset->headers;
+
+    /** 
+     * A url may only be cached forever if its hash matches the file, relative imports of a hashed module 
+     * inherit the importer's hash. Everything else has to be revalidated with its ETag.
+     */
+    const bool isImmutable = !requestedHash.empty() && requestedHash == asset->contentHash;
+
+    responseHeaders.push_back({ {"name", "ETag"}, {"value", entityTag} });
+    responseHeaders.push_back({ {"name", "Cache-Control"}, {"value", isImmutable ? "public, max-age=31536000, immutable" : "no-cache"} });
+
+    std::shared_ptr<const AssetCache::Asset> compressedVariant = m_precompressedAssets ? GetCompressedVariant(message, localFilePath, *asset) : nullptr;
+
+    if (m_precompressedAssets && AssetPrecompressor::IsCompressible(localFilePath))
+    {
+        responseHeaders.push_back({ {"name", "Vary"}, {"value", "Accept-Encoding"} });
+    }
+    if (compressedVariant)
+    {
+        responseHeaders.push_back({ {"name", "Content-Encoding"}, {"value", "gzip"} });
+    }
+
+    if (FindRequestHeader(message["params"]["request"]["headers"], "If-None-Match") == entityTag)
+    {
+        PostGlobalMessage({
+            { "id", 63453 },
+            { "method", "Fetch.fulfillRequest" },
+            { "params", {
+                { "responseCode", 304 },
+                { "requestId", message["params"]["requestId"] },
+                { "responseHeaders", responseHeaders },
+                { "responsePhrase", "Not Modified" },
+                { "body", std::string() }
+            }}
+        });
+        return;
+    }
+
+    PostGlobalMessage({
+        { "id", 63453 },
+        { "method", "Fetch.fulfillRequest" },
+        { "params", {
+            { "responseCode", 200 },
+            { "requestId", message["params"]["requestId"] },
+            { "responseHeaders", responseHeaders },
+            { "responsePhrase", "millennium" },
+            { "body", compressedVariant ? compressedVariant->body : asset->body }
+        }}
+    });
+}
+
+/**
+ * Serves a virtual module bundle created by the shim builder, see ModuleBundler
+ */
+void HttpHookManager::ServeBundle(const nlohmann::basic_json<>& message)
+{
+    const std::string requestUrl = message["params"]["request"]["url"].get<std::string>();
+    const size_t keyStart = requestUrl.find(m_bundlePrefix, std::strlen(m_ftpHookAddress)) + std::strlen(m_bundlePrefix);
+    const std::string bundleKey = requestUrl.substr(keyStart, requestUrl.find(".js", keyStart) - keyStart);
+
+    std::shared_ptr<const AssetCache::Asset> bundle = ModuleBundler::get().GetBundle(bundleKey, LoadAsset);
+    nlohmann::json responseHeaders = bundle ? bundle->headers : nlohmann::json::array({ { {"name", "Access-Control-Allow-Origin"}, {"value", "*"} } });
+    int responseCode = bundle ? 200 : 404;
 
-            cssShimContent.append(fmt::format("<link rel=\"stylesheet\" href=\"{}\">\n", UrlFromPath(m_ftpHookAddress, hookItem.path))); 
+    if (bundle)
+    {
+        /** Bundles are rebuilt from the current module contents, so the url itself can't be cached for good. */
+        const std::string entityTag = fmt::format("\"{}\"", bundle->contentHash);
+
+        responseHeaders.push_back({ {"name", "ETag"}, {"value", entityTag} });
+        responseHeaders.push_back({ {"name", "Cache-Control"}, {"value", "no-cache"} });
+
+        if (FindRequestHeader(message["params"]["request"]["headers"], "If-None-Match") == entityTag)
+        {
+            responseCode = 304;
+        }
+    }
+    else
+    {
+        LOG_ERROR("unknown webkit module bundle '{}'", bundleKey);
+    }
+
+    PostGlobalMessage({
+        { "id", 63453 },
+        { "method", "Fetch.fulfillRequest" },
+        { "params", {
+            { "responseCode", responseCode },
+            { "requestId", message["params"]["requestId"] },
+            { "responseHeaders", responseHeaders },
+            { "responsePhrase", responseCode == 404 ? "millennium couldn't find bundle " + bundleKey : "millennium" },
+            { "body", responseCode == 200 ? bundle->body : std::string() }
+        }}
+    });
+}
+
+bool HttpHookManager::IsBundleCall(const nlohmann::basic_json<>& message)
+{
+    const std::string requestUrl = message["params"]["request"]["url"].get<std::string>();
+    return requestUrl.rfind(std::string(m_ftpHookAddress) + m_bundlePrefix, 0) == 0;
+}
+
+void HttpHookManager::GetResponseBody(const nlohmann::basic_json<>& message, std::chrono::steady_clock::time_point pausedAt)
+{
+    const RedirectType statusCode = message["params"]["responseStatusCode"].get<RedirectType>();
+
+    const auto ContinueOriginalRequest = [this, &message]() {
+        ContinueRequest(message["params"]["requestId"].get<std::string>());
+    };
+
+    const std::string& requestUrl = message["params"]["request"]["url"].get_ref<const std::string&>();
+    const std::string resourceType = message.value("/params/resourceType"_json_pointer, std::string{});
+    const bool isDocument = resourceType == "Document";
+
+    const auto RecordTotal = [&]() {
+        if (isDocument) HookMetrics::get().RecordDocument(requestUrl, pausedAt);
+        else            HookMetrics::get().Record(HookMetrics::ResourceTypeFromString(resourceType), HookMetrics::TOTAL, pausedAt);
+    };
+
+    if (isDocument)
+    {
+        const unsigned long long documentPauses = ++m_documentPauses;
+
+        if (documentPauses % m_documentStatsLogInterval == 0)
+        {
+            Logger.Log("Document interception: {} paused, {} on the do-not-hook list", documentPauses, m_deniedDocumentPauses.load());
+        }
+    }
+
+    // Documents are patched (at least with the preloader) unless the url is a do-not-hook URL, 
+    // scripts and stylesheets if a response patch matches it.
+    const bool hasPatches = isDocument 
+        ? UrlPolicy::get().Evaluate(requestUrl) != UrlPolicy::DENY_ALL
+        : ResponsePatcher::get().HasPatchesFor(requestUrl);
+
+    if (!hasPatches) 
+    {
+        if (isDocument) m_deniedDocumentPauses++;
+        ContinueOriginalRequest();
+        RecordTotal();
+        return;
+    }
+
+    // If the status code is a redirect, we just continue the request. 
+    if (statusCode == REDIRECT || statusCode == MOVED_PERMANENTLY || statusCode == FOUND || 
+        statusCode == TEMPORARY_REDIRECT || statusCode == PERMANENT_REDIRECT)
+    {
+        ContinueOriginalRequest();
+        RecordTotal();
+    }
+    else
+    {
+        long long currentMessageId = hookMessageId.fetch_sub(1) - 1;
+
+        /** Large documents are streamed, the head tag is usually found in the first chunk. */
+        const std::string contentLength = isDocument ? FindResponseHeader(message["params"].value("responseHeaders", nlohmann::json::array()), "Content-Length") : std::string();
+        std::shared_ptr<BodyStream> bodyStream;
+
+        if (!contentLength.empty() && std::strtoull(contentLength.c_str(), nullptr, 10) > m_streamingThreshold)
+        {
+            bodyStream = std::make_shared<BodyStream>();
+            bodyStream->contentLength = static_cast<size_t>(std::strtoull(contentLength.c_str(), nullptr, 10));
+            /** Built upfront, once the body is taken the request can't be continued unmodified anymore. */
+            bodyStream->shimContent = BuildDocumentShim(requestUrl);
+
+            if (!bodyStream->shimContent)
+            {
+                ContinueOriginalRequest();
+                return;
+            }
+        }
+        
+        WebHookItem item = {
+            currentMessageId,
+            message.value("/params/requestId"_json_pointer, std::string{}),
+            resourceType, 
+            message,
+            pausedAt,
+            HookMetrics::Clock::now(),
+            bodyStream
+        };
+        
+        HookMetrics::get().Record(HookMetrics::ResourceTypeFromString(resourceType), HookMetrics::BODY_REQUEST, item.pausedAt, item.bodyRequestedAt);
+        AddRequest(std::move(item));
+
+        PostGlobalMessage({
+            { "id", currentMessageId },
+            { "method", bodyStream ? "Fetch.takeResponseBodyAsStream" : "Fetch.getResponseBody" },
+            { "params", { { "requestId", message["params"]["requestId"] } }}
+        });
+    }
+}
+
+/**
+ * Gets the url a hooked asset is served from. When enabled, assets whose contents are known are 
+ * addressed by their hash, so the browser can keep them in its cache for good.
+ */
+std::string HttpHookManager::AssetUrlFromPath(const std::string& filePath)
+{
+    if (m_contentHashedUrls)
+    {
+        if (std::optional<std::string> contentHash = AssetCache::get().GetContentHash(filePath, LoadAsset))
+        {
+            return UrlFromPath(fmt::format("{}{}{}/", m_ftpHookAddress, m_contentHashPrefix, contentHash.value()), filePath);
+        }
+    }
+
+    return UrlFromPath(m_ftpHookAddress, filePath);
+}
+
+/**
+ * Formats the content that is injected into a document from the given hooks.
+ * @note The caller must hold m_shimCacheMutex.
+ */
+std::string HttpHookManager::FormatDocumentShim(const HookSnapshot& snapshot, const std::vector<size_t>& matchedHooks, const std::string& preloadPath, bool allowJavaScript, DocumentAssets& documentAssets)
+{
+    std::vector<std::string> scriptModules, scriptModulePaths;
+    std::string cssShimContent, scriptModuleArray;
+    std::string linkPreloadsArray;
+
+    for (const size_t hookIndex : matchedHooks) 
+    {
+        const HookType& hookItem = snapshot.hooks[hookIndex];
+
+        if (hookItem.type == TagTypes::STYLESHEET) 
+        {
+            cssShimContent.append(fmt::format("<link rel=\"stylesheet\" href=\"{}\">\n", AssetUrlFromPath(hookItem.path))); 
+            documentAssets.paths.push_back(hookItem.path);
         }
         else if (hookItem.type == TagTypes::JAVASCRIPT) 
         {
-            if (!std::regex_match(requestUrl, hookItem.urlPattern)) 
-                continue;
+            scriptModulePaths.push_back(hookItem.path);
+        }
+    }
 
-            auto jsPath = UrlFromPath(this->m_ftpHookAddress, hookItem.path);
-            scriptModules.push_back(jsPath);
-            linkPreloadsArray.append(fmt::format("<link rel=\"modulepreload\" href=\"{}\" fetchpriority=\"high\">\n", jsPath));
+    if (!allowJavaScript) 
+    {
+        return cssShimContent; // Remove all queried JavaScript from the page. 
+    }
+
+    /** Matched webkit modules are served as one virtual module where possible, see ModuleBundler */
+    if (m_bundleWebkitModules) 
+    {
+        ModuleBundler::BundlePlan bundlePlan = ModuleBundler::get().Plan(scriptModulePaths, LoadAsset, snapshot.generation, m_shimCacheContentEpoch);
+
+        if (!bundlePlan.bundleKey.empty()) 
+        {
+            scriptModules.push_back(fmt::format("{}{}{}.js", m_ftpHookAddress, m_bundlePrefix, bundlePlan.bundleKey));
+            documentAssets.bundleKey = bundlePlan.bundleKey;
         }
+        scriptModulePaths = std::move(bundlePlan.standalonePaths);
+    }
+
+    for (const auto& scriptModulePath : scriptModulePaths) 
+    {
+        scriptModules.push_back(AssetUrlFromPath(scriptModulePath));
+        documentAssets.paths.push_back(scriptModulePath);
+    }
+
+    for (const auto& scriptModule : scriptModules) 
+    {
+        linkPreloadsArray.append(fmt::format("<link rel=\"modulepreload\" href=\"{}\" fetchpriority=\"high\">\n", scriptModule));
     }
 
     for (size_t i = 0; i < scriptModules.size(); i++)
@@ -434,83 +1153,394 @@ const std::string HttpHookManager::PatchDocumentContents(const std::string& requ
     }
 
     const std::string millenniumAuthToken = GetAuthToken();
-    const std::string ftpPath = UrlFromPath(m_ftpHookAddress, millenniumPreloadPath.value_or(std::string()));
+    const std::string ftpPath = AssetUrlFromPath(preloadPath);
     const std::string scriptContent = fmt::format("(new module.default).StartPreloader('{}', [{}]);", millenniumAuthToken, scriptModuleArray);
 
     linkPreloadsArray.insert(0, fmt::format("<link rel=\"modulepreload\" href=\"{}\" fetchpriority=\"high\">\n", ftpPath));
+    /** The preloader is only requested by documents that are allowed to run JavaScript. */
+    documentAssets.paths.push_back(preloadPath);
 
     std::string importScript = fmt::format("import('{}').then(module => {{ {} }}).catch(error => window.location.reload())", ftpPath, scriptContent);
-    std::string shimContent = fmt::format("{}<script type=\"module\" async id=\"millennium-injected\">{}</script>\n{}", linkPreloadsArray, importScript, cssShimContent);
+    return fmt::format("{}<script type=\"module\" async id=\"millennium-injected\">{}</script>\n{}", linkPreloadsArray, importScript, cssShimContent);
+}
+
+/**
+ * Gets the content that is injected into the head of the given document.
+ * 
+ * Shims only depend on the hook list and the url policy, so they're cached per hook list generation 
+ * and keyed by the set of matched hooks and the policy verdict. 
+ * 
+ * @returns The shim, or nullptr if the document shouldn't be patched.
+ */
+std::shared_ptr<const std::string> HttpHookManager::BuildDocumentShim(const std::string& requestUrl) 
+{
+    const bool allowJavaScript = UrlPolicy::get().Evaluate(requestUrl) != UrlPolicy::DENY_JAVASCRIPT;
+
+    const std::shared_ptr<const HookSnapshot> snapshot = GetHookSnapshot();
+
+    /** Only the hooks whose pattern matches the request url are visited */
+    const std::vector<size_t> matchedHooks = snapshot->matcher.Match(requestUrl);
+    const unsigned long long generation = snapshot->generation;
+
+    std::string cacheKey = allowJavaScript ? "js" : "css";
+    for (const size_t hookIndex : matchedHooks) 
+    {
+        cacheKey.append(":").append(std::to_string(hookIndex));
+        HookMetrics::get().RecordHookMatch(snapshot->hooks[hookIndex].id);
+    }
+
+    /** Shims embed content hashes, so they're also stale once any cached asset changes. */
+    const unsigned long long contentEpoch = AssetCache::get().GetInvalidationEpoch();
+
+    std::lock_guard<std::mutex> shimCacheLock(m_shimCacheMutex);
+
+    if (m_shimCacheGeneration != generation || m_shimCacheContentEpoch != contentEpoch) 
+    {
+        m_shimCache.clear();
+        m_preloadPath.reset();
+        m_shimCacheGeneration = generation;
+        m_shimCacheContentEpoch = contentEpoch;
+        ModuleBundler::get().RetireBundles();
+    }
 
-    for (const auto& blackListedUrl : g_blackListedUrls)        
+    if (auto cachedShim = m_shimCache.find(cacheKey); cachedShim != m_shimCache.end()) 
     {
-        if (std::regex_match(requestUrl, std::regex(blackListedUrl))) 
+        /** Only the first document of a shim warms its assets, later ones would walk the same import graph again. */
+        if (m_prefetchAssets && !cachedShim->second.isPrefetched) 
         {
-            shimContent = cssShimContent; // Remove all queried JavaScript from the page. 
+            cachedShim->second.isPrefetched = true;
+            ScheduleRequest(RequestScheduler::PREFETCH, [this, assets = cachedShim->second.assets]() { PrefetchDocumentAssets(*assets); });
         }
+        return cachedShim->second.content;
     }
 
-    if (patched.find("<head>") == std::string::npos) 
+    if (!m_preloadPath.has_value()) 
     {
-        return patched;
+        m_preloadPath = SystemIO::GetMillenniumPreloadPath();
     }
 
-    return patched.replace(patched.find("<head>"), 6, "<head>" + shimContent);
+    if (!m_preloadPath.has_value()) 
+    {
+        LOG_ERROR("Missing webkit preload module. Please re-install Millennium.");
+        #ifdef _WIN32
+        MessageBoxA(NULL, "Missing webkit preload module. Please re-install Millennium.", "Millennium", MB_ICONERROR);
+        #endif
+        return nullptr;
+    }
+
+    if (m_shimCache.size() >= m_maxShimCacheEntries) 
+    {
+        m_shimCache.clear();
+        ModuleBundler::get().RetireBundles();
+    }
+
+    auto documentAssets = std::make_shared<DocumentAssets>();
+    auto shimContent = std::make_shared<const std::string>(FormatDocumentShim(*snapshot, matchedHooks, m_preloadPath.value(), allowJavaScript, *documentAssets));
+    m_shimCache.emplace(std::move(cacheKey), DocumentShim { shimContent, documentAssets, m_prefetchAssets });
+
+    if (m_prefetchAssets) 
+    {
+        ScheduleRequest(RequestScheduler::PREFETCH, [this, documentAssets]() { PrefetchDocumentAssets(*documentAssets); });
+    }
+    return shimContent;
 }
 
-void HttpHookManager::HandleHooks(const nlohmann::basic_json<>& message)
+/**
+ * Loads the assets a document shim references, and the modules they statically import, into the asset cache. 
+ * The browser requests them right after it parsed the patched document, their paused requests are then 
+ * fulfilled from memory rather than waiting on the disk.
+ */
+void HttpHookManager::PrefetchDocumentAssets(const DocumentAssets& documentAssets)
 {
-    ProcessRequests([&](auto requestIterator) -> bool
+    const auto prefetchStartedAt = std::chrono::steady_clock::now();
+
+    std::unordered_set<std::string> visitedPaths;
+    std::deque<std::string> pendingPaths(documentAssets.paths.begin(), documentAssets.paths.end());
+
+    while (!pendingPaths.empty() && visitedPaths.size() < m_maxPrefetchedAssets)
     {
-        try
+        const std::filesystem::path filePath = std::move(pendingPaths.front());
+        pendingPaths.pop_front();
+
+        if (!visitedPaths.insert(filePath.generic_string()).second) continue;
+
+        std::shared_ptr<const AssetCache::Asset> asset = AssetCache::get().Get(filePath, LoadAsset);
+
+        if (!asset || EvaluateFileType(filePath) != eFileType::js) continue;
+
+        for (const auto& specifier : ModuleBundler::FindStaticImports(Base64Decode(asset->body)))
         {
-            auto [id, requestId, type, response] = (*requestIterator);
-           
-            int64_t messageId = message.value(json::json_pointer("/id"), int64_t(0));
-            bool base64Encoded = message.value(json::json_pointer("/result/base64Encoded"), false);
-           
-            if (messageId != id || (messageId == id && !base64Encoded)) {
-                return false; 
-            }
-           
-            std::string requestUrl = response.value(json::json_pointer("/params/request/url"), std::string{});
-            std::string responseBody = message.value(json::json_pointer("/result/body"), std::string{});
-           
-            if (requestUrl.empty() || responseBody.empty()) {
-                return true; 
+            pendingPaths.push_back((filePath.parent_path() / specifier).lexically_normal().generic_string());
+        }
+    }
+
+    if (!documentAssets.bundleKey.empty())
+    {
+        ModuleBundler::get().GetBundle(documentAssets.bundleKey, LoadAsset);
+    }
+
+    HookMetrics::get().Record(HookMetrics::DOCUMENT, HookMetrics::PREFETCH, prefetchStartedAt);
+}
+
+/**
+ * Injects the shim after the document's head tag. The body is decoded, patched and re-encoded in a single pass.
+ * @returns The base64 encoded document.
+ */
+static std::string InjectDocumentShim(const std::string& responseBody, bool base64Encoded, const std::string& shimContent)
+{
+    HtmlHeadInjector injector(shimContent);
+
+    if (base64Encoded) 
+    {
+        injector.Reserve(responseBody.size() / 4 * 3);
+        injector.WriteBase64(responseBody);
+    }
+    else 
+    {
+        injector.Reserve(responseBody.size());
+        injector.Write(responseBody);
+    }
+
+    return injector.Finish();
+}
+
+/**
+ * Builds the `Fetch.fulfillRequest` of a paused response from its status and headers, the body is left to the caller.
+ */
+static nlohmann::json MakeFulfillMessage(const std::string& requestId, const nlohmann::basic_json<>& pausedMessage)
+{
+    const int responseCode = pausedMessage.value(json::json_pointer("/params/responseStatusCode"), 200);
+    const std::string responseMessage = pausedMessage.value(json::json_pointer("/params/responseStatusText"), std::string{"OK"});
+    nlohmann::json responseHeaders = pausedMessage.value(json::json_pointer("/params/responseHeaders"), nlohmann::json::array());
+
+    return {
+        { "id", 63453 },
+        { "method", "Fetch.fulfillRequest" },
+        { "params", {
+            { "requestId", requestId },
+            { "responseCode", responseCode },
+            { "responseHeaders", std::move(responseHeaders) },
+            { "responsePhrase", responseMessage.empty() ? "OK" : responseMessage }
+        }}
+    };
+}
+
+/**
+ * Serializes a message from MakeFulfillMessage with the given base64 body. The body is written straight into 
+ * the frame, it would otherwise be copied into the JSON message first and then again when it's dumped.
+ */
+static std::string SerializeFulfillMessage(const nlohmann::json& fulfillMessage, const std::string& base64Body)
+{
+    static constexpr std::string_view bodyKey = ",\"body\":\"";
+    std::string frame = fulfillMessage.dump();
+
+    /** `params` is the message's last key and is never empty, so the frame ends with the two closing braces. */
+    const std::string_view closingBraces = "}}";
+    frame.resize(frame.size() - closingBraces.size());
+    frame.reserve(frame.size() + bodyKey.size() + base64Body.size() + 1 + closingBraces.size());
+
+    /** Base64 has no characters that need escaping in a JSON string. */
+    frame.append(bodyKey).append(base64Body).append("\"").append(closingBraces);
+    return frame;
+}
+
+/**
+ * Requests the next chunk of a streamed body, the request is parked under the id of the `IO.read` call.
+ */
+void HttpHookManager::ReadBodyStream(WebHookItem request)
+{
+    const long long currentMessageId = hookMessageId.fetch_sub(1) - 1;
+    const std::string handle = request.bodyStream->handle;
+
+    request.id = currentMessageId;
+    AddRequest(std::move(request));
+
+    PostGlobalMessage({
+        { "id", currentMessageId },
+        { "method", "IO.read" },
+        { "params", { { "handle", handle }, { "size", m_streamChunkSize } }}
+    });
+}
+
+/**
+ * Handles the replies of a streamed document. The `Fetch.takeResponseBodyAsStream` reply carries the stream handle, 
+ * each `IO.read` reply the next chunk. Chunks are fed through the injector as they arrive, so only the encoded output 
+ * and a single chunk are held at once. Past the head tag the chunks are spliced into the output without decoding.
+ */
+void HttpHookManager::HandleBodyStream(const nlohmann::basic_json<>& message, WebHookItem request)
+{
+    BodyStream& bodyStream = *request.bodyStream;
+
+    try
+    {
+        if (message.contains("error"))
+        {
+            if (ShouldLogException()) LOG_ERROR("failed to stream response body -> {}", message["error"].dump());
+            AbortRequest(request);
+            return;
+        }
+
+        if (bodyStream.handle.empty())
+        {
+            bodyStream.handle = message.value(json::json_pointer("/result/stream"), std::string{});
+
+            if (bodyStream.handle.empty())
+            {
+                ContinueRequest(request.requestId);
+                return;
             }
-           
-            const std::string patchedContent = this->PatchDocumentContents(requestUrl, Base64Decode(responseBody));
-            BypassCSP();
-           
-            const int responseCode = response.value(json::json_pointer("/params/responseStatusCode"), 200);
-            const std::string responseMessage = response.value(json::json_pointer("/params/responseStatusText"), std::string{"OK"});
-            nlohmann::json responseHeaders = response.value(json::json_pointer("/params/responseHeaders"), nlohmann::json::array());
-           
-            PostGlobalMessage({
-                { "id", 63453 },
-                { "method", "Fetch.fulfillRequest" },
-                { "params", {
-                    { "requestId", requestId },
-                    { "responseCode", responseCode },
-                    { "responseHeaders", responseHeaders },
-                    { "responsePhrase", responseMessage.empty() ? "OK" : responseMessage },
-                    { "body", Base64Encode(patchedContent) }
-                }}
-            });
-            return true;
+
+            HookMetrics::get().Record(HookMetrics::DOCUMENT, HookMetrics::BODY_WAIT, request.bodyRequestedAt);
+
+            bodyStream.injector = std::make_shared<HtmlHeadInjector>(*bodyStream.shimContent);
+            bodyStream.injector->Reserve(bodyStream.contentLength);
+
+            ReadBodyStream(std::move(request));
+            return;
         }
-        catch (const nlohmann::detail::exception& ex)
+
+        const json::json_pointer dataPointer("/result/data");
+
+        if (message.contains(dataPointer) && message.at(dataPointer).is_string())
         {
-            if (ShouldLogException()) LOG_ERROR("JSON error in HandleHooks -> {}", ex.what());        
-            return true; 
+            const std::string& chunk = message.at(dataPointer).get_ref<const std::string&>();
+
+            if (message.value(json::json_pointer("/result/base64Encoded"), false)) bodyStream.injector->WriteBase64(chunk);
+            else                                                                     bodyStream.injector->Write(chunk);
         }
-        catch (const std::exception& ex)
+
+        if (!message.value(json::json_pointer("/result/eof"), false))
         {
-            if (ShouldLogException()) LOG_ERROR("Error in HandleHooks -> {}", ex.what());
-            return true; 
+            ReadBodyStream(std::move(request));
+            return;
         }
-    });
+
+        PostGlobalMessage({
+            { "id", 0 },
+            { "method", "IO.close" },
+            { "params", { { "handle", bodyStream.handle } }}
+        });
+
+        BypassCSP();
+
+        nlohmann::json fulfillMessage = MakeFulfillMessage(request.requestId, request.message);
+        fulfillMessage["params"]["body"] = bodyStream.injector->Finish();
+
+        PostGlobalMessage(fulfillMessage);
+        m_requestsCompleted++;
+
+        HookMetrics::get().RecordDocument(request.message.value(json::json_pointer("/params/request/url"), std::string{}), request.pausedAt);
+    }
+    catch (const std::exception& ex)
+    {
+        if (ShouldLogException()) LOG_ERROR("Error in HandleBodyStream -> {}", ex.what());
+
+        /** Unless it was already parked for its next chunk, then it's left to expire. */
+        if (request.bodyStream) AbortRequest(request);
+    }
+}
+
+void HttpHookManager::HandleHooks(const nlohmann::basic_json<>& message)
+{
+    /** Only replies to our own Fetch.getResponseBody calls are of interest, they're sent with negative ids. */
+    const int64_t messageId = message.value(json::json_pointer("/id"), int64_t(0));
+
+    if (messageId >= 0) {
+        return;
+    }
+
+    std::optional<WebHookItem> request = TakeRequest(messageId);
+
+    if (!request.has_value()) {
+        return;
+    }
+
+    if (request->bodyStream) {
+        HandleBodyStream(message, std::move(request.value()));
+        return;
+    }
+
+    auto& [id, requestId, type, response, pausedAt, bodyRequestedAt, bodyStream] = request.value();
+
+    const bool isDocument = type == "Document";
+    const HookMetrics::ResourceType resourceType = HookMetrics::ResourceTypeFromString(type);
+
+    const auto bodyReceivedAt = HookMetrics::Clock::now();
+    HookMetrics::get().Record(resourceType, HookMetrics::BODY_WAIT, bodyRequestedAt, bodyReceivedAt);
+
+    try
+    {
+        static const std::string emptyBody;
+        const json::json_pointer bodyPointer("/result/body");
+
+        const std::string requestUrl = response.value(json::json_pointer("/params/request/url"), std::string{});
+        const std::string& responseBody = message.contains(bodyPointer) && message.at(bodyPointer).is_string() 
+            ? message.at(bodyPointer).get_ref<const std::string&>() : emptyBody;
+        const bool base64Encoded = message.value(json::json_pointer("/result/base64Encoded"), false);
+
+        if (message.contains("error") || requestUrl.empty() || responseBody.empty()) {
+            ContinueRequest(requestId);
+            return;
+        }
+
+        /** Shared with the document cache and response patcher, the body is only copied once, into the frame. */
+        std::shared_ptr<const std::string> patchedBody;
+
+        if (isDocument) 
+        {
+            const std::shared_ptr<const std::string> shimContent = this->BuildDocumentShim(requestUrl);
+
+            if (!shimContent) {
+                ContinueRequest(requestId);
+                return;
+            }
+
+            BypassCSP();
+
+            /** Reopened documents are usually byte for byte the same, they're only patched the first time. */
+            const std::string cacheKey = DocumentCache::MakeKey(requestUrl, responseBody, base64Encoded, *shimContent);
+            const unsigned long long hookGeneration = GetHookSnapshot()->generation;
+
+            patchedBody = DocumentCache::get().Get(cacheKey, hookGeneration, responseBody, *shimContent);
+
+            if (!patchedBody) 
+            {
+                patchedBody = std::make_shared<const std::string>(InjectDocumentShim(responseBody, base64Encoded, *shimContent));
+                DocumentCache::get().Insert(cacheKey, hookGeneration, responseBody, shimContent, patchedBody);
+            }
+        }
+        else 
+        {
+            patchedBody = ResponsePatcher::get().Apply(requestUrl, responseBody, base64Encoded);
+
+            /** None of the find strings occur in the response, it's passed through untouched. */
+            if (!patchedBody) {
+                ContinueRequest(requestId);
+                return;
+            }
+        }
+
+        const auto patchedAt = HookMetrics::Clock::now();
+        HookMetrics::get().Record(resourceType, HookMetrics::PATCH, bodyReceivedAt, patchedAt);
+
+        CdpSendQueue::get().Enqueue(SerializeFulfillMessage(MakeFulfillMessage(requestId, response), *patchedBody));
+        m_requestsCompleted++;
+
+        HookMetrics::get().Record(resourceType, HookMetrics::FULFILL, patchedAt);
+
+        if (isDocument) HookMetrics::get().RecordDocument(requestUrl, pausedAt);
+        else            HookMetrics::get().Record(resourceType, HookMetrics::TOTAL, pausedAt);
+    }
+    catch (const nlohmann::detail::exception& ex)
+    {
+        if (ShouldLogException()) LOG_ERROR("JSON error in HandleHooks -> {}", ex.what());
+        ContinueRequest(requestId);
+    }
+    catch (const std::exception& ex)
+    {
+        if (ShouldLogException()) LOG_ERROR("Error in HandleHooks -> {}", ex.what());
+        ContinueRequest(requestId);
+    }
 }
 
 void HttpHookManager::HandleIpcMessage(nlohmann::json message)
@@ -595,34 +1625,73 @@ void HttpHookManager::HandleIpcMessage(nlohmann::json message)
     this->PostGlobalMessage(responseJson);
 }
 
+/**
+ * Runs a request handler on the scheduler. Handlers report their errors the same way the dispatcher does.
+ */
+void HttpHookManager::ScheduleRequest(RequestScheduler::Priority priority, std::function<void()> handler)
+{
+    m_scheduler->Enqueue(priority, [this, handler = std::move(handler)]() 
+    {
+        try 
+        {
+            handler();
+        }
+        catch (const nlohmann::detail::exception& ex) 
+        {
+            if (ShouldLogException()) LOG_ERROR("error handling paused request -> {}", ex.what());
+        }
+        catch (const std::exception& ex) 
+        {
+            if (ShouldLogException()) LOG_ERROR("error handling paused request -> {}", ex.what());
+        }
+    });
+}
+
+nlohmann::json HttpHookManager::GetSchedulerMetrics() const
+{
+    return m_scheduler->GetMetrics();
+}
+
 void HttpHookManager::DispatchSocketMessage(nlohmann::basic_json<> message)
 {
     try 
     {
         if (message["method"] == "Fetch.requestPaused")
         {
+            const auto pausedAt = HookMetrics::Clock::now();
+            const std::string resourceType = message["params"].value("resourceType", std::string{});
+
             if (IsIpcCall(message)) 
             {
-                if (m_threadPool) {
-                    m_threadPool->enqueue([this, msg = std::move(message)]() {
-                        this->HandleIpcMessage(std::move(msg));
-                    });
-                }
-                else 
-                {
-                    LOG_ERROR("Thread pool is not initialized, cannot handle IPC message.");
-                }
-                return;
+                ScheduleRequest(RequestScheduler::IPC, [this, msg = std::move(message), pausedAt]() mutable {
+                    this->HandleIpcMessage(std::move(msg));
+                    HookMetrics::get().Record(HookMetrics::IPC, HookMetrics::TOTAL, pausedAt);
+                });
             }
+            else if (IsGetBodyCall(message))
+            {
+                ScheduleRequest(RequestScheduler::ASSET, [this, msg = std::move(message), pausedAt, resourceType]() {
+                    if (this->IsBundleCall(msg)) this->ServeBundle(msg);
+                    else                         this->RetrieveRequestFromDisk(msg);
 
-            switch ((int)this->IsGetBodyCall(message))
+                    HookMetrics::get().Record(HookMetrics::ResourceTypeFromString(resourceType), HookMetrics::TOTAL, pausedAt);
+                });
+            }
+            else
             {
-                case true:  { this->RetrieveRequestFromDisk(message); break; }
-                case false: { this->GetResponseBody(message);         break; }
+                /** Documents go first, scripts and stylesheets paused for a response patch are queued like assets. */
+                ScheduleRequest(resourceType == "Document" ? RequestScheduler::DOCUMENT : RequestScheduler::ASSET, [this, msg = std::move(message), pausedAt]() {
+                    this->GetResponseBody(msg, pausedAt);
+                });
             }
         }
-
-        this->HandleHooks(message);
+        /** Replies to our own calls carry negative ids, they're (streamed) bodies waiting to be patched. */
+        else if (message.value(json::json_pointer("/id"), int64_t(0)) < 0)
+        {
+            ScheduleRequest(RequestScheduler::DOCUMENT, [this, msg = std::move(message)]() {
+                this->HandleHooks(msg);
+            });
+        }
     }
     catch (const nlohmann::detail::exception& ex) 
     {
@@ -640,65 +1709,51 @@ void HttpHookManager::DispatchSocketMessage(nlohmann::basic_json<> message)
     }
 }
 
-HttpHookManager::ThreadPool::ThreadPool(size_t numThreads) 
-{
-    for (size_t i = 0; i < numThreads; ++i) 
-    {
-        workers.emplace_back([this] 
-        {
-            while (true) 
-            {
-                std::function<void()> task;
-                {
-                    std::unique_lock<std::mutex> lock(queueMutex);
-                    condition.wait(lock, [this] { return stop || !tasks.empty(); });
-                    
-                    if (stop && tasks.empty()) return;
-                    
-                    task = std::move(tasks.front());
-                    tasks.pop();
-                }
-                task();
-            }
-        });
-    }
-}
+HttpHookManager::HttpHookManager() : m_hookSnapshot(std::make_shared<const HookSnapshot>()), m_lastExceptionTime{}
+{ 
+    /** Compile the url policy up front so it's never built on the request path. */
+    UrlPolicy::get();
 
-HttpHookManager::ThreadPool::~ThreadPool() 
-{
-    shutdown();
-}
+    std::unique_ptr<SettingsStore> settingsStore = std::make_unique<SettingsStore>();
+    m_contentHashedUrls = settingsStore->GetSetting("content_hashed_urls", "true") == "true";
+    m_precompressedAssets = settingsStore->GetSetting("precompressed_assets", "false") == "true";
+    m_bundleWebkitModules = settingsStore->GetSetting("bundle_webkit_modules", "true") == "true";
+    m_assetPacks = settingsStore->GetSetting("asset_packs", "false") == "true";
+    m_prefetchAssets = settingsStore->GetSetting("prefetch_assets", "true") == "true";
 
-void HttpHookManager::ThreadPool::shutdown() 
-{
+    if (m_precompressedAssets)
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        stop = true;
+        Logger.Warn("precompressed_assets is enabled, gzip encoded bodies of Fetch.fulfillRequest haven't been verified to be decoded by Steam's CEF.");
     }
-    condition.notify_all();
-    
-    for (std::thread& worker : workers) 
-    {
-        if (worker.joinable()) 
+
+    const auto GetCountSetting = [&settingsStore](const char* key, size_t defaultValue) -> size_t {
+        try 
         {
-            worker.join();
+            return std::stoul(settingsStore->GetSetting(key, std::to_string(defaultValue)));
         }
-    }
-}
+        catch (const std::exception&) 
+        {
+            return defaultValue;
+        }
+    };
 
-template<typename F>
-void HttpHookManager::ThreadPool::enqueue(F&& f) 
-{
-    {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        if (stop) return; // Don't accept new tasks if shutting down
-        tasks.emplace(std::forward<F>(f));
-    }
-    condition.notify_one();
-}
+    /** IPC stays serialized by default, plugins may rely on their calls being handled in order. */
+    RequestScheduler::Options schedulerOptions;
+    schedulerOptions.workerCount = GetCountSetting("scheduler_workers", 4);
+    schedulerOptions.inFlightLimits[RequestScheduler::IPC]      = GetCountSetting("scheduler_ipc_limit", 1);
+    schedulerOptions.inFlightLimits[RequestScheduler::DOCUMENT] = GetCountSetting("scheduler_document_limit", 2);
+    schedulerOptions.inFlightLimits[RequestScheduler::ASSET]    = GetCountSetting("scheduler_asset_limit", 2);
+    schedulerOptions.inFlightLimits[RequestScheduler::PREFETCH] = GetCountSetting("scheduler_prefetch_limit", 1);
+
+    m_scheduler = std::make_unique<RequestScheduler>(schedulerOptions);
 
-HttpHookManager::HttpHookManager() : m_hookListPtr(std::make_shared<std::vector<HookType>>()), m_requestMap(std::make_shared<std::vector<WebHookItem>>()), m_lastExceptionTime{}, m_threadPool(std::make_unique<ThreadPool>(1))
-{ }
+    /** Only paused requests and the replies to our own (negative id) calls reach the dispatcher. */
+    CdpRouter::get().Subscribe("Fetch.requestPaused", [this](const nlohmann::json& message) { DispatchSocketMessage(message); });
+    CdpRouter::get().RouteReplies(std::numeric_limits<long long>::min(), -1, [this](const nlohmann::json& message) { DispatchSocketMessage(message); });
+}
 
 HttpHookManager::~HttpHookManager() 
-{ }
\ No newline at end of file
+{ 
+    /** Stopped first, the workers use the members declared after it. */
+    m_scheduler->Shutdown();
+}
\ No newline at end of file
@@ -39,6 +39,10 @@
 #include "ffi.h"
 #include "http.h"
 #include "http_hooks.h"
+#include "cdp_send_queue.h"
+#include "cdp_router.h"
+#include "reconnect_manager.h"
+#include "debugger_discovery.h"
 #include "internal_logger.h"
 #include "plugin_logger.h"
 #include <env.h>
@@ -73,17 +77,11 @@ MILLENNIUM bool Sockets::PostShared(nlohmann::json data)
  * @brief Post a message to the entire browser.
  * @param data The data to post.
  * 
- * @note ID's are managed by the caller.
+ * @note ID's are managed by the caller. Safe to call from any thread, the message is sent in order by CdpSendQueue.
  */
 MILLENNIUM bool Sockets::PostGlobal(nlohmann::json data) 
 {
-    if (browserClient == nullptr) 
-    {
-        return false;
-    }
-
-    browserClient->send(browserHandle, data.dump(), websocketpp::frame::opcode::text);
-    return true;
+    return CdpSendQueue::get().Enqueue(data.dump());
 }
 
 /**
@@ -94,6 +92,8 @@ MILLENNIUM void Sockets::Shutdown()
 {
     try
     {
+        CdpSendQueue::get().Detach();
+
         if (browserClient != nullptr) 
         {
             browserClient->close(browserHandle, websocketpp::close::status::normal, "Shutting down");
@@ -116,41 +116,22 @@ public:
 
     MILLENNIUM const void onMessage(websocketpp::client<websocketpp::config::asio_client>* c, websocketpp::connection_hdl hdl, websocketpp::config::asio_client::message_type::ptr msg)
     {
-        const auto json = nlohmann::json::parse(msg->get_payload());
-
-        if (json.contains("id") && json["id"] == 0 && json.contains("result") && json["result"].is_object() && json["result"].contains("targetInfos") && json["result"]["targetInfos"].is_array()) 
-        { 
-            const auto targets  = json["result"]["targetInfos"];
-            auto targetIterator = std::find_if(targets.begin(), targets.end(), [](const auto& target) { return target["title"] == "SharedJSContext"; });
-            
-            if (targetIterator != targets.end() && !m_sharedJsConnected) 
-            {
-                Sockets::PostGlobal({ { "id", 0 }, { "method", "Target.attachToTarget" }, { "params", { { "targetId", (*targetIterator)["targetId"] }, { "flatten", true } } } });
-                Sockets::PostGlobal({ { "id", 0 }, { "method", "Target.exposeDevToolsProtocol" }, { "params", { { "targetId", (*targetIterator)["targetId"] }, { "bindingName", "MILLENNIUM_CHROME_DEV_TOOLS_PROTOCOL_DO_NOT_USE_OR_OVERRIDE_ONMESSAGE" } } } });
-                m_sharedJsConnected = true;
-            }
-            else if (!m_sharedJsConnected)
-            {
-                this->SetupSharedJSContext();
-            }
-        }
+        CdpRouter::get().RouteFrame(msg->get_payload());
+    }
+
+    /**
+     * @brief Called after every attach to the SharedJSContext, the frontend shims are only injected once, 
+     * after a reconnect they're restored by ReconnectManager.
+     */
+    MILLENNIUM const void onSharedJsAttached(const std::string& sessionId)
+    {
+        sharedJsContextSessionId = sessionId;
 
-        if (json.value("method", std::string()) == "Target.attachedToTarget" && json["params"]["targetInfo"]["title"] == "SharedJSContext")
+        if (!m_sharedJsConnected)
         {
-            sharedJsContextSessionId = json["params"]["sessionId"];
-            Sockets::PostShared({ { "id", 9494 }, { "method", "Log.enable "}, { "sessionId", sharedJsContextSessionId } });
+            m_sharedJsConnected = true;
             this->onSharedJsConnect();
         }
-        else
-        {        
-            JavaScript::SharedJSMessageEmitter::InstanceRef().EmitMessage("msg", json);
-        }
-        webKitHandler.DispatchSocketMessage(json);
-    }
-
-    MILLENNIUM const void SetupSharedJSContext()
-    {
-        Sockets::PostGlobal({ { "id", 0 }, { "method", "Target.getTargets" } });
     }
 
     MILLENNIUM const void onSharedJsConnect()
@@ -166,14 +147,24 @@ public:
         m_startTime   = std::chrono::system_clock::now();
         browserClient = client; 
         browserHandle = handle;
+        CdpSendQueue::get().Attach(client, handle);
 
         Logger.Log("Connected to Steam @ {}", (void*)client);
+        DebuggerDiscovery::get().OnConnected();
 
-        this->SetupSharedJSContext();
         webKitHandler.SetupGlobalHooks();
+        webKitHandler.StartExpiryTimer(client);
+        ReconnectManager::get().OnConnected();
     }
 
-    MILLENNIUM CEFBrowser() : webKitHandler(HttpHookManager::get()) {}
+    MILLENNIUM CEFBrowser() : webKitHandler(HttpHookManager::get()) 
+    {
+        ReconnectManager::get().TrackTarget("SharedJSContext", {
+            "MILLENNIUM_CHROME_DEV_TOOLS_PROTOCOL_DO_NOT_USE_OR_OVERRIDE_ONMESSAGE",
+            std::bind(&CEFBrowser::onSharedJsAttached, this, _1)
+        });
+        ReconnectManager::get().SetSessionState("SharedJSContext", "Log.enable", { { "method", "Log.enable "} });
+    }
 };
 
 MILLENNIUM const void PluginLoader::Initialize()
@@ -192,12 +183,12 @@ MILLENNIUM PluginLoader::PluginLoader(std::chrono::system_clock::time_point star
     this->Initialize();
 }
 
-MILLENNIUM std::shared_ptr<std::thread> PluginLoader::ConnectCEFBrowser(void* cefBrowserHandler, SocketHelpers* socketHelpers)
+MILLENNIUM std::shared_ptr<std::thread> PluginLoader::ConnectCEFBrowser(void* cefBrowserHandler, SocketHelpers* socketHelpers, std::function<std::string()> fetchSocketUrl)
 {
     SocketHelpers::ConnectSocketProps browserProps;
 
     browserProps.commonName     = "CEFBrowser";
-    browserProps.fetchSocketUrl = std::bind(&SocketHelpers::GetSteamBrowserContext, socketHelpers);
+    browserProps.fetchSocketUrl = std::move(fetchSocketUrl);
     browserProps.onConnect      = std::bind(&CEFBrowser::onConnect, (CEFBrowser*)cefBrowserHandler, _1, _2);
     browserProps.onMessage      = std::bind(&CEFBrowser::onMessage, (CEFBrowser*)cefBrowserHandler, _1, _2, _3);
 
@@ -213,24 +204,14 @@ MILLENNIUM const void PluginLoader::InjectWebkitShims()
     Logger.Log("Injecting webkit shims...");
     
     this->Initialize();
-    static std::vector<int> hookIds;
+    static std::vector<unsigned long long> hookIds;
 
     /** Clear all previous hooks if there are any */
     if (!hookIds.empty())
     {
-        std::vector<HttpHookManager::HookType, std::allocator<HttpHookManager::HookType>> moduleList = HttpHookManager::get().GetHookListCopy();
-
-        for (auto it = moduleList.begin(); it != moduleList.end();)
-        {
-            if (std::find(hookIds.begin(), hookIds.end(), it->id) != hookIds.end())
-            {
-                Logger.Log("Removing hook for module id: {}", it->id);
-                it = moduleList.erase(it);
-            }
-            else ++it;
-        }
-
-        HttpHookManager::get().SetHookList(std::make_shared<std::vector<HttpHookManager::HookType>>(moduleList));
+        const size_t removedCount = HttpHookManager::get().RemoveHooks(hookIds);
+        Logger.Log("Removed {} webkit hook(s) from the previous injection", removedCount);
+        hookIds.clear();
     }
 
     const auto allPlugins = this->m_settingsStorePtr->ParseAllPlugins();
@@ -247,7 +228,7 @@ MILLENNIUM const void PluginLoader::InjectWebkitShims()
             hookIds.push_back(g_hookedModuleId);
 
             Logger.Log("Injecting hook for '{}' with id {}", plugin.pluginName, g_hookedModuleId.load());
-            HttpHookManager::get().AddHook({ absolutePath.generic_string(), std::regex(".*"), HttpHookManager::TagTypes::JAVASCRIPT, g_hookedModuleId });
+            HttpHookManager::get().AddHook({ absolutePath.generic_string(), std::regex(".*"), HttpHookManager::TagTypes::JAVASCRIPT, g_hookedModuleId, ".*" });
         }
     }
 }
@@ -259,30 +240,50 @@ MILLENNIUM const void PluginLoader::StartFrontEnds()
 
     this->InjectWebkitShims();
 
-    auto socketStart = std::chrono::high_resolution_clock::now();
-    Logger.Log("Starting frontend socket...");
-    std::shared_ptr<std::thread> browserSocketThread = this->ConnectCEFBrowser(&cefBrowserHandler, &socketHelpers);
+    /** The browser url only changes when Steam restarts its web helper, it's fetched again once connecting to it fails. */
+    std::string socketUrl;
+    const auto fetchSocketUrl = [&socketUrl, &socketHelpers]() 
+    {
+        if (socketUrl.empty()) socketUrl = socketHelpers.GetSteamBrowserContext();
+        return socketUrl;
+    };
 
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - this->m_startTime);
-    Logger.Log("Startup took {} ms", duration.count());
+    Logger.Log("Starting frontend socket...");
 
-    if (browserSocketThread->joinable())
+    while (true)
     {
-        Logger.Warn("Joining browser socket thread {}", (void*)browserSocketThread.get());
-        browserSocketThread->join();
-        Logger.Warn("Browser socket thread joined...");
-    }
+        std::shared_ptr<std::thread> browserSocketThread = this->ConnectCEFBrowser(&cefBrowserHandler, &socketHelpers, fetchSocketUrl);
 
-    if (g_threadTerminateFlag->flag.load())
-    {   
-        Logger.Log("Terminating frontend thread pool...");
-        return;
-    }
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - this->m_startTime);
+        Logger.Log("Startup took {} ms", duration.count());
 
-    Logger.Warn("Unexpectedly Disconnected from Steam, attempting to reconnect...");
-    
-    this->m_startTime = std::chrono::system_clock::now();
-    this->StartFrontEnds();
+        if (browserSocketThread->joinable())
+        {
+            Logger.Warn("Joining browser socket thread {}", (void*)browserSocketThread.get());
+            browserSocketThread->join();
+            Logger.Warn("Browser socket thread joined...");
+        }
+
+        CdpSendQueue::get().Detach();
+
+        if (g_threadTerminateFlag->flag.load())
+        {   
+            Logger.Log("Terminating frontend thread pool...");
+            return;
+        }
+
+        if (ReconnectManager::get().OnDisconnected())
+        {
+            Logger.Warn("Unexpectedly Disconnected from Steam, attempting to reconnect...");
+        }
+        else
+        {
+            socketUrl.clear();
+        }
+
+        std::this_thread::sleep_for(ReconnectManager::get().NextRetryDelay());
+        this->m_startTime = std::chrono::system_clock::now();
+    }
 }
 
 /* debug function, just for developers */
@@ -0,0 +1,265 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "module_bundler.h"
+#include <cctype>
+#include <nlohmann/json.hpp>
+#include "encoding.h"
+#include "hash.h"
+#include "internal_logger.h"
+
+/**
+ * Imports the modules one after another from blob urls, in the order the preloader would import them, 
+ * each behind its own error boundary.
+ */
+static constexpr const char* g_bundleLoader = R"(
+for (const [name, source] of modules) {
+    const url = URL.createObjectURL(new Blob([source], { type: "text/javascript" }));
+    try {
+        await import(url);
+    }
+    catch (error) {
+        console.error(`[Millennium] Failed to load webkit module ${name}`, error);
+    }
+    finally {
+        URL.revokeObjectURL(url);
+    }
+}
+)";
+
+ModuleBundler& ModuleBundler::get()
+{
+    static ModuleBundler instance;
+    return instance;
+}
+
+static bool IsIdentifierCharacter(char character)
+{
+    return std::isalnum(static_cast<unsigned char>(character)) || character == '_' || character == '$';
+}
+
+/**
+ * Finds the next occurrence of the keyword as a whole word, i.e. not as part of `reimported`.
+ */
+static size_t FindKeyword(const std::string& source, const std::string& keyword, size_t position = 0)
+{
+    for (position = source.find(keyword, position); position != std::string::npos; position = source.find(keyword, position + 1))
+    {
+        const size_t keywordEnd = position + keyword.size();
+
+        if ((position == 0 || !IsIdentifierCharacter(source[position - 1])) && (keywordEnd == source.size() || !IsIdentifierCharacter(source[keywordEnd])))
+        {
+            return position;
+        }
+    }
+    return std::string::npos;
+}
+
+/**
+ * A module is only bundled if it can't import anything: no `import` keyword at all (static and dynamic imports, 
+ * `import.meta`) and no `export ... from "..."` re-export. The check doesn't parse, so the keyword in a string or 
+ * a comment also keeps a module out of the bundle, it never lets one with an import in.
+ */
+bool ModuleBundler::IsBundleable(const std::string& source)
+{
+    if (FindKeyword(source, "import") != std::string::npos)
+    {
+        return false;
+    }
+
+    for (size_t position = FindKeyword(source, "from"); position != std::string::npos; position = FindKeyword(source, "from", position + 4))
+    {
+        size_t specifierStart = position + 4;
+        while (specifierStart < source.size() && std::isspace(static_cast<unsigned char>(source[specifierStart]))) specifierStart++;
+
+        if (specifierStart < source.size() && (source[specifierStart] == '"' || source[specifierStart] == '\''))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::string> ModuleBundler::FindStaticImports(const std::string& source)
+{
+    std::vector<std::string> specifiers;
+
+    for (size_t position = source.find("./"); position != std::string::npos; position = source.find("./", position + 2))
+    {
+        size_t quotePosition = position;
+        while (quotePosition > 0 && source[quotePosition - 1] == '.') quotePosition--;
+
+        if (quotePosition == 0) continue;
+
+        const char quote = source[quotePosition - 1];
+        if (quote != '"' && quote != '\'') continue;
+
+        /** Unlike IsPrecededByKeyword, an opening parenthesis means a dynamic import. */
+        size_t keywordEnd = quotePosition - 1;
+        while (keywordEnd > 0 && std::isspace(static_cast<unsigned char>(source[keywordEnd - 1]))) keywordEnd--;
+
+        const auto endsWith = [&](const char* keyword, size_t length) {
+            return keywordEnd >= length && source.compare(keywordEnd - length, length, keyword) == 0;
+        };
+
+        if (!endsWith("from", 4) && !endsWith("import", 6)) continue;
+
+        const size_t closingQuote = source.find(quote, position);
+        if (closingQuote == std::string::npos) break;
+
+        specifiers.push_back(source.substr(quotePosition, closingQuote - quotePosition));
+        position = closingQuote;
+    }
+    return specifiers;
+}
+
+ModuleBundler::BundlePlan ModuleBundler::Plan(const std::vector<std::string>& modulePaths, const AssetCache::AssetLoader& loader, unsigned long long generation, unsigned long long contentEpoch)
+{
+    BundlePlan bundlePlan;
+    std::vector<std::string> bundledPaths;
+    std::string keySource = fmt::format("{}:{}", generation, contentEpoch).append(1, '\0');
+
+    for (const auto& modulePath : modulePaths)
+    {
+        std::shared_ptr<const AssetCache::Asset> asset = AssetCache::get().Get(modulePath, loader);
+
+        if (!asset || !IsBundleable(Base64Decode(asset->body)))
+        {
+            bundlePlan.standalonePaths.push_back(modulePath);
+            continue;
+        }
+
+        bundledPaths.push_back(modulePath);
+        keySource.append(modulePath).append(1, '\0').append(asset->contentHash).append(1, '\0');
+    }
+
+    /** A single module gains nothing from being bundled. */
+    if (bundledPaths.size() < 2)
+    {
+        bundlePlan.standalonePaths = modulePaths;
+        return bundlePlan;
+    }
+
+    bundlePlan.bundleKey = ContentHash(keySource.data(), keySource.size());
+
+    std::lock_guard<std::mutex> lock(m_bundleMutex);
+    m_bundleModules[bundlePlan.bundleKey] = std::move(bundledPaths);
+    return bundlePlan;
+}
+
+void ModuleBundler::RetireBundles()
+{
+    std::lock_guard<std::mutex> lock(m_bundleMutex);
+    m_retiredBundleModules = std::move(m_bundleModules);
+    m_bundleModules.clear();
+}
+
+std::shared_ptr<const AssetCache::Asset> ModuleBundler::GetBundle(const std::string& bundleKey, const AssetCache::AssetLoader& loader)
+{
+    std::vector<std::string> modulePaths;
+    {
+        std::lock_guard<std::mutex> lock(m_bundleMutex);
+        auto bundleIterator = m_bundleModules.find(bundleKey);
+
+        if (bundleIterator == m_bundleModules.end())
+        {
+            bundleIterator = m_retiredBundleModules.find(bundleKey);
+
+            if (bundleIterator == m_retiredBundleModules.end())
+            {
+                return nullptr;
+            }
+        }
+        modulePaths = bundleIterator->second;
+    }
+
+    std::vector<std::shared_ptr<const AssetCache::Asset>> modules;
+    std::string contentKey;
+
+    for (const auto& modulePath : modulePaths)
+    {
+        std::shared_ptr<const AssetCache::Asset> asset = AssetCache::get().Get(modulePath, loader);
+
+        if (!asset)
+        {
+            LOG_ERROR("failed to read webkit module '{}' for bundle {}", modulePath, bundleKey);
+            return nullptr;
+        }
+
+        contentKey.append(modulePath).append(1, '\0').append(asset->contentHash).append(1, '\0');
+        modules.push_back(std::move(asset));
+    }
+
+    const std::string contentHash = ContentHash(contentKey.data(), contentKey.size());
+    {
+        std::lock_guard<std::mutex> lock(m_bundleMutex);
+        auto builtIterator = m_builtBundles.find(contentHash);
+
+        if (builtIterator != m_builtBundles.end())
+        {
+            return builtIterator->second;
+        }
+    }
+
+    std::string bundleSource = "/** Millennium webkit module bundle */\nconst modules = [\n";
+
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        /** sourceURL keeps the original file name in stack traces and the devtools source list. */
+        const std::string moduleSource = Base64Decode(modules[i]->body) + "\n//# sourceURL=" + modulePaths[i] + "\n";
+
+        bundleSource.append("    [")
+            .append(nlohmann::json(modulePaths[i]).dump(-1, ' ', false, nlohmann::json::error_handler_t::replace))
+            .append(", ")
+            .append(nlohmann::json(moduleSource).dump(-1, ' ', false, nlohmann::json::error_handler_t::replace))
+            .append("],\n");
+    }
+
+    bundleSource.append("];\n").append(g_bundleLoader);
+
+    auto bundle = std::make_shared<AssetCache::Asset>();
+    bundle->body        = Base64Encode(bundleSource);
+    bundle->contentHash = contentHash;
+    bundle->headers     = nlohmann::json::array
+    ({
+        { {"name", "Access-Control-Allow-Origin"}, {"value", "*"} },
+        { {"name", "Content-Type"}, {"value", "application/javascript"} }
+    });
+
+    std::lock_guard<std::mutex> lock(m_bundleMutex);
+
+    if (m_builtBundles.size() >= m_maxBuiltBundles)
+    {
+        m_builtBundles.clear();
+    }
+
+    m_builtBundles.emplace(contentHash, bundle);
+    return bundle;
+}
@@ -0,0 +1,383 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "reconnect_manager.h"
+#include <algorithm>
+#include "loader.h"
+#include "internal_logger.h"
+
+ReconnectManager& ReconnectManager::get()
+{
+    static ReconnectManager instance;
+    return instance;
+}
+
+void ReconnectManager::UpsertState(std::vector<StateCall>& state, StateCall stateCall)
+{
+    auto existing = std::find_if(state.begin(), state.end(), [&stateCall](const StateCall& other) { return other.key == stateCall.key; });
+
+    if (existing != state.end()) *existing = std::move(stateCall);
+    else                         state.push_back(std::move(stateCall));
+}
+
+/**
+ * Adds a declared call to the burst being built, calls that want their reply get an id of their own.
+ * @note The caller must hold m_stateMutex.
+ */
+void ReconnectManager::AddCallLocked(OutgoingCalls& outgoing, const StateCall& stateCall, const std::string& sessionId)
+{
+    nlohmann::json call = stateCall.call;
+    call["id"] = 0;
+
+    if (stateCall.onReply)
+    {
+        call["id"] = CdpRouter::get().NextCallId();
+        CdpRouter::get().ExpectReply(call["id"].get<long long>(), stateCall.onReply);
+    }
+
+    if (!sessionId.empty())
+    {
+        call["sessionId"] = sessionId;
+    }
+    outgoing.push_back(std::move(call));
+}
+
+/**
+ * Sends a burst of calls. Never called with m_stateMutex held, a full send queue would stall 
+ * the socket thread on it.
+ */
+void ReconnectManager::Send(const OutgoingCalls& outgoing)
+{
+    for (const auto& call : outgoing)
+    {
+        Sockets::PostGlobal(call);
+    }
+}
+
+void ReconnectManager::SetGlobalState(const std::string& key, nlohmann::json call, ReplyHandler onReply)
+{
+    OutgoingCalls outgoing;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        StateCall stateCall { key, std::move(call), std::move(onReply) };
+
+        if (m_isConnected)
+        {
+            AddCallLocked(outgoing, stateCall, {});
+        }
+        UpsertState(m_globalState, std::move(stateCall));
+    }
+    Send(outgoing);
+}
+
+void ReconnectManager::TrackTarget(const std::string& targetTitle, TrackedTarget target)
+{
+    OutgoingCalls outgoing;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_targets[targetTitle].tracked = std::move(target);
+
+        if (m_isConnected)
+        {
+            DiscoverTargetsLocked(outgoing);
+        }
+    }
+    Send(outgoing);
+}
+
+void ReconnectManager::SetSessionState(const std::string& targetTitle, const std::string& key, nlohmann::json call, ReplyHandler onReply)
+{
+    OutgoingCalls outgoing;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        Target& target = m_targets[targetTitle];
+        StateCall stateCall { key, std::move(call), std::move(onReply) };
+
+        if (m_isConnected && !target.sessionId.empty())
+        {
+            AddCallLocked(outgoing, stateCall, target.sessionId);
+        }
+        UpsertState(target.sessionState, std::move(stateCall));
+    }
+    Send(outgoing);
+}
+
+/**
+ * Lists the browser's targets to find the tracked ones that aren't attached yet.
+ * @note The caller must hold m_stateMutex.
+ */
+void ReconnectManager::DiscoverTargetsLocked(OutgoingCalls& outgoing)
+{
+    if (m_isDiscovering)
+    {
+        return;
+    }
+
+    m_isDiscovering = true;
+
+    const long long callId = CdpRouter::get().NextCallId();
+    const unsigned long long connectionId = m_connectionId;
+
+    CdpRouter::get().ExpectReply(callId, [this, connectionId](const nlohmann::json& reply) { OnTargetsListed(reply, connectionId); });
+    outgoing.push_back({ { "id", callId }, { "method", "Target.getTargets" } });
+}
+
+void ReconnectManager::OnTargetsListed(const nlohmann::json& reply, unsigned long long connectionId)
+{
+    OutgoingCalls outgoing;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+
+        if (connectionId != m_connectionId || !m_isConnected)
+        {
+            return;
+        }
+
+        m_isDiscovering = false;
+        bool isMissingTarget = false;
+
+        const auto result = reply.find("result");
+        const nlohmann::json targetInfos = result != reply.end() ? result->value("targetInfos", nlohmann::json::array()) : nlohmann::json::array();
+
+        for (auto& [targetTitle, target] : m_targets)
+        {
+            if (!target.sessionId.empty() || target.isAttaching) continue;
+
+            auto targetInfo = std::find_if(targetInfos.begin(), targetInfos.end(), [&targetTitle = targetTitle](const nlohmann::json& info) { 
+                return info.value("title", std::string()) == targetTitle; 
+            });
+
+            /** Steam creates its targets a while after the browser starts, they're listed again until they show up. */
+            if (targetInfo == targetInfos.end())
+            {
+                isMissingTarget = true;
+                continue;
+            }
+
+            const std::string targetId = targetInfo->value("targetId", std::string());
+            const long long callId = CdpRouter::get().NextCallId();
+
+            CdpRouter::get().ExpectReply(callId, [this, targetTitle = targetTitle, connectionId](const nlohmann::json& attachReply) { 
+                OnTargetAttached(targetTitle, attachReply, connectionId); 
+            });
+
+            target.isAttaching = true;
+            outgoing.push_back({ { "id", callId }, { "method", "Target.attachToTarget" }, { "params", { { "targetId", targetId }, { "flatten", true } } } });
+
+            if (!target.tracked.bindingName.empty())
+            {
+                outgoing.push_back({ { "id", 0 }, { "method", "Target.exposeDevToolsProtocol" }, { "params", { { "targetId", targetId }, { "bindingName", target.tracked.bindingName } } } });
+            }
+        }
+
+        if (isMissingTarget)
+        {
+            DiscoverTargetsLocked(outgoing);
+        }
+    }
+    Send(outgoing);
+}
+
+void ReconnectManager::OnTargetAttached(const std::string& targetTitle, const nlohmann::json& reply, unsigned long long connectionId)
+{
+    OutgoingCalls outgoing;
+    std::function<void(const std::string&)> onAttached;
+    std::string sessionId;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+
+        if (connectionId != m_connectionId || !m_isConnected)
+        {
+            return;
+        }
+
+        Target& target = m_targets[targetTitle];
+        target.isAttaching = false;
+
+        const auto result = reply.find("result");
+
+        /** The target went away between listing and attaching, look for it again. */
+        if (result == reply.end() || !result->contains("sessionId"))
+        {
+            DiscoverTargetsLocked(outgoing);
+        }
+        else
+        {
+            target.sessionId = (*result)["sessionId"].get<std::string>();
+            sessionId = target.sessionId;
+            onAttached = target.tracked.onAttached;
+
+            for (const StateCall& stateCall : target.sessionState)
+            {
+                AddCallLocked(outgoing, stateCall, sessionId);
+            }
+            RecordRecoveryLocked();
+        }
+    }
+    Send(outgoing);
+
+    if (onAttached)
+    {
+        onAttached(sessionId);
+    }
+}
+
+/**
+ * Records the recovery time once every tracked target is attached again after a reconnect.
+ * @note The caller must hold m_stateMutex.
+ */
+void ReconnectManager::RecordRecoveryLocked()
+{
+    if (!m_isRecovering)
+    {
+        return;
+    }
+
+    for (const auto& [targetTitle, target] : m_targets)
+    {
+        if (target.sessionId.empty()) return;
+    }
+
+    m_isRecovering = false;
+
+    const auto recoveryTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_disconnectedAt);
+    m_recoveryLatency.Record(recoveryTime);
+    Logger.Log("Restored browser state {} ms after the disconnect", recoveryTime.count() / 1000);
+}
+
+void ReconnectManager::OnConnected()
+{
+    OutgoingCalls outgoing;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+
+        m_isConnected = true;
+        m_isDiscovering = false;
+        m_connectionId++;
+
+        if (m_connectionId > 1)
+        {
+            const auto reconnectTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_disconnectedAt);
+            m_reconnectLatency.Record(reconnectTime);
+            m_reconnects++;
+            m_isRecovering = true;
+
+            Logger.Log("Reconnected to Steam {} ms after the disconnect ({} failed attempt(s)), replaying {} call(s)", 
+                reconnectTime.count() / 1000, m_failedAttempts, m_globalState.size());
+        }
+        m_failedAttempts = 0;
+
+        for (auto& [targetTitle, target] : m_targets)
+        {
+            target.sessionId.clear();
+            target.isAttaching = false;
+        }
+
+        for (const StateCall& stateCall : m_globalState)
+        {
+            AddCallLocked(outgoing, stateCall, {});
+        }
+
+        if (!m_targets.empty())
+        {
+            DiscoverTargetsLocked(outgoing);
+        }
+        else
+        {
+            m_isRecovering = false;
+        }
+    }
+    Send(outgoing);
+}
+
+bool ReconnectManager::OnDisconnected()
+{
+    bool wasConnected;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        wasConnected = m_isConnected;
+
+        if (wasConnected)
+        {
+            m_isConnected = false;
+            m_disconnectedAt = std::chrono::steady_clock::now();
+        }
+        else
+        {
+            m_failedAttempts++;
+        }
+
+        for (auto& [targetTitle, target] : m_targets)
+        {
+            target.sessionId.clear();
+            target.isAttaching = false;
+        }
+    }
+
+    /** 
+     * Replies to calls made on the old connection will never arrive, their callers are failed rather than left waiting. 
+     * Not done under m_stateMutex, the handlers of our own calls take it.
+     */
+    if (wasConnected)
+    {
+        const size_t droppedCalls = CdpRouter::get().ClearPendingReplies();
+        if (droppedCalls) Logger.Warn("Failed {} call(s) still waiting on a reply from the lost connection", droppedCalls);
+    }
+    return wasConnected;
+}
+
+std::chrono::milliseconds ReconnectManager::NextRetryDelay()
+{
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+
+    /** The first attempt after a drop is immediate, Steam usually just restarted its web helper. */
+    if (m_failedAttempts == 0)
+    {
+        return std::chrono::milliseconds(0);
+    }
+
+    const unsigned shift = std::min(m_failedAttempts - 1, 16u);
+    return std::min(m_initialRetryDelay * (1u << shift), m_maxRetryDelay);
+}
+
+nlohmann::json ReconnectManager::GetMetrics() const
+{
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+
+    return {
+        { "connected", m_isConnected },
+        { "reconnects", m_reconnects },
+        { "failedAttempts", m_failedAttempts },
+        { "globalState", m_globalState.size() },
+        { "trackedTargets", m_targets.size() },
+        { "reconnectLatency", m_reconnectLatency.ToJson() },
+        { "recoveryLatency", m_recoveryLatency.ToJson() }
+    };
+}
@@ -0,0 +1,198 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "request_scheduler.h"
+#include <algorithm>
+#include "internal_logger.h"
+
+static constexpr std::array<const char*, RequestScheduler::PRIORITY_COUNT> g_priorityNames = { "IPC", "Document", "Asset", "Prefetch" };
+
+RequestScheduler::RequestScheduler(Options options) : m_options(std::move(options))
+{
+    for (auto& limit : m_options.inFlightLimits)
+    {
+        limit = std::max<size_t>(limit, 1);
+    }
+
+    for (size_t i = 0; i < std::max<size_t>(m_options.workerCount, 1); i++)
+    {
+        m_workers.emplace_back(&RequestScheduler::WorkerThread, this);
+    }
+}
+
+RequestScheduler::~RequestScheduler()
+{
+    Shutdown();
+}
+
+void RequestScheduler::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+
+    for (std::thread& worker : m_workers)
+    {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void RequestScheduler::Enqueue(Priority priority, Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (m_stop) return;
+
+        TaskQueue& queue = m_queues[priority];
+        queue.tasks.push_back({ std::move(task), std::chrono::steady_clock::now() });
+
+        const size_t depth = queue.tasks.size();
+
+        /** Warn once per doubling, a queue that keeps growing means its handlers can't keep up. */
+        if (depth > queue.peakDepth)
+        {
+            if (depth >= m_depthWarningThreshold && (depth & (depth - 1)) == 0)
+            {
+                Logger.Warn("{} request queue reached {} waiting task(s), {} in flight", g_priorityNames[priority], depth, queue.inFlight);
+            }
+            queue.peakDepth = depth;
+        }
+    }
+    m_condition.notify_one();
+}
+
+/**
+ * Picks the task to run next, if any class is allowed to run another one.
+ * @note The caller must hold m_queueMutex.
+ */
+bool RequestScheduler::TakeNextLocked(Priority& priority, QueuedTask& queuedTask)
+{
+    const auto now = std::chrono::steady_clock::now();
+    int selected = -1;
+    bool isAged = false;
+
+    /** The longest waiting task past the aging threshold goes first. */
+    for (int i = 0; i < PREFETCH; i++)
+    {
+        const TaskQueue& queue = m_queues[i];
+
+        if (queue.tasks.empty() || queue.inFlight >= m_options.inFlightLimits[i]) continue;
+        if (now - queue.tasks.front().enqueuedAt < m_options.agingThreshold) continue;
+
+        if (selected == -1 || queue.tasks.front().enqueuedAt < m_queues[selected].tasks.front().enqueuedAt)
+        {
+            selected = i;
+        }
+    }
+
+    /** Only counted as aged if it actually jumped ahead of higher priority work. */
+    for (int i = 0; selected != -1 && i < selected; i++)
+    {
+        if (!m_queues[i].tasks.empty() && m_queues[i].inFlight < m_options.inFlightLimits[i]) isAged = true;
+    }
+
+    for (int i = 0; selected == -1 && i < PRIORITY_COUNT; i++)
+    {
+        if (!m_queues[i].tasks.empty() && m_queues[i].inFlight < m_options.inFlightLimits[i]) selected = i;
+    }
+
+    if (selected == -1)
+    {
+        return false;
+    }
+
+    TaskQueue& queue = m_queues[selected];
+    queuedTask = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    queue.inFlight++;
+    queue.waitTime.Record(std::chrono::duration_cast<std::chrono::microseconds>(now - queuedTask.enqueuedAt));
+
+    if (isAged) queue.aged++;
+
+    priority = static_cast<Priority>(selected);
+    return true;
+}
+
+void RequestScheduler::WorkerThread()
+{
+    while (true)
+    {
+        Priority priority;
+        QueuedTask queuedTask;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_condition.wait(lock, [&] { return m_stop || TakeNextLocked(priority, queuedTask); });
+
+            if (m_stop && !queuedTask.task) return;
+        }
+
+        try
+        {
+            queuedTask.task();
+        }
+        catch (const std::exception& ex)
+        {
+            LOG_ERROR("unhandled error in {} request task -> {}", g_priorityNames[priority], ex.what());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            m_queues[priority].inFlight--;
+            m_queues[priority].completed++;
+        }
+
+        /** A class that was at its limit may run again, and that may be all an idle worker waits for. */
+        m_condition.notify_all();
+    }
+}
+
+nlohmann::json RequestScheduler::GetMetrics() const
+{
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    nlohmann::json metrics = nlohmann::json::object();
+
+    for (size_t i = 0; i < PRIORITY_COUNT; i++)
+    {
+        const TaskQueue& queue = m_queues[i];
+
+        metrics[g_priorityNames[i]] = {
+            { "depth", queue.tasks.size() },
+            { "peakDepth", queue.peakDepth },
+            { "inFlight", queue.inFlight },
+            { "inFlightLimit", m_options.inFlightLimits[i] },
+            { "completed", queue.completed },
+            { "aged", queue.aged },
+            { "wait", queue.waitTime.ToJson() }
+        };
+    }
+    return metrics;
+}
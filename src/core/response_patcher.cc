@@ -0,0 +1,360 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "response_patcher.h"
+#include <queue>
+#include <regex>
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/core.h>
+#include "internal_logger.h"
+#include "encoding.h"
+#include "hash.h"
+
+void PatternAutomaton::Compile(const std::vector<std::string>& patterns)
+{
+    m_states.assign(1, State{});
+    m_rootTransitions.fill(0);
+    m_patternLengths.clear();
+
+    for (size_t patternIndex = 0; patternIndex < patterns.size(); patternIndex++)
+    {
+        std::int32_t state = 0;
+
+        for (const char character : patterns[patternIndex])
+        {
+            const unsigned char byte = static_cast<unsigned char>(character);
+            std::int32_t next = state == 0 ? m_rootTransitions[byte] : 0;
+
+            if (state != 0)
+            {
+                for (const auto& [transition, target] : m_states[state].transitions)
+                {
+                    if (transition == byte) { next = target; break; }
+                }
+            }
+
+            if (next == 0)
+            {
+                next = static_cast<std::int32_t>(m_states.size());
+                m_states.emplace_back();
+
+                if (state == 0) m_rootTransitions[byte] = next;
+                else            m_states[state].transitions.emplace_back(byte, next);
+            }
+            state = next;
+        }
+
+        if (m_states[state].patternIndex == -1)
+        {
+            m_states[state].patternIndex = static_cast<std::int32_t>(patternIndex);
+        }
+        m_patternLengths.push_back(patterns[patternIndex].size());
+    }
+
+    /** Failure links are resolved breadth first, a state's failure is always shallower than the state itself. */
+    std::queue<std::int32_t> pending;
+
+    for (const std::int32_t child : m_rootTransitions)
+    {
+        if (child != 0) pending.push(child);
+    }
+
+    while (!pending.empty())
+    {
+        const std::int32_t state = pending.front();
+        pending.pop();
+
+        for (const auto& [byte, child] : m_states[state].transitions)
+        {
+            const std::int32_t failure = Transition(m_states[state].failure, byte);
+            m_states[child].failure = failure;
+            m_states[child].outputLink = m_states[failure].patternIndex != -1 ? failure : m_states[failure].outputLink;
+            pending.push(child);
+        }
+    }
+}
+
+std::int32_t PatternAutomaton::Transition(std::int32_t state, unsigned char character) const
+{
+    while (state != 0)
+    {
+        for (const auto& [transition, target] : m_states[state].transitions)
+        {
+            if (transition == character) return target;
+        }
+        state = m_states[state].failure;
+    }
+    return m_rootTransitions[character];
+}
+
+std::vector<PatternAutomaton::Match> PatternAutomaton::FindAll(const std::string& haystack, const std::vector<bool>& enabledPatterns) const
+{
+    std::vector<Match> candidates;
+    std::int32_t state = 0;
+
+    for (size_t i = 0; i < haystack.size(); i++)
+    {
+        state = Transition(state, static_cast<unsigned char>(haystack[i]));
+
+        for (std::int32_t output = m_states[state].patternIndex != -1 ? state : m_states[state].outputLink; output != -1; output = m_states[output].outputLink)
+        {
+            const size_t patternIndex = static_cast<size_t>(m_states[output].patternIndex);
+
+            if (enabledPatterns[patternIndex])
+            {
+                candidates.push_back({ i + 1 - m_patternLengths[patternIndex], patternIndex });
+            }
+        }
+    }
+
+    /** Candidates are found in order of their end, overlaps are resolved by their start. */
+    std::stable_sort(candidates.begin(), candidates.end(), [this](const Match& a, const Match& b) {
+        return a.position != b.position ? a.position < b.position : m_patternLengths[a.patternIndex] > m_patternLengths[b.patternIndex];
+    });
+
+    std::vector<Match> matches;
+    size_t coveredUntil = 0;
+
+    for (const Match& candidate : candidates)
+    {
+        if (candidate.position >= coveredUntil)
+        {
+            matches.push_back(candidate);
+            coveredUntil = candidate.position + m_patternLengths[candidate.patternIndex];
+        }
+    }
+    return matches;
+}
+
+ResponsePatcher& ResponsePatcher::get()
+{
+    static ResponsePatcher instance;
+    return instance;
+}
+
+std::shared_ptr<const ResponsePatcher::PatchSet> ResponsePatcher::GetPatchSet() const
+{
+    return std::atomic_load(&m_patchSet);
+}
+
+unsigned long long ResponsePatcher::AddPatch(const std::string& urlPatternSource, const std::string& find, const std::string& replace)
+{
+    if (find.empty())
+    {
+        throw std::invalid_argument("a patch needs a non-empty string to find");
+    }
+
+    /** Validated upfront, the matcher would silently ignore the pattern. */
+    (void)std::regex(urlPatternSource);
+
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+
+    std::vector<Patch> patches = GetPatchSet()->patches;
+    patches.push_back({ ++m_nextPatchId, urlPatternSource, find, replace });
+
+    const unsigned long long patchId = m_nextPatchId;
+    PublishPatches(std::move(patches));
+    return patchId;
+}
+
+bool ResponsePatcher::RemovePatch(unsigned long long patchId)
+{
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+
+    std::vector<Patch> patches = GetPatchSet()->patches;
+    const auto removed = std::remove_if(patches.begin(), patches.end(), [patchId](const Patch& patch) { return patch.id == patchId; });
+
+    if (removed == patches.end())
+    {
+        return false;
+    }
+
+    patches.erase(removed, patches.end());
+    PublishPatches(std::move(patches));
+    return true;
+}
+
+/**
+ * @note The caller must hold m_writeMutex.
+ */
+void ResponsePatcher::PublishPatches(std::vector<Patch> patches)
+{
+    auto patchSet = std::make_shared<PatchSet>();
+    patchSet->patches = std::move(patches);
+    patchSet->generation = GetPatchSet()->generation + 1;
+
+    std::vector<std::string> urlPatternSources;
+    std::vector<std::string> findStrings;
+    std::unordered_map<std::string, size_t> findIndices;
+
+    for (size_t patchIndex = 0; patchIndex < patchSet->patches.size(); patchIndex++)
+    {
+        const Patch& patch = patchSet->patches[patchIndex];
+        urlPatternSources.push_back(patch.urlPatternSource);
+
+        const auto [findIndex, inserted] = findIndices.emplace(patch.find, findStrings.size());
+
+        if (inserted)
+        {
+            findStrings.push_back(patch.find);
+            patchSet->findPatches.emplace_back();
+        }
+        patchSet->findPatches[findIndex->second].push_back(patchIndex);
+    }
+
+    patchSet->urlMatcher.Compile(urlPatternSources);
+    patchSet->automaton.Compile(findStrings);
+
+    std::atomic_store(&m_patchSet, std::shared_ptr<const PatchSet>(std::move(patchSet)));
+}
+
+bool ResponsePatcher::HasPatchesFor(const std::string& url) const
+{
+    return !GetPatchSet()->urlMatcher.Match(url).empty();
+}
+
+std::vector<std::string> ResponsePatcher::GetUrlPatternSources() const
+{
+    std::vector<std::string> urlPatternSources;
+
+    for (const auto& patch : GetPatchSet()->patches)
+    {
+        urlPatternSources.push_back(patch.urlPatternSource);
+    }
+    return urlPatternSources;
+}
+
+std::string ResponsePatcher::ReplaceMatches(const PatchSet& patchSet, const std::vector<size_t>& matchedPatches, const std::string& body, size_t& replacements)
+{
+    std::vector<bool> isPatchMatched(patchSet.patches.size(), false);
+    std::vector<bool> enabledFinds(patchSet.findPatches.size(), false);
+
+    for (const size_t patchIndex : matchedPatches)
+    {
+        isPatchMatched[patchIndex] = true;
+    }
+
+    for (size_t findIndex = 0; findIndex < patchSet.findPatches.size(); findIndex++)
+    {
+        for (const size_t patchIndex : patchSet.findPatches[findIndex])
+        {
+            if (isPatchMatched[patchIndex]) enabledFinds[findIndex] = true;
+        }
+    }
+
+    const std::vector<PatternAutomaton::Match> matches = patchSet.automaton.FindAll(body, enabledFinds);
+    replacements = matches.size();
+
+    if (matches.empty())
+    {
+        return {};
+    }
+
+    std::string patchedBody;
+    patchedBody.reserve(body.size());
+    size_t copiedUntil = 0;
+
+    for (const auto& match : matches)
+    {
+        /** When several matched patches share a find string, the first one registered wins. */
+        const auto& candidates = patchSet.findPatches[match.patternIndex];
+        const size_t patchIndex = *std::find_if(candidates.begin(), candidates.end(), [&](size_t index) { return isPatchMatched[index]; });
+
+        patchedBody.append(body, copiedUntil, match.position - copiedUntil);
+        patchedBody.append(patchSet.patches[patchIndex].replace);
+        copiedUntil = match.position + patchSet.automaton.PatternLength(match.patternIndex);
+    }
+
+    patchedBody.append(body, copiedUntil, std::string::npos);
+    return patchedBody;
+}
+
+std::shared_ptr<const std::string> ResponsePatcher::Apply(const std::string& url, const std::string& responseBody, bool base64Encoded)
+{
+    const std::shared_ptr<const PatchSet> patchSet = GetPatchSet();
+    const std::vector<size_t> matchedPatches = patchSet->urlMatcher.Match(url);
+
+    if (matchedPatches.empty())
+    {
+        return nullptr;
+    }
+
+    /** The url isn't part of the key, the same chunk served from another url is patched the same way. */
+    std::string cacheKey = fmt::format("{:016x}:{}", Fnv1a64(responseBody.data(), responseBody.size()), base64Encoded ? "b64" : "raw");
+    for (const size_t patchIndex : matchedPatches)
+    {
+        cacheKey.append(":").append(std::to_string(patchIndex));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+        if (m_cacheGeneration != patchSet->generation)
+        {
+            m_cache.clear();
+            m_cacheBytes = 0;
+            m_cacheGeneration = patchSet->generation;
+        }
+
+        if (auto cached = m_cache.find(cacheKey); cached != m_cache.end())
+        {
+            return cached->second;
+        }
+    }
+
+    size_t replacements = 0;
+    const std::string patchedBody = ReplaceMatches(*patchSet, matchedPatches, base64Encoded ? Base64Decode(responseBody) : responseBody, replacements);
+
+    std::shared_ptr<const std::string> result = replacements != 0 ? std::make_shared<const std::string>(Base64Encode(patchedBody)) : nullptr;
+
+    if (replacements != 0)
+    {
+        Logger.Log("Patched '{}' ({} replacement(s))", url, replacements);
+    }
+
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+    /** A newer patch set may have been published in the meantime, its results must not be mixed in. */
+    if (m_cacheGeneration == patchSet->generation)
+    {
+        const size_t entryBytes = cacheKey.size() + (result ? result->size() : 0);
+
+        if (m_cacheBytes + entryBytes > m_maxCacheBytes)
+        {
+            m_cache.clear();
+            m_cacheBytes = 0;
+        }
+
+        m_cacheBytes += entryBytes;
+        m_cache.emplace(std::move(cacheKey), result);
+    }
+    return result;
+}
@@ -0,0 +1,184 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "url_policy.h"
+#include <algorithm>
+#include <cctype>
+#include "locals.h"
+#include "internal_logger.h"
+#include "env.h"
+
+/**
+ * Millennium will not load JavaScript into the following hosts (or their subdomains) to favor user safety.
+ * These are pages that may have sensitive information or are not safe to load JavaScript into.
+ */
+static const std::vector<std::string> g_denyJavaScriptHosts = {
+    "checkout.steampowered.com"
+};
+
+/**
+ * Millennium will not hook the following hosts (or their subdomains) to favor user safety. 
+ * Neither JavaScript nor CSS will be injected into these pages.
+ */
+static const std::vector<std::string> g_denyAllHosts = {
+    "paypal.com",
+    "paypalobjects.com",
+    "recaptcha.net"
+};
+
+UrlPolicy& UrlPolicy::get()
+{
+    static UrlPolicy instance;
+    return instance;
+}
+
+UrlPolicy::UrlPolicy()
+{
+    for (const auto& host : g_denyJavaScriptHosts) AddHostRule(host, DENY_JAVASCRIPT);
+    for (const auto& host : g_denyAllHosts)        AddHostRule(host, DENY_ALL);
+
+    LoadPolicyFile(std::filesystem::path(GetEnv("MILLENNIUM__CONFIG_PATH")) / "url_policy.json");
+    Logger.Log("Compiled url policy with {} host rules and {} pattern rules", m_hostRules.size(), m_patternRules.size());
+}
+
+void UrlPolicy::AddHostRule(std::string host, Verdict verdict)
+{
+    std::transform(host.begin(), host.end(), host.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    auto& existingVerdict = m_hostRules[host];
+    existingVerdict = std::max(existingVerdict, verdict);
+}
+
+void UrlPolicy::AddPatternRule(const std::string& pattern, Verdict verdict)
+{
+    try
+    {
+        m_patternRules.push_back({ std::regex(pattern, std::regex::optimize), verdict });
+    }
+    catch (const std::regex_error& error)
+    {
+        LOG_ERROR("Ignoring invalid url policy pattern '{}': {}", pattern, error.what());
+    }
+}
+
+/**
+ * Loads additional rules from the user policy file. The file is optional and has the following shape:
+ * 
+ * {
+ *     "deny_all":        { "hosts": ["example.com"], "patterns": ["https://example\\.org/login.*"] },
+ *     "deny_javascript": { "hosts": [], "patterns": [] }
+ * }
+ */
+void UrlPolicy::LoadPolicyFile(const std::filesystem::path& policyPath)
+{
+    if (!std::filesystem::exists(policyPath))
+    {
+        return;
+    }
+
+    bool success = false;
+    const nlohmann::json policy = SystemIO::ReadJsonSync(policyPath.string(), &success);
+
+    if (!success || !policy.is_object())
+    {
+        LOG_ERROR("Failed to parse url policy file '{}', only the built-in policy will be used.", policyPath.string());
+        return;
+    }
+
+    const std::vector<std::pair<const char*, Verdict>> sections = {
+        { "deny_javascript", DENY_JAVASCRIPT },
+        { "deny_all",        DENY_ALL        }
+    };
+
+    for (const auto& [sectionName, verdict] : sections)
+    {
+        const nlohmann::json section = policy.value(sectionName, nlohmann::json::object());
+
+        for (const auto& host : section.value("hosts", nlohmann::json::array()))
+        {
+            if (host.is_string()) AddHostRule(host.get<std::string>(), verdict);
+        }
+
+        for (const auto& pattern : section.value("patterns", nlohmann::json::array()))
+        {
+            if (pattern.is_string()) AddPatternRule(pattern.get<std::string>(), verdict);
+        }
+    }
+}
+
+UrlPolicy::Verdict UrlPolicy::Evaluate(const std::string& url) const
+{
+    Verdict verdict = ALLOW;
+
+    /** Extract the lower-cased host of the url, without the user info or port. */
+    const size_t schemeEnd = url.find("://");
+    const size_t hostStart = schemeEnd == std::string::npos ? 0 : schemeEnd + 3;
+    size_t hostEnd = url.find_first_of("/?#", hostStart);
+    hostEnd = hostEnd == std::string::npos ? url.size() : hostEnd;
+
+    std::string host = url.substr(hostStart, hostEnd - hostStart);
+
+    const size_t userInfoEnd = host.rfind('@');
+    if (userInfoEnd != std::string::npos) host.erase(0, userInfoEnd + 1);
+
+    const size_t portStart = host.find(':');
+    if (portStart != std::string::npos) host.erase(portStart);
+
+    std::transform(host.begin(), host.end(), host.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    /** Check the host and every parent domain against the host rules, i.e a.b.paypal.com -> b.paypal.com -> paypal.com -> com */
+    for (size_t offset = 0; offset != std::string::npos && !host.empty(); )
+    {
+        auto ruleIterator = m_hostRules.find(host.substr(offset));
+
+        if (ruleIterator != m_hostRules.end())
+        {
+            verdict = std::max(verdict, ruleIterator->second);
+        }
+
+        offset = host.find('.', offset);
+        offset = offset == std::string::npos ? offset : offset + 1;
+    }
+
+    for (const auto& rule : m_patternRules)
+    {
+        if (verdict == DENY_ALL)
+        {
+            break;
+        }
+
+        if (rule.verdict > verdict && std::regex_match(url, rule.pattern))
+        {
+            verdict = rule.verdict;
+        }
+    }
+
+    return verdict;
+}
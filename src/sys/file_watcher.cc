@@ -0,0 +1,305 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "file_watcher.h"
+#include "internal_logger.h"
+#include "fvisible.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <climits>
+#include <cerrno>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#ifdef _WIN32
+struct FileWatcher::PendingRead
+{
+    HANDLE directoryHandle = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped {};
+    /** FILE_NOTIFY_INFORMATION records are DWORD aligned. */
+    alignas(DWORD) char changeBuffer[16 * 1024];
+};
+#else
+struct FileWatcher::PendingRead { };
+#endif
+
+MILLENNIUM FileWatcher& FileWatcher::get()
+{
+    static FileWatcher instance;
+    return instance;
+}
+
+MILLENNIUM FileWatcher::FileWatcher()
+{
+    #ifdef __linux__
+    {
+        m_notifyHandle = inotify_init1(IN_CLOEXEC);
+
+        if (m_notifyHandle == -1)
+        {
+            LOG_ERROR("Failed to initialize inotify, file changes will be detected by polling file metadata.");
+            return;
+        }
+
+        m_watcherThread = std::thread(&FileWatcher::WatcherThread, this);
+        m_watcherThread.detach();
+    }
+    #elif defined(_WIN32)
+    {
+        m_completionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+
+        if (m_completionPort == NULL)
+        {
+            LOG_ERROR("Failed to create a completion port, file changes will be detected by polling file metadata.");
+            return;
+        }
+
+        m_watcherThread = std::thread(&FileWatcher::WatcherThread, this);
+        m_watcherThread.detach();
+    }
+    #endif
+}
+
+/**
+ * Starts the next read of a watched directory's changes, completed on the watcher's completion port.
+ */
+MILLENNIUM bool FileWatcher::BeginRead(PendingRead& pendingRead)
+{
+    #ifdef _WIN32
+    {
+        const DWORD notifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_ATTRIBUTES 
+            | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_CREATION;
+
+        pendingRead.overlapped = {};
+        return ReadDirectoryChangesW(pendingRead.directoryHandle, pendingRead.changeBuffer, sizeof(pendingRead.changeBuffer), 
+            FALSE, notifyFilter, NULL, &pendingRead.overlapped, NULL);
+    }
+    #else
+    {
+        return false;
+    }
+    #endif
+}
+
+MILLENNIUM FileWatcher::~FileWatcher()
+{ }
+
+MILLENNIUM bool FileWatcher::WatchDirectory(const std::filesystem::path& directory, ChangeCallback callback)
+{
+    #ifdef __linux__
+    {
+        if (m_notifyHandle == -1)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_watchMutex);
+
+        const uint32_t eventMask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_DELETE_SELF;
+        const int watchHandle = inotify_add_watch(m_notifyHandle, directory.string().c_str(), eventMask);
+
+        if (watchHandle == -1)
+        {
+            return false;
+        }
+
+        /** inotify returns the same handle for a directory that is already watched. */
+        auto& watchedDirectory = m_watches[watchHandle];
+        watchedDirectory.directory = directory;
+        watchedDirectory.callbacks.push_back(std::move(callback));
+        return true;
+    }
+    #elif defined(_WIN32)
+    {
+        if (m_completionPort == nullptr)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_watchMutex);
+
+        for (auto& [watchId, watchedDirectory] : m_watches)
+        {
+            if (watchedDirectory.directory == directory)
+            {
+                watchedDirectory.callbacks.push_back(std::move(callback));
+                return true;
+            }
+        }
+
+        const HANDLE directoryHandle = CreateFileW(directory.wstring().c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 
+            NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+
+        if (directoryHandle == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        const int watchId = ++m_nextWatchId;
+        auto pendingRead = std::make_shared<PendingRead>();
+        pendingRead->directoryHandle = directoryHandle;
+
+        if (CreateIoCompletionPort(directoryHandle, m_completionPort, static_cast<ULONG_PTR>(watchId), 0) == NULL || !BeginRead(*pendingRead))
+        {
+            CloseHandle(directoryHandle);
+            return false;
+        }
+
+        auto& watchedDirectory = m_watches[watchId];
+        watchedDirectory.directory = directory;
+        watchedDirectory.callbacks.push_back(std::move(callback));
+        watchedDirectory.pendingRead = std::move(pendingRead);
+        return true;
+    }
+    #else
+    {
+        return false;
+    }
+    #endif
+}
+
+MILLENNIUM void FileWatcher::WatcherThread()
+{
+    #ifdef __linux__
+    {
+        alignas(struct inotify_event) char eventBuffer[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+
+        while (true)
+        {
+            const ssize_t bytesRead = read(m_notifyHandle, eventBuffer, sizeof(eventBuffer));
+
+            if (bytesRead <= 0)
+            {
+                if (errno == EINTR) continue;
+
+                LOG_ERROR("inotify read failed, no longer watching for file changes.");
+                return;
+            }
+
+            for (char* eventPtr = eventBuffer; eventPtr < eventBuffer + bytesRead; )
+            {
+                const auto* event = reinterpret_cast<const struct inotify_event*>(eventPtr);
+                eventPtr += sizeof(struct inotify_event) + event->len;
+
+                std::vector<ChangeCallback> callbacks;
+                std::filesystem::path changedPath;
+                {
+                    std::lock_guard<std::mutex> lock(m_watchMutex);
+                    auto watchIterator = m_watches.find(event->wd);
+
+                    if (watchIterator == m_watches.end()) 
+                        continue;
+
+                    /** Only the removal of the watched directory itself is reported, not its metadata changes. */
+                    if (event->len == 0 && !(event->mask & (IN_DELETE_SELF | IN_IGNORED)))
+                        continue;
+
+                    changedPath = event->len > 0 ? watchIterator->second.directory / event->name : watchIterator->second.directory;
+                    callbacks   = watchIterator->second.callbacks;
+
+                    if (event->mask & (IN_DELETE_SELF | IN_IGNORED))
+                    {
+                        m_watches.erase(watchIterator);
+                    }
+                }
+
+                for (const auto& callback : callbacks)
+                {
+                    callback(changedPath);
+                }
+            }
+        }
+    }
+    #elif defined(_WIN32)
+    {
+        while (true)
+        {
+            DWORD bytesRead = 0;
+            ULONG_PTR watchId = 0;
+            LPOVERLAPPED overlapped = nullptr;
+
+            const BOOL isCompleted = GetQueuedCompletionStatus(m_completionPort, &bytesRead, &watchId, &overlapped, INFINITE);
+
+            if (overlapped == nullptr)
+            {
+                LOG_ERROR("Waiting on directory changes failed, no longer watching for file changes.");
+                return;
+            }
+
+            std::vector<ChangeCallback> callbacks;
+            std::vector<std::filesystem::path> changedPaths;
+            {
+                std::lock_guard<std::mutex> lock(m_watchMutex);
+                auto watchIterator = m_watches.find(static_cast<int>(watchId));
+
+                if (watchIterator == m_watches.end()) 
+                    continue;
+
+                WatchedDirectory& watchedDirectory = watchIterator->second;
+                PendingRead& pendingRead = *watchedDirectory.pendingRead;
+                callbacks = watchedDirectory.callbacks;
+
+                /** Zero bytes means more changed than the buffer could hold, the names are lost. */
+                bool isWatching = isCompleted && bytesRead > 0;
+
+                for (DWORD offset = 0; isWatching; )
+                {
+                    const auto* changeInfo = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(pendingRead.changeBuffer + offset);
+                    changedPaths.push_back(watchedDirectory.directory / std::wstring(changeInfo->FileName, changeInfo->FileNameLength / sizeof(WCHAR)));
+
+                    if (changeInfo->NextEntryOffset == 0) break;
+                    offset += changeInfo->NextEntryOffset;
+                }
+
+                isWatching = isWatching && BeginRead(pendingRead);
+
+                /** The directory was removed or changes were lost, the whole directory is reported. No read is outstanding anymore, so the handle can be closed. */
+                if (!isWatching)
+                {
+                    changedPaths = { watchedDirectory.directory };
+                    CloseHandle(pendingRead.directoryHandle);
+                    m_watches.erase(watchIterator);
+                }
+            }
+
+            for (const auto& changedPath : changedPaths)
+            {
+                for (const auto& callback : callbacks)
+                {
+                    callback(changedPath);
+                }
+            }
+        }
+    }
+    #endif
+}
@@ -149,6 +149,28 @@ namespace SystemIO {
         return buffer;
     }
 
+    /**
+     * Reads `length` bytes starting at `offset`, without reading the rest of the file.
+     */
+    MILLENNIUM std::vector<char> ReadFileRangeSync(const std::string& filePath, std::uintmax_t offset, size_t length) 
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file) 
+        {
+            throw std::runtime_error("Failed to open file: " + filePath);
+        }
+
+        std::vector<char> buffer(length);
+        file.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+
+        if (!file.read(buffer.data(), static_cast<std::streamsize>(length))) 
+        {
+            throw std::runtime_error("Failed to read range of file: " + filePath);
+        }
+
+        return buffer;
+    }
+
     MILLENNIUM void WriteFileSync(const std::filesystem::path& filePath, std::string content)
     {
         std::ofstream outFile(filePath);
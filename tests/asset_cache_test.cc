@@ -0,0 +1,173 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "asset_cache.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <filesystem>
+
+namespace
+{
+    /** A directory of its own per test, the cache is a process wide singleton. */
+    std::filesystem::path MakeTestDirectory(const std::string& name)
+    {
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / ("millennium_asset_cache_test_" + name);
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        return directory;
+    }
+
+    void WriteFile(const std::filesystem::path& filePath, const std::string& contents)
+    {
+        std::ofstream(filePath, std::ios::binary | std::ios::trunc) << contents;
+    }
+
+    /** Loads every file as a body of the given size, regardless of its contents. */
+    AssetCache::AssetLoader MakeLoader(std::atomic<int>& loads, size_t bodySize)
+    {
+        return [&loads, bodySize](const std::filesystem::path&) {
+            loads++;
+            auto asset = std::make_shared<AssetCache::Asset>();
+            asset->body.assign(bodySize, 'a');
+            asset->contentHash = "hash";
+            return asset;
+        };
+    }
+}
+
+TEST(AssetCache, LoadsEachFileOnce)
+{
+    const std::filesystem::path directory = MakeTestDirectory("once");
+    WriteFile(directory / "a.js", "a");
+
+    std::atomic<int> loads { 0 };
+    const auto loader = MakeLoader(loads, 16);
+
+    const auto first = AssetCache::get().Get(directory / "a.js", loader);
+    const auto second = AssetCache::get().Get(directory / "a.js", loader);
+
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(loads, 1);
+}
+
+TEST(AssetCache, DoesNotCacheFilesAboveTheEntryCap)
+{
+    const std::filesystem::path directory = MakeTestDirectory("entry_cap");
+    WriteFile(directory / "large.bin", "a");
+
+    std::atomic<int> loads { 0 };
+    const auto loader = MakeLoader(loads, 16 * 1024 * 1024 + 1);
+
+    EXPECT_NE(AssetCache::get().Get(directory / "large.bin", loader), nullptr);
+    EXPECT_NE(AssetCache::get().Get(directory / "large.bin", loader), nullptr);
+    EXPECT_EQ(loads, 2);
+}
+
+TEST(AssetCache, EvictsTheLeastRecentlyUsedAboveTheByteCap)
+{
+    const std::filesystem::path directory = MakeTestDirectory("byte_cap");
+    constexpr size_t assetSize = 8 * 1024 * 1024;
+    constexpr int assetCount = 9;
+
+    std::atomic<int> loads { 0 };
+    const auto loader = MakeLoader(loads, assetSize);
+
+    for (int i = 0; i < assetCount; i++)
+    {
+        WriteFile(directory / (std::to_string(i) + ".bin"), "a");
+        ASSERT_NE(AssetCache::get().Get(directory / (std::to_string(i) + ".bin"), loader), nullptr);
+
+        /** Keeps the first asset the most recently used. */
+        AssetCache::get().Get(directory / "0.bin", loader);
+    }
+
+    const AssetCache::Stats stats = AssetCache::get().GetStats();
+    EXPECT_LE(stats.bytes, 64u * 1024 * 1024);
+    EXPECT_GE(stats.evictions, 1u);
+    EXPECT_EQ(loads, assetCount);
+
+    /** The first asset survived, the second was the least recently used one and is loaded again. */
+    AssetCache::get().Get(directory / "0.bin", loader);
+    EXPECT_EQ(loads, assetCount);
+
+    AssetCache::get().Get(directory / "1.bin", loader);
+    EXPECT_EQ(loads, assetCount + 1);
+}
+
+TEST(AssetCache, ReloadsChangedFiles)
+{
+    const std::filesystem::path directory = MakeTestDirectory("changed");
+    const std::filesystem::path filePath = directory / "a.js";
+    WriteFile(filePath, "a");
+
+    std::atomic<int> loads { 0 };
+    const auto loader = MakeLoader(loads, 16);
+
+    AssetCache::get().Get(filePath, loader);
+    const unsigned long long invalidationEpoch = AssetCache::get().GetInvalidationEpoch();
+
+    WriteFile(filePath, "changed");
+    std::filesystem::last_write_time(filePath, std::filesystem::last_write_time(filePath) + std::chrono::seconds(1));
+
+    /** Noticed by the watcher where there is one, by the size and write time otherwise. */
+    for (int attempt = 0; attempt < 100 && loads == 1; attempt++)
+    {
+        AssetCache::get().Get(filePath, loader);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    EXPECT_EQ(loads, 2);
+    EXPECT_GT(AssetCache::get().GetInvalidationEpoch(), invalidationEpoch);
+}
+
+TEST(AssetCache, ExcludedDirectoriesDontBumpTheInvalidationEpoch)
+{
+    const std::filesystem::path directory = MakeTestDirectory("excluded");
+    const std::filesystem::path filePath = directory / "a.js.gz";
+    WriteFile(filePath, "a");
+
+    AssetCache::get().ExcludeDirectory(directory);
+
+    std::atomic<int> loads { 0 };
+    const auto loader = MakeLoader(loads, 16);
+
+    AssetCache::get().Get(filePath, loader);
+    const unsigned long long invalidationEpoch = AssetCache::get().GetInvalidationEpoch();
+
+    WriteFile(filePath, "changed");
+    AssetCache::get().Get(filePath, loader);
+
+    EXPECT_EQ(loads, 2);
+    EXPECT_EQ(AssetCache::get().GetInvalidationEpoch(), invalidationEpoch);
+}
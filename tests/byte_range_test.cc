@@ -0,0 +1,119 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "byte_range.h"
+
+namespace
+{
+    struct ParsedRange {
+        bool isParsed;
+        std::uintmax_t firstByte, lastByte;
+        bool isSatisfiable;
+    };
+
+    ParsedRange Parse(const std::string& rangeHeader, std::uintmax_t fileSize)
+    {
+        ParsedRange range { false, 0, 0, false };
+        range.isParsed = ParseByteRange(rangeHeader, fileSize, range.firstByte, range.lastByte, range.isSatisfiable);
+        return range;
+    }
+}
+
+TEST(ParseByteRange, ParsesClosedAndOpenRanges)
+{
+    const ParsedRange closedRange = Parse("bytes=0-99", 1000);
+    ASSERT_TRUE(closedRange.isParsed);
+    EXPECT_TRUE(closedRange.isSatisfiable);
+    EXPECT_EQ(closedRange.firstByte, 0u);
+    EXPECT_EQ(closedRange.lastByte, 99u);
+
+    const ParsedRange openRange = Parse("bytes=900-", 1000);
+    ASSERT_TRUE(openRange.isParsed);
+    EXPECT_TRUE(openRange.isSatisfiable);
+    EXPECT_EQ(openRange.firstByte, 900u);
+    EXPECT_EQ(openRange.lastByte, 999u);
+}
+
+TEST(ParseByteRange, ClampsTheLastByteToTheFile)
+{
+    const ParsedRange range = Parse("bytes=10-5000", 1000);
+    ASSERT_TRUE(range.isParsed);
+    EXPECT_TRUE(range.isSatisfiable);
+    EXPECT_EQ(range.firstByte, 10u);
+    EXPECT_EQ(range.lastByte, 999u);
+}
+
+TEST(ParseByteRange, ParsesSuffixRanges)
+{
+    const ParsedRange lastBytes = Parse("bytes=-100", 1000);
+    ASSERT_TRUE(lastBytes.isParsed);
+    EXPECT_TRUE(lastBytes.isSatisfiable);
+    EXPECT_EQ(lastBytes.firstByte, 900u);
+    EXPECT_EQ(lastBytes.lastByte, 999u);
+
+    /** A suffix longer than the file selects all of it. */
+    const ParsedRange wholeFile = Parse("bytes=-5000", 1000);
+    ASSERT_TRUE(wholeFile.isParsed);
+    EXPECT_TRUE(wholeFile.isSatisfiable);
+    EXPECT_EQ(wholeFile.firstByte, 0u);
+    EXPECT_EQ(wholeFile.lastByte, 999u);
+}
+
+TEST(ParseByteRange, MarksRangesThatSelectNothingUnsatisfiable)
+{
+    EXPECT_FALSE(Parse("bytes=1000-", 1000).isSatisfiable);
+    EXPECT_FALSE(Parse("bytes=1000-2000", 1000).isSatisfiable);
+    EXPECT_FALSE(Parse("bytes=50-10", 1000).isSatisfiable);
+    EXPECT_FALSE(Parse("bytes=-0", 1000).isSatisfiable);
+    EXPECT_FALSE(Parse("bytes=-10", 0).isSatisfiable);
+    EXPECT_FALSE(Parse("bytes=0-", 0).isSatisfiable);
+
+    EXPECT_TRUE(Parse("bytes=1000-", 1000).isParsed);
+    EXPECT_TRUE(Parse("bytes=-10", 0).isParsed);
+}
+
+TEST(ParseByteRange, AcceptsCaseAndWhitespaceVariations)
+{
+    const ParsedRange range = Parse(" BYTES = 1 - 2 ", 1000);
+    ASSERT_TRUE(range.isParsed);
+    EXPECT_EQ(range.firstByte, 1u);
+    EXPECT_EQ(range.lastByte, 2u);
+}
+
+TEST(ParseByteRange, RejectsHeadersServedAsAWholeFile)
+{
+    EXPECT_FALSE(Parse("bytes=0-1,5-6", 1000).isParsed);
+    EXPECT_FALSE(Parse("items=0-1", 1000).isParsed);
+    EXPECT_FALSE(Parse("bytes=-", 1000).isParsed);
+    EXPECT_FALSE(Parse("bytes=a-b", 1000).isParsed);
+    EXPECT_FALSE(Parse("", 1000).isParsed);
+    EXPECT_FALSE(Parse("bytes=99999999999999999999999999-", 1000).isParsed);
+}
@@ -0,0 +1,161 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "cdp_send_queue.h"
+#include <future>
+#include <string>
+
+using namespace std::chrono_literals;
+
+/**
+ * The queue is attached to a client that never connects, its io context is only run when a test polls it. 
+ * Every frame fails to send, which still empties the queue like a successful write would.
+ */
+class CdpSendQueueTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        m_client.init_asio();
+        CdpSendQueue::get().Attach(&m_client, websocketpp::connection_hdl());
+        m_baseline = CdpSendQueue::get().GetMetrics();
+    }
+
+    void TearDown() override
+    {
+        CdpSendQueue::get().Detach();
+        RunQueuedDrains();
+    }
+
+    void RunQueuedDrains()
+    {
+        m_client.get_io_service().restart();
+        m_client.get_io_service().poll();
+    }
+
+    /** A counter of the queue's metrics, relative to the start of the test. */
+    unsigned long long Counter(const char* name) const
+    {
+        return CdpSendQueue::get().GetMetrics()[name].get<unsigned long long>() - m_baseline[name].get<unsigned long long>();
+    }
+
+    CdpSendQueue::Client m_client;
+    nlohmann::json m_baseline;
+};
+
+TEST_F(CdpSendQueueTest, SendsQueuedFramesInOneDrain)
+{
+    for (int i = 0; i < 10; i++)
+    {
+        ASSERT_TRUE(CdpSendQueue::get().Enqueue("{\"id\":1}"));
+    }
+    EXPECT_EQ(CdpSendQueue::get().GetMetrics()["depth"], 10);
+
+    RunQueuedDrains();
+
+    EXPECT_EQ(CdpSendQueue::get().GetMetrics()["depth"], 0);
+    EXPECT_EQ(CdpSendQueue::get().GetMetrics()["queuedBytes"], 0);
+    EXPECT_GE(CdpSendQueue::get().GetMetrics()["largestBatch"], 10);
+    EXPECT_EQ(Counter("sentFrames") + Counter("sendErrors"), 10u);
+}
+
+TEST_F(CdpSendQueueTest, AcceptsFramesAboveTheBoundOnTheIoThread)
+{
+    /** The test thread attached the queue, so it's the io thread and must never wait on itself. */
+    for (int i = 0; i < 4096; i++)
+    {
+        ASSERT_TRUE(CdpSendQueue::get().Enqueue("{}"));
+    }
+    EXPECT_EQ(Counter("overflowFrames"), 0u);
+
+    EXPECT_TRUE(CdpSendQueue::get().Enqueue("{}"));
+    EXPECT_EQ(Counter("overflowFrames"), 1u);
+    EXPECT_EQ(Counter("blockedEnqueues"), 0u);
+}
+
+TEST_F(CdpSendQueueTest, BlocksOtherThreadsUntilTheQueueDrains)
+{
+    for (int i = 0; i < 4096; i++)
+    {
+        ASSERT_TRUE(CdpSendQueue::get().Enqueue("{}"));
+    }
+
+    std::future<bool> blockedEnqueue = std::async(std::launch::async, [] { return CdpSendQueue::get().Enqueue("{}"); });
+    EXPECT_EQ(blockedEnqueue.wait_for(100ms), std::future_status::timeout);
+
+    RunQueuedDrains();
+
+    ASSERT_EQ(blockedEnqueue.wait_for(2s), std::future_status::ready);
+    EXPECT_TRUE(blockedEnqueue.get());
+    EXPECT_EQ(Counter("blockedEnqueues"), 1u);
+    EXPECT_EQ(Counter("rejectedFrames"), 0u);
+}
+
+TEST_F(CdpSendQueueTest, BoundsTheQueuedBytes)
+{
+    const std::string largeFrame(48 * 1024 * 1024, 'x');
+    ASSERT_TRUE(CdpSendQueue::get().Enqueue(largeFrame));
+
+    std::future<bool> blockedEnqueue = std::async(std::launch::async, [&] { return CdpSendQueue::get().Enqueue(largeFrame); });
+    EXPECT_EQ(blockedEnqueue.wait_for(100ms), std::future_status::timeout);
+
+    RunQueuedDrains();
+
+    ASSERT_EQ(blockedEnqueue.wait_for(2s), std::future_status::ready);
+    EXPECT_TRUE(blockedEnqueue.get());
+}
+
+TEST_F(CdpSendQueueTest, LetsAFrameLargerThanTheBoundThroughOnItsOwn)
+{
+    std::future<bool> largeEnqueue = std::async(std::launch::async, [] { return CdpSendQueue::get().Enqueue(std::string(65 * 1024 * 1024, 'x')); });
+
+    ASSERT_EQ(largeEnqueue.wait_for(2s), std::future_status::ready);
+    EXPECT_TRUE(largeEnqueue.get());
+    EXPECT_EQ(Counter("blockedEnqueues"), 0u);
+}
+
+TEST_F(CdpSendQueueTest, ReleasesWaitingThreadsOnDetach)
+{
+    for (int i = 0; i < 4096; i++)
+    {
+        ASSERT_TRUE(CdpSendQueue::get().Enqueue("{}"));
+    }
+
+    std::future<bool> blockedEnqueue = std::async(std::launch::async, [] { return CdpSendQueue::get().Enqueue("{}"); });
+    EXPECT_EQ(blockedEnqueue.wait_for(100ms), std::future_status::timeout);
+
+    CdpSendQueue::get().Detach();
+
+    ASSERT_EQ(blockedEnqueue.wait_for(2s), std::future_status::ready);
+    EXPECT_FALSE(blockedEnqueue.get());
+    EXPECT_FALSE(CdpSendQueue::get().Enqueue("{}"));
+    EXPECT_EQ(CdpSendQueue::get().GetMetrics()["depth"], 0);
+}
@@ -0,0 +1,236 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#endif
+
+#include <gtest/gtest.h>
+#include "debugger_discovery.h"
+#include "locals.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <filesystem>
+
+/** Discovery watches `<steam>/config/htmlcache` for CEF's active port file, the tests get a Steam directory of their own. */
+std::filesystem::path SystemIO::GetSteamPath()
+{
+    static const std::filesystem::path steamPath = [] {
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "millennium_debugger_discovery_test";
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path / "config" / "htmlcache");
+        return path;
+    }();
+    return steamPath;
+}
+
+std::string GetEnv(std::string key)
+{
+    const char* value = std::getenv(key.c_str());
+    return value ? value : std::string();
+}
+
+namespace
+{
+    #ifdef _WIN32
+    using NativeSocket = SOCKET;
+    void CloseSocket(NativeSocket socket) { closesocket(socket); }
+    #else
+    using NativeSocket = int;
+    void CloseSocket(NativeSocket socket) { close(socket); }
+    #endif
+
+    constexpr const char* g_versionInfo = R"({"webSocketDebuggerUrl":"ws://127.0.0.1/devtools/browser/test"})";
+
+    /**
+     * Stands in for CEF's debugger: the port is reserved right away but refuses connections until Listen, 
+     * after which `/json/version` is answered.
+     */
+    class FakeDebugger
+    {
+    public:
+        FakeDebugger()
+        {
+            DebuggerDiscovery::get(); /** Sets up winsock. */
+
+            m_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+            sockaddr_in address = {};
+            address.sin_family      = AF_INET;
+            address.sin_port        = 0;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+            socklen_t addressLength = sizeof(address);
+            getsockname(m_socket, reinterpret_cast<sockaddr*>(&address), &addressLength);
+            m_port = ntohs(address.sin_port);
+        }
+
+        ~FakeDebugger()
+        {
+            m_isStopping = true;
+
+            if (m_server.joinable())
+            {
+                /** Wakes the blocked accept. */
+                Connect();
+                m_server.join();
+            }
+            CloseSocket(m_socket);
+        }
+
+        unsigned short Port() const { return m_port; }
+
+        void Listen()
+        {
+            listen(m_socket, 16);
+            m_server = std::thread([this] { Serve(); });
+        }
+
+    private:
+        void Connect()
+        {
+            const NativeSocket client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+            sockaddr_in address = {};
+            address.sin_family      = AF_INET;
+            address.sin_port        = htons(m_port);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+            CloseSocket(client);
+        }
+
+        void Serve()
+        {
+            while (!m_isStopping)
+            {
+                const NativeSocket client = accept(m_socket, nullptr, nullptr);
+
+                char request[4096];
+                const auto received = recv(client, request, sizeof(request), 0);
+
+                /** Port probes connect and hang up without sending anything. */
+                if (received > 0)
+                {
+                    const std::string body = g_versionInfo;
+                    const std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) 
+                        + "\r\nConnection: close\r\n\r\n" + body;
+
+                    send(client, response.data(), static_cast<int>(response.size()), 0);
+                }
+                CloseSocket(client);
+            }
+        }
+
+        NativeSocket m_socket;
+        unsigned short m_port = 0;
+        std::atomic<bool> m_isStopping { false };
+        std::thread m_server;
+    };
+
+    void WriteActivePort(unsigned short port)
+    {
+        std::ofstream(SystemIO::GetSteamPath() / "config" / "htmlcache" / "DevToolsActivePort", std::ios::trunc) << port << "\n/devtools/browser/test\n";
+    }
+}
+
+TEST(DebuggerDiscovery, FindsARunningDebugger)
+{
+    FakeDebugger debugger;
+    debugger.Listen();
+
+    const auto versionInfo = DebuggerDiscovery::get().WaitForDebugger(debugger.Port());
+
+    ASSERT_TRUE(versionInfo.has_value());
+    EXPECT_EQ(*versionInfo, g_versionInfo);
+}
+
+TEST(DebuggerDiscovery, WakesUpWhenTheActivePortIsWritten)
+{
+    FakeDebugger debugger;
+    const auto startDelay = std::chrono::milliseconds(1300);
+
+    /** Long enough for the backoff to reach its cap, a probe on its own would only find the port up to 500 ms late. */
+    std::thread starter([&debugger, startDelay] {
+        std::this_thread::sleep_for(startDelay);
+        debugger.Listen();
+        WriteActivePort(debugger.Port());
+    });
+
+    const auto wakeupsBefore = DebuggerDiscovery::get().GetMetrics()["activePortWakeups"].get<uint64_t>();
+    const auto startTime = std::chrono::steady_clock::now();
+
+    const auto versionInfo = DebuggerDiscovery::get().WaitForDebugger(debugger.Port());
+
+    const auto elapsed = std::chrono::steady_clock::now() - startTime;
+    starter.join();
+
+    ASSERT_TRUE(versionInfo.has_value());
+    EXPECT_EQ(*versionInfo, g_versionInfo);
+    EXPECT_GE(elapsed, startDelay);
+
+    const auto metrics = DebuggerDiscovery::get().GetMetrics();
+    EXPECT_GE(metrics["lastDiscoveryMs"].get<long long>(), startDelay.count());
+
+    /** On Windows the file lives in the user's real Steam cache under LOCALAPPDATA, which the test doesn't write to. */
+    #ifndef _WIN32
+    if (metrics["watchingActivePort"].get<bool>())
+    {
+        EXPECT_GT(metrics["activePortWakeups"].get<uint64_t>(), wakeupsBefore);
+        EXPECT_LT(elapsed, startDelay + std::chrono::milliseconds(250));
+    }
+    #endif
+}
+
+TEST(DebuggerDiscovery, RecordsTheFirstConnectionOnce)
+{
+    FakeDebugger debugger;
+    debugger.Listen();
+
+    ASSERT_TRUE(DebuggerDiscovery::get().WaitForDebugger(debugger.Port()).has_value());
+
+    DebuggerDiscovery::get().OnConnected();
+    const auto timeToFirstConnect = DebuggerDiscovery::get().GetMetrics()["timeToFirstConnectMs"].get<long long>();
+    EXPECT_GE(timeToFirstConnect, 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    DebuggerDiscovery::get().OnConnected();
+    EXPECT_EQ(DebuggerDiscovery::get().GetMetrics()["timeToFirstConnectMs"].get<long long>(), timeToFirstConnect);
+}
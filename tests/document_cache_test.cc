@@ -0,0 +1,177 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "document_cache.h"
+#include "locals.h"
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <filesystem>
+
+/** The cache watches `<steam>/steamui`, the tests get a Steam directory of their own. */
+std::filesystem::path SystemIO::GetSteamPath()
+{
+    static const std::filesystem::path steamPath = [] {
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "millennium_document_cache_test";
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path / "steamui");
+        return path;
+    }();
+    return steamPath;
+}
+
+namespace
+{
+    unsigned long long g_hookGeneration = 0;
+
+    /** Starts every test with an empty cache, patched against a hook generation of its own. */
+    class DocumentCacheTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            DocumentCache::get().Clear();
+            m_hookGeneration = ++g_hookGeneration;
+
+            /** The cache adopts a new generation on lookup, as every insert is preceded by one. */
+            Get("", "");
+        }
+
+        std::shared_ptr<const std::string> Insert(const std::string& url, const std::string& body, const std::string& patchedBody)
+        {
+            auto patched = std::make_shared<const std::string>(patchedBody);
+            DocumentCache::get().Insert(DocumentCache::MakeKey(url, body, true, *m_shim), m_hookGeneration, body, m_shim, patched);
+            return patched;
+        }
+
+        std::shared_ptr<const std::string> Get(const std::string& url, const std::string& body)
+        {
+            return DocumentCache::get().Get(DocumentCache::MakeKey(url, body, true, *m_shim), m_hookGeneration, body, *m_shim);
+        }
+
+        unsigned long long m_hookGeneration = 0;
+        std::shared_ptr<const std::string> m_shim = std::make_shared<const std::string>("<script>shim</script>");
+    };
+}
+
+TEST_F(DocumentCacheTest, ServesTheSamePatchedBody)
+{
+    const auto patchedBody = Insert("https://steamloopback.host/index.html", "body", "patched");
+
+    EXPECT_EQ(Get("https://steamloopback.host/index.html", "body"), patchedBody);
+    EXPECT_EQ(Get("https://steamloopback.host/library.html", "body"), nullptr);
+    EXPECT_EQ(Get("https://steamloopback.host/index.html", "other"), nullptr);
+}
+
+TEST_F(DocumentCacheTest, KeysIncludeTheUrlAndBodyLength)
+{
+    EXPECT_NE(DocumentCache::MakeKey("a", "body", true, "shim"), DocumentCache::MakeKey("b", "body", true, "shim"));
+    EXPECT_NE(DocumentCache::MakeKey("a", "body", true, "shim"), DocumentCache::MakeKey("a", "body", false, "shim"));
+    EXPECT_NE(DocumentCache::MakeKey("a", "body", true, "shim"), DocumentCache::MakeKey("a", "body", true, "shin"));
+    EXPECT_NE(DocumentCache::MakeKey("a", "body", true, "shim").find("|4:"), std::string::npos);
+}
+
+TEST_F(DocumentCacheTest, VerifiesHitsAgainstTheStoredBodyAndShim)
+{
+    /** Entries under the same key, as if the hashes collided. */
+    const std::string key = DocumentCache::MakeKey("https://steamloopback.host/index.html", "body", true, *m_shim);
+    DocumentCache::get().Insert(key, m_hookGeneration, "body", m_shim, std::make_shared<const std::string>("patched"));
+
+    EXPECT_EQ(DocumentCache::get().Get(key, m_hookGeneration, "bodz", *m_shim), nullptr);
+    EXPECT_EQ(DocumentCache::get().Get(key, m_hookGeneration, "body", "<script>shin</script>"), nullptr);
+
+    /** A rebuilt shim with the same contents is still a hit. */
+    EXPECT_NE(DocumentCache::get().Get(key, m_hookGeneration, "body", std::string(*m_shim)), nullptr);
+}
+
+TEST_F(DocumentCacheTest, ClearsOnANewHookGeneration)
+{
+    Insert("https://steamloopback.host/index.html", "body", "patched");
+    const std::string key = DocumentCache::MakeKey("https://steamloopback.host/index.html", "body", true, *m_shim);
+
+    EXPECT_EQ(DocumentCache::get().Get(key, m_hookGeneration + 1, "body", *m_shim), nullptr);
+    EXPECT_EQ(DocumentCache::get().GetStats().entries, 0u);
+
+    /** Patched against the replaced hook list, it's not cached. */
+    DocumentCache::get().Insert(key, m_hookGeneration, "body", m_shim, std::make_shared<const std::string>("patched"));
+    EXPECT_EQ(DocumentCache::get().GetStats().entries, 0u);
+}
+
+TEST_F(DocumentCacheTest, EvictsTheLeastRecentlyUsedAboveTheEntryCap)
+{
+    for (int i = 0; i < 200; i++)
+    {
+        Insert("https://steamloopback.host/" + std::to_string(i), "body", "patched");
+
+        /** Keeps the first document the most recently used. */
+        Get("https://steamloopback.host/0", "body");
+    }
+
+    const DocumentCache::Stats stats = DocumentCache::get().GetStats();
+    EXPECT_EQ(stats.entries, 128u);
+    EXPECT_NE(Get("https://steamloopback.host/0", "body"), nullptr);
+    EXPECT_EQ(Get("https://steamloopback.host/1", "body"), nullptr);
+    EXPECT_NE(Get("https://steamloopback.host/199", "body"), nullptr);
+}
+
+TEST_F(DocumentCacheTest, CountsTheStoredBodyTowardsTheByteCap)
+{
+    const std::string body(6 * 1024 * 1024, 'b');
+    const std::string patchedBody(6 * 1024 * 1024, 'p');
+
+    for (int i = 0; i < 4; i++)
+    {
+        Insert("https://steamloopback.host/" + std::to_string(i), body, patchedBody);
+    }
+
+    const DocumentCache::Stats stats = DocumentCache::get().GetStats();
+    EXPECT_LE(stats.bytes, 32u * 1024 * 1024);
+    EXPECT_EQ(stats.entries, 2u);
+    EXPECT_EQ(Get("https://steamloopback.host/0", body), nullptr);
+    EXPECT_NE(Get("https://steamloopback.host/3", body), nullptr);
+}
+
+TEST_F(DocumentCacheTest, ClearsWhenSteamUiIsUpdated)
+{
+    Insert("https://steamloopback.host/index.html", "body", "patched");
+    ASSERT_NE(Get("https://steamloopback.host/index.html", "body"), nullptr);
+
+    std::ofstream(SystemIO::GetSteamPath() / "steamui" / "update.txt") << "update";
+
+    /** Noticed by the watcher where there is one, by the directory's write time otherwise. */
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (Get("https://steamloopback.host/index.html", "body") != nullptr && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    EXPECT_EQ(Get("https://steamloopback.host/index.html", "body"), nullptr);
+}
@@ -0,0 +1,135 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "hook_matcher.h"
+#include <string>
+#include <vector>
+
+TEST(HookMatcherLiteralPrefix, StopsAtTheFirstMetacharacter)
+{
+    EXPECT_EQ(HookMatcher::LiteralPrefix("https://steamloopback.host/index.html"), "https://steamloopback");
+    EXPECT_EQ(HookMatcher::LiteralPrefix("^https://store.steampowered.com/app/.*"), "https://store");
+    EXPECT_EQ(HookMatcher::LiteralPrefix("https://example.com/(a|b)"), "https://example");
+}
+
+TEST(HookMatcherLiteralPrefix, KeepsEscapedPunctuation)
+{
+    EXPECT_EQ(HookMatcher::LiteralPrefix("https://steamloopback\\.host/.*"), "https://steamloopback.host/");
+    EXPECT_EQ(HookMatcher::LiteralPrefix("a\\/b\\d+"), "a/b");
+}
+
+TEST(HookMatcherLiteralPrefix, DropsOptionalAndRepeatedLiterals)
+{
+    EXPECT_EQ(HookMatcher::LiteralPrefix("https?://"), "http");
+    EXPECT_EQ(HookMatcher::LiteralPrefix("ab*c"), "a");
+    EXPECT_EQ(HookMatcher::LiteralPrefix("abc{2}"), "ab");
+}
+
+TEST(HookMatcherLiteralPrefix, HasNoPrefixForAlternationsAndWildcards)
+{
+    EXPECT_EQ(HookMatcher::LiteralPrefix("https://a.com/.*|https://b.com/.*"), "");
+    EXPECT_EQ(HookMatcher::LiteralPrefix(".*"), "");
+    EXPECT_EQ(HookMatcher::LiteralPrefix("[ab]c"), "");
+}
+
+TEST(HookMatcherLiteralPrefix, IgnoresAlternationsInGroupsAndClasses)
+{
+    EXPECT_EQ(HookMatcher::LiteralPrefix("https://x.com/(a|b)"), "https://x");
+    EXPECT_EQ(HookMatcher::LiteralPrefix("abc[|]"), "abc");
+}
+
+TEST(HookMatcher, MatchesInRegistrationOrder)
+{
+    HookMatcher matcher;
+    matcher.Compile({
+        "https://store\\.steampowered\\.com/.*",
+        ".*",
+        "https://steamloopback\\.host/index\\.html",
+        "https://store\\.steampowered\\.com/app/.*",
+        ".*"
+    });
+
+    EXPECT_EQ(matcher.Match("https://store.steampowered.com/app/10"), (std::vector<size_t>{ 0, 1, 3, 4 }));
+    EXPECT_EQ(matcher.Match("https://steamloopback.host/index.html"), (std::vector<size_t>{ 1, 2, 4 }));
+    EXPECT_EQ(matcher.Match("https://steamloopback.host/index.htm"), (std::vector<size_t>{ 1, 4 }));
+}
+
+TEST(HookMatcher, RequiresAFullMatch)
+{
+    HookMatcher matcher;
+    matcher.Compile({ "https://steamloopback\\.host/index\\.html" });
+
+    EXPECT_TRUE(matcher.Match("https://steamloopback.host/index.html?x=1").empty());
+    EXPECT_TRUE(matcher.Match("https://steamloopback.host/").empty());
+}
+
+TEST(HookMatcher, EvaluatesPatternsWithoutAPrefixAtTheRoot)
+{
+    HookMatcher matcher;
+    matcher.Compile({ "https://a\\.com/.*|https://b\\.com/.*", "https://c\\.com/.*" });
+
+    EXPECT_EQ(matcher.Match("https://b.com/x"), (std::vector<size_t>{ 0 }));
+    EXPECT_EQ(matcher.Match("https://c.com/x"), (std::vector<size_t>{ 1 }));
+    EXPECT_TRUE(matcher.Match("https://d.com/x").empty());
+}
+
+TEST(HookMatcher, SkipsInvalidPatterns)
+{
+    HookMatcher matcher;
+    matcher.Compile({ "https://a\\.com/(", ".*" });
+
+    EXPECT_EQ(matcher.Match("https://a.com/("), (std::vector<size_t>{ 1 }));
+}
+
+TEST(HookMatcher, RecompilingClearsTheMemo)
+{
+    HookMatcher matcher;
+    matcher.Compile({ "https://a\\.com/.*" });
+    ASSERT_EQ(matcher.Match("https://a.com/x"), (std::vector<size_t>{ 0 }));
+    ASSERT_EQ(matcher.Match("https://a.com/x"), (std::vector<size_t>{ 0 }));
+
+    matcher.Compile({ "https://b\\.com/.*", "https://a\\.com/x" });
+    EXPECT_EQ(matcher.Match("https://a.com/x"), (std::vector<size_t>{ 1 }));
+}
+
+TEST(HookMatcher, StaysCorrectOnceTheMemoIsFull)
+{
+    HookMatcher matcher;
+    matcher.Compile({ "https://a\\.com/[0-9]+", ".*" });
+
+    for (int i = 0; i < 2048; i++)
+    {
+        const std::vector<size_t> expected = i % 2 == 0 ? std::vector<size_t>{ 0, 1 } : std::vector<size_t>{ 1 };
+        const std::string url = i % 2 == 0 ? "https://a.com/" + std::to_string(i) : "https://a.com/x" + std::to_string(i);
+
+        ASSERT_EQ(matcher.Match(url), expected) << url;
+    }
+}
@@ -0,0 +1,135 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "html_injector.h"
+#include "encoding.h"
+#include <string>
+#include <string_view>
+
+namespace
+{
+    const std::string g_shim = "<script>shim</script>";
+
+    /** Feeds the base64 encoded document in chunks of the given size, 0 writes it at once. */
+    std::string InjectBase64(const std::string& document, size_t chunkSize)
+    {
+        const std::string base64 = Base64Encode(document);
+        HtmlHeadInjector injector(g_shim);
+        injector.Reserve(document.size());
+
+        if (chunkSize == 0)
+        {
+            injector.WriteBase64(base64);
+        }
+        else for (size_t offset = 0; offset < base64.size(); offset += chunkSize)
+        {
+            injector.WriteBase64(std::string_view(base64).substr(offset, chunkSize));
+        }
+        return Base64Decode(injector.Finish());
+    }
+
+    std::string InjectPlain(const std::string& document, size_t chunkSize)
+    {
+        HtmlHeadInjector injector(g_shim);
+
+        if (chunkSize == 0)
+        {
+            injector.Write(document);
+        }
+        else for (size_t offset = 0; offset < document.size(); offset += chunkSize)
+        {
+            injector.Write(std::string_view(document).substr(offset, chunkSize));
+        }
+        return Base64Decode(injector.Finish());
+    }
+}
+
+class HtmlHeadInjectorTest : public ::testing::TestWithParam<size_t> { };
+
+TEST_P(HtmlHeadInjectorTest, InjectsAfterTheHeadTag)
+{
+    EXPECT_EQ(InjectBase64("<html><head><title>x</title></head>", GetParam()), "<html><head>" + g_shim + "<title>x</title></head>");
+    EXPECT_EQ(InjectPlain("<html><head><title>x</title></head>", GetParam()), "<html><head>" + g_shim + "<title>x</title></head>");
+}
+
+TEST_P(HtmlHeadInjectorTest, MatchesTheHeadTagCaseInsensitively)
+{
+    EXPECT_EQ(InjectBase64("<HTML><HEAD>x", GetParam()), "<HTML><HEAD>" + g_shim + "x");
+    EXPECT_EQ(InjectBase64("<html><HeAd>x", GetParam()), "<html><HeAd>" + g_shim + "x");
+}
+
+TEST_P(HtmlHeadInjectorTest, SkipsAttributesIncludingQuotedBrackets)
+{
+    EXPECT_EQ(InjectBase64("<head lang=\"a>b\" data-x='>'>x", GetParam()), "<head lang=\"a>b\" data-x='>'>" + g_shim + "x");
+    EXPECT_EQ(InjectBase64("x<head/>y", GetParam()), "x<head/>" + g_shim + "y");
+}
+
+TEST_P(HtmlHeadInjectorTest, IgnoresTagsThatOnlyStartWithHead)
+{
+    EXPECT_EQ(InjectBase64("<header></header><head>x", GetParam()), "<header></header><head>" + g_shim + "x");
+    EXPECT_EQ(InjectBase64("<hea<head>x", GetParam()), "<hea<head>" + g_shim + "x");
+    EXPECT_EQ(InjectBase64("<<head>x", GetParam()), "<<head>" + g_shim + "x");
+}
+
+TEST_P(HtmlHeadInjectorTest, OnlyInjectsOnce)
+{
+    EXPECT_EQ(InjectBase64("<head></head><head>", GetParam()), "<head>" + g_shim + "</head><head>");
+}
+
+TEST_P(HtmlHeadInjectorTest, LeavesDocumentsWithoutAHeadTagUnchanged)
+{
+    EXPECT_EQ(InjectBase64("no head here", GetParam()), "no head here");
+    EXPECT_EQ(InjectBase64("<head", GetParam()), "<head");
+    EXPECT_EQ(InjectBase64("", GetParam()), "");
+}
+
+TEST_P(HtmlHeadInjectorTest, KeepsBinaryBytes)
+{
+    std::string document;
+    for (int byte = 0; byte < 256; byte++) document.push_back(static_cast<char>(byte));
+
+    EXPECT_EQ(InjectBase64(document, GetParam()), document);
+    EXPECT_EQ(InjectBase64(document + "<head>", GetParam()), document + "<head>" + g_shim);
+}
+
+/** Chunk sizes that split the base64 quads and the head tag at every possible offset. */
+INSTANTIATE_TEST_SUITE_P(ChunkSizes, HtmlHeadInjectorTest, ::testing::Values(0, 1, 2, 3, 4, 5, 7, 9));
+
+TEST(HtmlHeadInjector, ReportsWhetherItInjected)
+{
+    HtmlHeadInjector withHead(g_shim);
+    withHead.Write("<head>");
+    EXPECT_TRUE(withHead.HasInjected());
+
+    HtmlHeadInjector withoutHead(g_shim);
+    withoutHead.Write("<body>");
+    EXPECT_FALSE(withoutHead.HasInjected());
+}
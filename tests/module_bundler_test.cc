@@ -0,0 +1,174 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "module_bundler.h"
+#include "encoding.h"
+#include "hash.h"
+#include <fstream>
+#include <filesystem>
+
+namespace
+{
+    /** A directory of its own per test, the asset cache and the bundler are process wide singletons. */
+    std::filesystem::path MakeTestDirectory(const std::string& name)
+    {
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / ("millennium_module_bundler_test_" + name);
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        return directory;
+    }
+
+    std::string WriteModule(const std::filesystem::path& filePath, const std::string& source)
+    {
+        std::ofstream(filePath, std::ios::binary | std::ios::trunc) << source;
+        return filePath.string();
+    }
+
+    std::shared_ptr<AssetCache::Asset> LoadModule(const std::filesystem::path& filePath)
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        const std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        auto asset = std::make_shared<AssetCache::Asset>();
+        asset->body        = Base64Encode(source);
+        asset->contentHash = ContentHash(source.data(), source.size());
+        return asset;
+    }
+}
+
+TEST(ModuleBundler, BundlesModulesWithoutImports)
+{
+    EXPECT_TRUE(ModuleBundler::IsBundleable("export default function() { return 1; }"));
+    EXPECT_TRUE(ModuleBundler::IsBundleable("console.log('a'); const x = './notimport';"));
+    EXPECT_TRUE(ModuleBundler::IsBundleable("const reimported = 1; const fromage = 'x'; const a = { from: 1 };"));
+    EXPECT_TRUE(ModuleBundler::IsBundleable("const x = from + 'y';"));
+}
+
+TEST(ModuleBundler, KeepsModulesThatCanImportOutOfTheBundle)
+{
+    EXPECT_FALSE(ModuleBundler::IsBundleable("import x from './b.js'"));
+    EXPECT_FALSE(ModuleBundler::IsBundleable("import{x}from\"../b.js\""));
+    EXPECT_FALSE(ModuleBundler::IsBundleable("import './side.js'"));
+    EXPECT_FALSE(ModuleBundler::IsBundleable("await import( './b.js')"));
+    EXPECT_FALSE(ModuleBundler::IsBundleable("new URL('x', import.meta.url)"));
+    EXPECT_FALSE(ModuleBundler::IsBundleable("export * from \"./a.js\""));
+    EXPECT_FALSE(ModuleBundler::IsBundleable("export { a } from './a.js'"));
+}
+
+TEST(ModuleBundler, FindsRelativeStaticImportsInOrder)
+{
+    const std::string source =
+        "import a from './a.js';\n"
+        "import \"../side.js\";\n"
+        "export * from './b.js';\n"
+        "const lazy = import('./lazy.js');\n"
+        "import c from 'c';\n";
+
+    EXPECT_EQ(ModuleBundler::FindStaticImports(source), (std::vector<std::string> { "./a.js", "../side.js", "./b.js" }));
+}
+
+TEST(ModuleBundler, BundlesModulesInTheGivenOrder)
+{
+    const std::filesystem::path directory = MakeTestDirectory("order");
+    const std::string first      = WriteModule(directory / "first.js", "export const first = 1;\n");
+    const std::string standalone = WriteModule(directory / "standalone.js", "import x from './first.js';\n");
+    const std::string second     = WriteModule(directory / "second.js", "export const second = 2;\n");
+
+    const auto plan = ModuleBundler::get().Plan({ second, standalone, first }, LoadModule, 1, 0);
+
+    ASSERT_FALSE(plan.bundleKey.empty());
+    EXPECT_EQ(plan.standalonePaths, std::vector<std::string> { standalone });
+
+    const auto bundle = ModuleBundler::get().GetBundle(plan.bundleKey, LoadModule);
+    ASSERT_NE(bundle, nullptr);
+
+    const std::string bundleSource = Base64Decode(bundle->body);
+    const size_t secondPosition = bundleSource.find("export const second");
+    const size_t firstPosition  = bundleSource.find("export const first");
+
+    ASSERT_NE(secondPosition, std::string::npos);
+    ASSERT_NE(firstPosition, std::string::npos);
+    EXPECT_LT(secondPosition, firstPosition);
+    EXPECT_EQ(bundleSource.find("import x from"), std::string::npos);
+}
+
+TEST(ModuleBundler, LeavesASingleBundleableModuleStandalone)
+{
+    const std::filesystem::path directory = MakeTestDirectory("single");
+    const std::string only       = WriteModule(directory / "only.js", "export const only = 1;\n");
+    const std::string standalone = WriteModule(directory / "standalone.js", "import x from './only.js';\n");
+
+    const auto plan = ModuleBundler::get().Plan({ only, standalone }, LoadModule, 1, 0);
+
+    EXPECT_TRUE(plan.bundleKey.empty());
+    EXPECT_EQ(plan.standalonePaths, (std::vector<std::string> { only, standalone }));
+}
+
+TEST(ModuleBundler, KeysBundlesByGeneration)
+{
+    const std::filesystem::path directory = MakeTestDirectory("generation");
+    const std::string first  = WriteModule(directory / "first.js", "export const first = 1;\n");
+    const std::string second = WriteModule(directory / "second.js", "export const second = 2;\n");
+
+    const auto plan      = ModuleBundler::get().Plan({ first, second }, LoadModule, 1, 0);
+    const auto nextPlan  = ModuleBundler::get().Plan({ first, second }, LoadModule, 2, 0);
+    const auto epochPlan = ModuleBundler::get().Plan({ first, second }, LoadModule, 1, 1);
+
+    EXPECT_NE(plan.bundleKey, nextPlan.bundleKey);
+    EXPECT_NE(plan.bundleKey, epochPlan.bundleKey);
+}
+
+TEST(ModuleBundler, ServesRetiredBundlesUntilTheNextRetirement)
+{
+    const std::filesystem::path directory = MakeTestDirectory("retire");
+    const std::string first  = WriteModule(directory / "first.js", "export const first = 1;\n");
+    const std::string second = WriteModule(directory / "second.js", "export const second = 2;\n");
+
+    const auto plan = ModuleBundler::get().Plan({ first, second }, LoadModule, 7, 0);
+
+    /** Planning many other bundles doesn't evict it on its own. */
+    for (unsigned long long epoch = 1; epoch <= 100; epoch++)
+    {
+        ModuleBundler::get().Plan({ first, second }, LoadModule, 7, epoch);
+    }
+    EXPECT_NE(ModuleBundler::get().GetBundle(plan.bundleKey, LoadModule), nullptr);
+
+    ModuleBundler::get().RetireBundles();
+    EXPECT_NE(ModuleBundler::get().GetBundle(plan.bundleKey, LoadModule), nullptr);
+
+    ModuleBundler::get().RetireBundles();
+    EXPECT_EQ(ModuleBundler::get().GetBundle(plan.bundleKey, LoadModule), nullptr);
+}
+
+TEST(ModuleBundler, ReturnsNothingForUnknownKeys)
+{
+    EXPECT_EQ(ModuleBundler::get().GetBundle("unknown", LoadModule), nullptr);
+}
@@ -0,0 +1,96 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "pending_request_table.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+
+using namespace std::chrono_literals;
+using Table = PendingRequestTable<std::string>;
+
+TEST(PendingRequestTable, TakesARequestOnlyOnce)
+{
+    Table table(30s);
+    ASSERT_TRUE(table.Add(-1, "document"));
+
+    EXPECT_EQ(table.Take(-1), std::optional<std::string>("document"));
+    EXPECT_EQ(table.Take(-1), std::nullopt);
+    EXPECT_EQ(table.Size(), 0u);
+}
+
+TEST(PendingRequestTable, KeepsTheFirstRequestOfAMessageId)
+{
+    Table table(30s);
+
+    EXPECT_TRUE(table.Add(-1, "first"));
+    EXPECT_FALSE(table.Add(-1, "second"));
+    EXPECT_EQ(table.Take(-1), std::optional<std::string>("first"));
+}
+
+TEST(PendingRequestTable, ExpiresRequestsPastTheirDeadline)
+{
+    Table table(30s);
+    const Table::Clock::time_point now = Table::Clock::now();
+
+    table.Add(-1, "old", now - 31s);
+    table.Add(-2, "due", now - 30s);
+    table.Add(-3, "fresh", now);
+
+    std::vector<std::string> expiredRequests = table.TakeExpired(now);
+    std::sort(expiredRequests.begin(), expiredRequests.end());
+
+    EXPECT_EQ(expiredRequests, (std::vector<std::string>{ "due", "old" }));
+    EXPECT_EQ(table.Size(), 1u);
+    EXPECT_EQ(table.Take(-1), std::nullopt);
+    EXPECT_EQ(table.Take(-3), std::optional<std::string>("fresh"));
+}
+
+TEST(PendingRequestTable, TakesNothingBeforeTheTimeout)
+{
+    Table table(30s);
+    const Table::Clock::time_point now = Table::Clock::now();
+
+    table.Add(-1, "document", now);
+
+    EXPECT_TRUE(table.TakeExpired(now + 29s).empty());
+    EXPECT_EQ(table.TakeExpired(now + 30s).size(), 1u);
+}
+
+TEST(PendingRequestTable, MovesRequestsOut)
+{
+    PendingRequestTable<std::unique_ptr<int>> table(30s);
+    table.Add(-1, std::make_unique<int>(7));
+
+    const std::optional<std::unique_ptr<int>> request = table.Take(-1);
+    ASSERT_TRUE(request.has_value());
+    EXPECT_EQ(**request, 7);
+}
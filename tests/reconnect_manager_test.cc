@@ -0,0 +1,255 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "reconnect_manager.h"
+#include "loader.h"
+#include <cstdlib>
+
+/**
+ * The manager and the router are process wide singletons, every test declares state under keys and titles of 
+ * its own and looks for its calls among everything that was sent.
+ */
+static std::vector<nlohmann::json> g_sentCalls;
+
+bool Sockets::PostGlobal(nlohmann::json data)
+{
+    g_sentCalls.push_back(std::move(data));
+    return true;
+}
+
+/** Read by the static initializers in co_spawn.h, env.cc needs the paths the Millennium target is built with. */
+std::string GetEnv(std::string key)
+{
+    const char* value = std::getenv(key.c_str());
+    return value ? value : std::string();
+}
+
+namespace
+{
+    std::vector<nlohmann::json> FindSent(const std::string& method)
+    {
+        std::vector<nlohmann::json> calls;
+        for (const auto& call : g_sentCalls)
+        {
+            if (call.value("method", std::string()) == method) calls.push_back(call);
+        }
+        return calls;
+    }
+
+    void Reply(const nlohmann::json& call, nlohmann::json result)
+    {
+        CdpRouter::get().Route({ { "id", call["id"] }, { "result", std::move(result) } });
+    }
+
+    /** Answers the latest target listing with the given targets, titled and identified by the same name. */
+    void ListTargets(const std::vector<std::string>& targetTitles)
+    {
+        const auto listings = FindSent("Target.getTargets");
+        ASSERT_FALSE(listings.empty());
+
+        nlohmann::json targetInfos = nlohmann::json::array();
+        for (const auto& targetTitle : targetTitles)
+        {
+            targetInfos.push_back({ { "title", targetTitle }, { "targetId", targetTitle } });
+        }
+
+        g_sentCalls.clear();
+        Reply(listings.back(), { { "targetInfos", targetInfos } });
+    }
+
+    std::optional<nlohmann::json> FindAttach(const std::string& targetId)
+    {
+        for (const auto& call : FindSent("Target.attachToTarget"))
+        {
+            if (call["params"]["targetId"] == targetId) return call;
+        }
+        return std::nullopt;
+    }
+}
+
+class ReconnectManagerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        Disconnect();
+        g_sentCalls.clear();
+    }
+
+    void TearDown() override
+    {
+        Disconnect();
+    }
+
+    static void Disconnect()
+    {
+        if (ReconnectManager::get().GetMetrics()["connected"].get<bool>())
+        {
+            ReconnectManager::get().OnDisconnected();
+        }
+    }
+};
+
+TEST_F(ReconnectManagerTest, ReplaysGlobalStateOnEveryConnect)
+{
+    ReconnectManager::get().SetGlobalState("replay", { { "method", "Test.replay" } });
+    EXPECT_TRUE(g_sentCalls.empty());
+
+    for (int connection = 0; connection < 2; connection++)
+    {
+        g_sentCalls.clear();
+        ReconnectManager::get().OnConnected();
+        EXPECT_EQ(FindSent("Test.replay").size(), 1u);
+
+        ReconnectManager::get().OnDisconnected();
+    }
+}
+
+TEST_F(ReconnectManagerTest, SendsStateDeclaredWhileConnected)
+{
+    ReconnectManager::get().OnConnected();
+    g_sentCalls.clear();
+
+    ReconnectManager::get().SetGlobalState("live", { { "method", "Test.live" } });
+
+    ASSERT_EQ(g_sentCalls.size(), 1u);
+    EXPECT_EQ(g_sentCalls[0]["method"], "Test.live");
+}
+
+TEST_F(ReconnectManagerTest, ReplacesStateDeclaredUnderTheSameKey)
+{
+    ReconnectManager::get().SetGlobalState("replace", { { "method", "Test.replace" }, { "params", { { "version", 1 } } } });
+    ReconnectManager::get().SetGlobalState("replace", { { "method", "Test.replace" }, { "params", { { "version", 2 } } } });
+
+    ReconnectManager::get().OnConnected();
+
+    const auto calls = FindSent("Test.replace");
+    ASSERT_EQ(calls.size(), 1u);
+    EXPECT_EQ(calls[0]["params"]["version"], 2);
+}
+
+TEST_F(ReconnectManagerTest, PassesRepliesToTheDeclaringHandler)
+{
+    int replies = 0;
+    ReconnectManager::get().SetGlobalState("reply", { { "method", "Test.reply" } }, [&replies](const nlohmann::json& reply) {
+        if (!CdpRouter::IsConnectionLost(reply)) replies++;
+    });
+
+    ReconnectManager::get().OnConnected();
+
+    const auto calls = FindSent("Test.reply");
+    ASSERT_EQ(calls.size(), 1u);
+    EXPECT_NE(calls[0]["id"], 0);
+
+    Reply(calls[0], nlohmann::json::object());
+    EXPECT_EQ(replies, 1);
+}
+
+TEST_F(ReconnectManagerTest, AttachesTrackedTargetsOnEveryConnect)
+{
+    std::string attachedSession;
+    ReconnectManager::get().TrackTarget("AttachTarget", { "AttachBinding", [&attachedSession](const std::string& sessionId) { attachedSession = sessionId; } });
+    ReconnectManager::get().SetSessionState("AttachTarget", "script", { { "method", "Test.sessionScript" } });
+
+    for (const std::string sessionId : { "first", "second" })
+    {
+        g_sentCalls.clear();
+        ReconnectManager::get().OnConnected();
+        ListTargets({ "AttachTarget" });
+
+        const auto attach = FindAttach("AttachTarget");
+        ASSERT_TRUE(attach.has_value());
+
+        const auto exposed = FindSent("Target.exposeDevToolsProtocol");
+        ASSERT_FALSE(exposed.empty());
+        EXPECT_EQ(exposed.back()["params"]["bindingName"], "AttachBinding");
+
+        g_sentCalls.clear();
+        Reply(*attach, { { "sessionId", sessionId } });
+
+        EXPECT_EQ(attachedSession, sessionId);
+
+        const auto scripts = FindSent("Test.sessionScript");
+        ASSERT_EQ(scripts.size(), 1u);
+        EXPECT_EQ(scripts[0]["sessionId"], sessionId);
+
+        ReconnectManager::get().OnDisconnected();
+    }
+}
+
+TEST_F(ReconnectManagerTest, ListsTargetsAgainUntilTheyShowUp)
+{
+    ReconnectManager::get().TrackTarget("LateTarget", { "", nullptr });
+    ReconnectManager::get().OnConnected();
+
+    ListTargets({});
+    EXPECT_FALSE(FindSent("Target.getTargets").empty());
+    EXPECT_FALSE(FindAttach("LateTarget").has_value());
+
+    ListTargets({ "LateTarget" });
+    EXPECT_TRUE(FindAttach("LateTarget").has_value());
+}
+
+TEST_F(ReconnectManagerTest, FailsPendingRepliesOnDisconnect)
+{
+    bool isConnectionLost = false;
+    ReconnectManager::get().SetGlobalState("pending", { { "method", "Test.pending" } }, [&isConnectionLost](const nlohmann::json& reply) {
+        isConnectionLost = CdpRouter::IsConnectionLost(reply);
+    });
+
+    ReconnectManager::get().OnConnected();
+    ASSERT_EQ(FindSent("Test.pending").size(), 1u);
+
+    EXPECT_TRUE(ReconnectManager::get().OnDisconnected());
+    EXPECT_TRUE(isConnectionLost);
+}
+
+TEST_F(ReconnectManagerTest, BacksOffBetweenFailedAttempts)
+{
+    ReconnectManager::get().OnConnected();
+    EXPECT_TRUE(ReconnectManager::get().OnDisconnected());
+    EXPECT_EQ(ReconnectManager::get().NextRetryDelay(), std::chrono::milliseconds(0));
+
+    EXPECT_FALSE(ReconnectManager::get().OnDisconnected());
+    EXPECT_EQ(ReconnectManager::get().NextRetryDelay(), std::chrono::milliseconds(100));
+
+    EXPECT_FALSE(ReconnectManager::get().OnDisconnected());
+    EXPECT_EQ(ReconnectManager::get().NextRetryDelay(), std::chrono::milliseconds(200));
+
+    for (int attempt = 0; attempt < 20; attempt++)
+    {
+        ReconnectManager::get().OnDisconnected();
+    }
+    EXPECT_EQ(ReconnectManager::get().NextRetryDelay(), std::chrono::milliseconds(10000));
+
+    ReconnectManager::get().OnConnected();
+    EXPECT_EQ(ReconnectManager::get().NextRetryDelay(), std::chrono::milliseconds(0));
+}
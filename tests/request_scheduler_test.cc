@@ -0,0 +1,206 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "request_scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    /** Records the order tasks ran in, and lets a test hold the worker busy until it's released. */
+    class TaskLog
+    {
+    public:
+        RequestScheduler::Task Record(std::string name)
+        {
+            return [this, name = std::move(name)] {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_order.push_back(name);
+            };
+        }
+
+        RequestScheduler::Task Block()
+        {
+            return [this] {
+                m_started.set_value();
+                m_release.get_future().wait();
+            };
+        }
+
+        void WaitUntilBlocked() { m_started.get_future().wait(); }
+        void Release() { m_release.set_value(); }
+
+        std::vector<std::string> Order()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_order;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::vector<std::string> m_order;
+        std::promise<void> m_started, m_release;
+    };
+
+    /** Waits for the given number of tasks to complete, across all classes. */
+    void WaitForCompletedTasks(const RequestScheduler& scheduler, int taskCount)
+    {
+        const auto CompletedTasks = [&scheduler] {
+            const nlohmann::json metrics = scheduler.GetMetrics();
+            int completedTasks = 0;
+
+            for (const auto& classMetrics : metrics) completedTasks += classMetrics["completed"].get<int>();
+            return completedTasks;
+        };
+
+        while (CompletedTasks() < taskCount) std::this_thread::sleep_for(1ms);
+    }
+
+    RequestScheduler::Options SingleWorker(std::chrono::milliseconds agingThreshold)
+    {
+        RequestScheduler::Options options;
+        options.workerCount = 1;
+        options.agingThreshold = agingThreshold;
+        return options;
+    }
+}
+
+TEST(RequestScheduler, RunsHigherPriorityTasksFirst)
+{
+    TaskLog taskLog;
+    RequestScheduler scheduler(SingleWorker(10s));
+
+    scheduler.Enqueue(RequestScheduler::DOCUMENT, taskLog.Block());
+    taskLog.WaitUntilBlocked();
+
+    scheduler.Enqueue(RequestScheduler::PREFETCH, taskLog.Record("prefetch"));
+    scheduler.Enqueue(RequestScheduler::ASSET, taskLog.Record("asset"));
+    scheduler.Enqueue(RequestScheduler::DOCUMENT, taskLog.Record("document"));
+    scheduler.Enqueue(RequestScheduler::IPC, taskLog.Record("ipc"));
+
+    taskLog.Release();
+    WaitForCompletedTasks(scheduler, 5);
+
+    EXPECT_EQ(taskLog.Order(), (std::vector<std::string>{ "ipc", "document", "asset", "prefetch" }));
+}
+
+TEST(RequestScheduler, RunsTasksThatWaitedPastTheAgingThresholdFirst)
+{
+    TaskLog taskLog;
+    RequestScheduler scheduler(SingleWorker(20ms));
+
+    scheduler.Enqueue(RequestScheduler::DOCUMENT, taskLog.Block());
+    taskLog.WaitUntilBlocked();
+
+    scheduler.Enqueue(RequestScheduler::ASSET, taskLog.Record("asset"));
+    std::this_thread::sleep_for(100ms);
+    scheduler.Enqueue(RequestScheduler::IPC, taskLog.Record("ipc"));
+
+    taskLog.Release();
+    WaitForCompletedTasks(scheduler, 3);
+
+    EXPECT_EQ(taskLog.Order(), (std::vector<std::string>{ "asset", "ipc" }));
+    EXPECT_EQ(scheduler.GetMetrics()["Asset"]["aged"], 1);
+    EXPECT_EQ(scheduler.GetMetrics()["IPC"]["aged"], 0);
+}
+
+TEST(RequestScheduler, NeverAgesPrefetchesAhead)
+{
+    TaskLog taskLog;
+    RequestScheduler scheduler(SingleWorker(20ms));
+
+    scheduler.Enqueue(RequestScheduler::DOCUMENT, taskLog.Block());
+    taskLog.WaitUntilBlocked();
+
+    scheduler.Enqueue(RequestScheduler::PREFETCH, taskLog.Record("prefetch"));
+    std::this_thread::sleep_for(100ms);
+    scheduler.Enqueue(RequestScheduler::ASSET, taskLog.Record("asset"));
+
+    taskLog.Release();
+    WaitForCompletedTasks(scheduler, 3);
+
+    EXPECT_EQ(taskLog.Order(), (std::vector<std::string>{ "asset", "prefetch" }));
+}
+
+TEST(RequestScheduler, KeepsEachClassUnderItsInFlightLimit)
+{
+    RequestScheduler::Options options;
+    options.workerCount = 4;
+    options.inFlightLimits = { 1, 2, 2, 1 };
+
+    std::atomic<int> running { 0 }, peakRunning { 0 };
+    {
+        RequestScheduler scheduler(options);
+
+        for (int i = 0; i < 16; i++)
+        {
+            scheduler.Enqueue(RequestScheduler::IPC, [&] {
+                const int nowRunning = ++running;
+                peakRunning = std::max(peakRunning.load(), nowRunning);
+                std::this_thread::sleep_for(2ms);
+                running--;
+            });
+        }
+
+        WaitForCompletedTasks(scheduler, 16);
+    }
+
+    EXPECT_EQ(peakRunning, 1);
+}
+
+TEST(RequestScheduler, DropsTasksThatHaventStartedOnShutdown)
+{
+    TaskLog taskLog;
+    RequestScheduler scheduler(SingleWorker(10s));
+
+    scheduler.Enqueue(RequestScheduler::DOCUMENT, taskLog.Block());
+    taskLog.WaitUntilBlocked();
+    scheduler.Enqueue(RequestScheduler::ASSET, taskLog.Record("asset"));
+
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(20ms);
+        taskLog.Release();
+    });
+    scheduler.Shutdown();
+    releaser.join();
+
+    EXPECT_TRUE(taskLog.Order().empty());
+
+    /** Enqueued after shutdown, it never runs. */
+    scheduler.Enqueue(RequestScheduler::IPC, taskLog.Record("ipc"));
+    EXPECT_EQ(scheduler.GetMetrics()["IPC"]["depth"], 0);
+}
@@ -0,0 +1,158 @@
+/**
+ * ==================================================
+ *   _____ _ _ _             _                     
+ *  |     |_| | |___ ___ ___|_|_ _ _____           
+ *  | | | | | | | -_|   |   | | | |     |          
+ *  |_|_|_|_|_|_|___|_|_|_|_|_|___|_|_|_|          
+ * 
+ * ==================================================
+ * 
+ * Copyright (c) 2025 Project Millennium
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "response_patcher.h"
+#include "encoding.h"
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /** Every pattern enabled, as (position, pattern index) pairs. */
+    std::vector<std::pair<size_t, size_t>> FindAll(const std::vector<std::string>& patterns, const std::string& haystack)
+    {
+        PatternAutomaton automaton;
+        automaton.Compile(patterns);
+
+        std::vector<std::pair<size_t, size_t>> matches;
+        for (const PatternAutomaton::Match& match : automaton.FindAll(haystack, std::vector<bool>(patterns.size(), true)))
+        {
+            matches.emplace_back(match.position, match.patternIndex);
+        }
+        return matches;
+    }
+
+    using Matches = std::vector<std::pair<size_t, size_t>>;
+}
+
+TEST(PatternAutomaton, FindsEveryOccurrence)
+{
+    EXPECT_EQ(FindAll({ "ab" }, "ab ab xab"), (Matches{ { 0, 0 }, { 3, 0 }, { 7, 0 } }));
+    EXPECT_TRUE(FindAll({ "ab" }, "a b").empty());
+}
+
+TEST(PatternAutomaton, PrefersTheLeftmostMatch)
+{
+    /** "she" starts before "hers", so "hers" overlapping it is dropped. */
+    EXPECT_EQ(FindAll({ "he", "hers", "she" }, "ushers"), (Matches{ { 1, 2 } }));
+}
+
+TEST(PatternAutomaton, PrefersTheLongestMatchAtTheSamePosition)
+{
+    EXPECT_EQ(FindAll({ "he", "hers" }, "hers"), (Matches{ { 0, 1 } }));
+    EXPECT_EQ(FindAll({ "hers", "he" }, "hers he"), (Matches{ { 0, 0 }, { 5, 1 } }));
+}
+
+TEST(PatternAutomaton, DoesNotOverlapRepeatedPatterns)
+{
+    EXPECT_EQ(FindAll({ "aa" }, "aaaaa"), (Matches{ { 0, 0 }, { 2, 0 } }));
+}
+
+TEST(PatternAutomaton, FindsPatternsReachedThroughFailureLinks)
+{
+    /** "bc" is only found by following the failure link out of "abd". */
+    EXPECT_EQ(FindAll({ "abd", "bc" }, "abc"), (Matches{ { 1, 1 } }));
+    EXPECT_EQ(FindAll({ "abcd", "b" }, "abce"), (Matches{ { 1, 1 } }));
+}
+
+TEST(PatternAutomaton, SkipsDisabledPatterns)
+{
+    PatternAutomaton automaton;
+    automaton.Compile({ "hers", "he" });
+
+    const std::vector<PatternAutomaton::Match> matches = automaton.FindAll("hers", { false, true });
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].position, 0u);
+    EXPECT_EQ(matches[0].patternIndex, 1u);
+}
+
+TEST(PatternAutomaton, MatchesBinaryBytes)
+{
+    const std::string pattern("\x00\xff", 2);
+    const std::string haystack("a\x00\xff" "b", 4);
+
+    EXPECT_EQ(FindAll({ pattern }, haystack), (Matches{ { 1, 0 } }));
+}
+
+TEST(ResponsePatcher, ReplacesLeftmostLongestMatches)
+{
+    ResponsePatcher& patcher = ResponsePatcher::get();
+    const std::string urlPattern = "https://steamloopback\\.host/leftmost/.*\\.js";
+
+    const std::vector<unsigned long long> patchIds = {
+        patcher.AddPatch(urlPattern, "he", "HE"),
+        patcher.AddPatch(urlPattern, "hers", "[HERS]"),
+        patcher.AddPatch(urlPattern, "she", "<she>")
+    };
+
+    const std::shared_ptr<const std::string> patchedBody = patcher.Apply("https://steamloopback.host/leftmost/chunk.js", "ushers and he said hers", false);
+
+    ASSERT_NE(patchedBody, nullptr);
+    EXPECT_EQ(Base64Decode(*patchedBody), "u<she>rs and HE said [HERS]");
+
+    for (const unsigned long long patchId : patchIds) EXPECT_TRUE(patcher.RemovePatch(patchId));
+}
+
+TEST(ResponsePatcher, OnlyAppliesPatchesOfMatchingUrls)
+{
+    ResponsePatcher& patcher = ResponsePatcher::get();
+    const unsigned long long patchId = patcher.AddPatch("https://steamloopback\\.host/scoped/.*\\.js", "a", "b");
+
+    EXPECT_TRUE(patcher.HasPatchesFor("https://steamloopback.host/scoped/x.js"));
+    EXPECT_FALSE(patcher.HasPatchesFor("https://steamloopback.host/other/x.js"));
+    EXPECT_EQ(patcher.Apply("https://steamloopback.host/other/x.js", "a", false), nullptr);
+
+    /** Nothing to replace, the response is passed through. */
+    EXPECT_EQ(patcher.Apply("https://steamloopback.host/scoped/x.js", "c", false), nullptr);
+
+    EXPECT_TRUE(patcher.RemovePatch(patchId));
+    EXPECT_FALSE(patcher.RemovePatch(patchId));
+}
+
+TEST(ResponsePatcher, DecodesBase64Bodies)
+{
+    ResponsePatcher& patcher = ResponsePatcher::get();
+    const unsigned long long patchId = patcher.AddPatch("https://steamloopback\\.host/base64/.*", "find", "replaced");
+
+    const std::shared_ptr<const std::string> patchedBody = patcher.Apply("https://steamloopback.host/base64/x.css", Base64Encode(std::string("a find b")), true);
+
+    ASSERT_NE(patchedBody, nullptr);
+    EXPECT_EQ(Base64Decode(*patchedBody), "a replaced b");
+    EXPECT_TRUE(patcher.RemovePatch(patchId));
+}
+
+TEST(ResponsePatcher, RejectsInvalidPatches)
+{
+    EXPECT_THROW(ResponsePatcher::get().AddPatch("https://steamloopback\\.host/.*", "", "x"), std::invalid_argument);
+    EXPECT_THROW(ResponsePatcher::get().AddPatch("(", "a", "b"), std::regex_error);
+}